@@ -15,11 +15,11 @@ OPTS="$(grep -oE "arg *== *\"--.*\"" src/game/game_manager.cpp                 \
 
 echo "# Output of --help"
 grep -oE "<< \"  -., --[^ ]+" src/game/game_manager.cpp                        \
-  | sed 's#.\+-\(.\+\)$#\1#g' | diff <(echo "$OPTS") -
+  | sed 's#.\+, --\(.\+\)$#\1#g' | diff <(echo "$OPTS") -
 
 echo "# Man pages"
 grep -E "^.B \\\\-" mk/unix/stmeltdown.6                                       \
-  | sed 's#.*\\-\\-\([^ ]\+\).*#\1#g' | diff <(echo "$OPTS") -
+  | sed 's#.*\\-\\-\([^ ]\+\).*#\1#g;s#\\-#-#g' | diff <(echo "$OPTS") -
 
 echo "# Bash completion"
 grep -xE " *STM_ARGS\+=\('--.*'\)" mk/unix/bash_completion.sh                  \
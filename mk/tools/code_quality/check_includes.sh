@@ -74,7 +74,7 @@ for file in $(git ls-files src/*/); do
     fi
 
     # Dependency includes
-    if [ ! "$curr" = "" ] && [[ "${curr//\~/}" =~ ^(\"emscripten\.h\")?(\"physfs\.h\")?(\"SDL2/SDL\.h\")?(\"SDL2/SDL_image\.h\")?(\"SDL2/SDL_ttf\.h\")?$ ]]; then
+    if [ ! "$curr" = "" ] && [[ "${curr//\~/}" =~ ^(\<[a-z_/]+\.h\>)*(\"emscripten\.h\")?(\"physfs\.h\")?(\"SDL2/SDL\.h\")?(\"SDL2/SDL_image\.h\")?(\"SDL2/SDL_ttf\.h\")?$ ]]; then
       currnum=$(($currnum + 1))
       curr="$(echo "$fields" | cut -d '#' -f $currnum -s)"
     fi
@@ -159,7 +159,7 @@ for file in $(git ls-files src/*/); do
     fi
 
     # Dependency includes
-    if [ ! "$curr" = "" ] && [[ "${curr//\~/}" =~ ^(\"emscripten\.h\")?(\"physfs\.h\")?(\"SDL2/SDL\.h\")?(\"SDL2/SDL_image\.h\")?(\"SDL2/SDL_ttf\.h\")?$ ]]; then
+    if [ ! "$curr" = "" ] && [[ "${curr//\~/}" =~ ^(\<[a-z_/]+\.h\>)*(\"emscripten\.h\")?(\"physfs\.h\")?(\"SDL2/SDL\.h\")?(\"SDL2/SDL_image\.h\")?(\"SDL2/SDL_ttf\.h\")?$ ]]; then
       currnum=$(($currnum + 1))
       curr="$(echo "$fields" | cut -d '#' -f $currnum -s)"
     fi
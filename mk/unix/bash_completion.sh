@@ -6,7 +6,8 @@ _stmeltdown_completions()
   local word="${COMP_WORDS[$(($count - 1))]}"
 
   if [ "$(($count > 2))" = "1" ]; then
-    if [ "${COMP_WORDS[$(($count - 2))]}" = "--data" ]; then
+    if [ "${COMP_WORDS[$(($count - 2))]}" = "--data" ] ||
+       [ "${COMP_WORDS[$(($count - 2))]}" = "--validate-levels" ]; then
       COMPREPLY=($(compgen -d -- "$word"))
       return
     fi
@@ -18,8 +19,14 @@ _stmeltdown_completions()
   STM_ARGS+=('--data')
   #STM_ARGS+=('-h')
   STM_ARGS+=('--help')
+  #STM_ARGS+=('-m')
+  STM_ARGS+=('--max-fps')
   #STM_ARGS+=('-t')
   STM_ARGS+=('--test')
+  #STM_ARGS+=('-T')
+  STM_ARGS+=('--trace')
+  #STM_ARGS+=('-l')
+  STM_ARGS+=('--validate-levels')
   #STM_ARGS+=('-v')
   STM_ARGS+=('--version')
   COMPREPLY=($(compgen -W "${STM_ARGS[*]}" -- "$word"))
@@ -122,6 +122,14 @@ EditorCamera::update(float dt_sec)
                 + m_pos;
   m_current_zoom = (m_current_zoom - m_zoom) / std::pow(CAM_EXPONENT, dt_sec)
                  + m_zoom;
+
+  // The movement never ends on its own; stop it once it can't be seen anymore
+  if ((m_current_pos - m_pos).length() < 0.01f
+      && std::abs(m_current_zoom - m_zoom) < 0.0001f)
+  {
+    m_current_pos = m_pos;
+    m_current_zoom = m_zoom;
+  }
 }
 
 void
@@ -149,3 +157,10 @@ EditorCamera::get_zoom() const
 {
   return m_current_zoom;
 }
+
+/** Returns whether the camera has stopped moving towards its target. */
+bool
+EditorCamera::is_settled() const
+{
+  return m_current_pos == m_pos && m_current_zoom == m_zoom;
+}
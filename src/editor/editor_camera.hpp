@@ -32,6 +32,7 @@ public:
 
   const Vector& get_pos() const;
   float get_zoom() const;
+  bool is_settled() const;
 
 private:
   Vector m_current_pos;
@@ -0,0 +1,332 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "editor/editor_history.hpp"
+
+#include <stdexcept>
+
+const size_t EditorHistory::DEFAULT_MAX_BYTES = 16 * 1024 * 1024;
+
+EditorHistory::EditorHistory(size_t max_bytes) :
+  m_max_bytes(max_bytes),
+  m_bytes(0),
+  m_actions(),
+  m_position(0),
+  m_recording(false),
+  m_current(),
+  m_current_index()
+{
+}
+
+void
+EditorHistory::begin_action()
+{
+  if (m_recording)
+    end_action();
+
+  m_recording = true;
+}
+
+/**
+ * Closes the current action. Actions that didn't change anything are dropped.
+ * This discards the actions that could be redone.
+ */
+void
+EditorHistory::end_action()
+{
+  if (!m_recording)
+    return;
+
+  m_recording = false;
+  m_current_index.clear();
+
+  if (!changes_anything(m_current))
+  {
+    m_current = Action();
+    return;
+  }
+
+  while (m_actions.size() > m_position)
+  {
+    m_bytes -= get_size(m_actions.back());
+    m_actions.pop_back();
+  }
+
+  m_current.spans.shrink_to_fit();
+  m_current.runs.shrink_to_fit();
+  m_current.resizes.shrink_to_fit();
+
+  m_bytes += get_size(m_current);
+  m_actions.push_back(std::move(m_current));
+  m_position = m_actions.size();
+  m_current = Action();
+
+  enforce_budget();
+}
+
+/** Must be called after the tile was changed, between begin/end_action(). */
+void
+EditorHistory::record_tile(size_t x, size_t y, uint32_t old_id,
+                           uint32_t new_id)
+{
+  if (!m_recording)
+    throw std::runtime_error("Can't record a change outside of an action");
+
+  uint64_t key = static_cast<uint64_t>(x) << 32 | static_cast<uint32_t>(y);
+  auto it = m_current_index.find(key);
+
+  if (it != m_current_index.end())
+  {
+    m_current.spans[it->second].new_id = new_id;
+    return;
+  }
+
+  m_current_index[key] = m_current.spans.size();
+  m_current.spans.push_back({ static_cast<uint32_t>(x),
+                              static_cast<uint32_t>(y), 1, new_id, 1 });
+  m_current.runs.push_back({ 1, old_id });
+}
+
+/**
+ * Must be called after the tilemap was resized, between begin/end_action().
+ * Only growing resizes are supported, as undoing them loses no tile.
+ */
+void
+EditorHistory::record_resize(size_t old_width, size_t old_height,
+                             size_t new_width, size_t new_height, int off_x,
+                             int off_y, uint32_t fill)
+{
+  if (!m_recording)
+    throw std::runtime_error("Can't record a change outside of an action");
+
+  if (new_width < old_width || new_height < old_height || off_x < 0
+      || off_y < 0)
+  {
+    throw std::runtime_error("Can't record a resize that drops tiles");
+  }
+
+  // Coordinates recorded before this point don't match the new layout
+  m_current_index.clear();
+
+  m_current.resizes.push_back({ m_current.spans.size(),
+                                static_cast<uint32_t>(old_width),
+                                static_cast<uint32_t>(old_height),
+                                static_cast<uint32_t>(new_width),
+                                static_cast<uint32_t>(new_height),
+                                static_cast<int32_t>(off_x),
+                                static_cast<int32_t>(off_y), fill });
+}
+
+bool
+EditorHistory::can_undo() const
+{
+  return m_position > 0;
+}
+
+bool
+EditorHistory::can_redo() const
+{
+  return m_position < m_actions.size();
+}
+
+/**
+ * Reverts the last action on @p tilemap and on the editor's tilemap
+ * @p offset. Any action being recorded is closed first.
+ *
+ * @param on_fill, on_resize If set, called after each change to @p tilemap,
+ *                           so that data derived from it can be updated for
+ *                           as little as the action itself.
+ * @returns Whether there was an action to undo.
+ */
+bool
+EditorHistory::undo(Tilemap& tilemap, Vector& offset,
+                    const FillCallback& on_fill,
+                    const ResizeCallback& on_resize)
+{
+  end_action();
+
+  if (!can_undo())
+    return false;
+
+  const Action& action = m_actions[--m_position];
+  size_t r = action.resizes.size();
+  size_t run_end = action.runs.size();
+
+  for (size_t s = action.spans.size();; s--)
+  {
+    while (r > 0 && action.resizes[r - 1].span_index == s)
+      undo_resize(action.resizes[--r], tilemap, offset, on_resize);
+
+    if (s == 0)
+      break;
+
+    const SpanChange& span = action.spans[s - 1];
+    size_t run = run_end - span.run_count;
+    size_t x = span.x;
+
+    for (; run < run_end; run++)
+    {
+      tilemap.fill(x, span.y, action.runs[run].length, action.runs[run].id);
+
+      if (on_fill)
+        on_fill(x, span.y, action.runs[run].length, action.runs[run].id);
+
+      x += action.runs[run].length;
+    }
+
+    run_end -= span.run_count;
+  }
+
+  return true;
+}
+
+/**
+ * Applies again the last undone action.
+ *
+ * @param on_fill, on_resize See undo().
+ * @returns Whether there was an action to redo.
+ */
+bool
+EditorHistory::redo(Tilemap& tilemap, Vector& offset,
+                    const FillCallback& on_fill,
+                    const ResizeCallback& on_resize)
+{
+  end_action();
+
+  if (!can_redo())
+    return false;
+
+  const Action& action = m_actions[m_position++];
+  size_t r = 0;
+
+  for (size_t s = 0;; s++)
+  {
+    while (r < action.resizes.size() && action.resizes[r].span_index == s)
+      redo_resize(action.resizes[r++], tilemap, offset, on_resize);
+
+    if (s == action.spans.size())
+      break;
+
+    const SpanChange& span = action.spans[s];
+    tilemap.fill(span.x, span.y, span.length, span.new_id);
+
+    if (on_fill)
+      on_fill(span.x, span.y, span.length, span.new_id);
+  }
+
+  return true;
+}
+
+/** Forgets all actions, e. g. after another level was loaded. */
+void
+EditorHistory::clear()
+{
+  m_actions.clear();
+  m_position = 0;
+  m_bytes = 0;
+  m_recording = false;
+  m_current = Action();
+  m_current_index.clear();
+}
+
+/** Returns an estimate of the memory used by the recorded actions. */
+size_t
+EditorHistory::get_memory_usage() const
+{
+  return m_bytes;
+}
+
+void
+EditorHistory::set_max_bytes(size_t max_bytes)
+{
+  m_max_bytes = max_bytes;
+  enforce_budget();
+}
+
+size_t
+EditorHistory::get_size(const Action& action)
+{
+  return sizeof(Action)
+         + action.spans.capacity() * sizeof(SpanChange)
+         + action.runs.capacity() * sizeof(Run)
+         + action.resizes.capacity() * sizeof(ResizeChange);
+}
+
+/** Checks whether some tile was set to an ID different from its old one. */
+bool
+EditorHistory::changes_anything(const Action& action)
+{
+  if (!action.resizes.empty())
+    return true;
+
+  size_t run = 0;
+
+  for (const auto& span : action.spans)
+  {
+    for (uint32_t i = 0; i < span.run_count; i++)
+      if (action.runs[run + i].id != span.new_id)
+        return true;
+
+    run += span.run_count;
+  }
+
+  return false;
+}
+
+void
+EditorHistory::undo_resize(const ResizeChange& resize, Tilemap& tilemap,
+                           Vector& offset, const ResizeCallback& on_resize)
+{
+  tilemap.resize(resize.old_width, resize.old_height, -resize.off_x,
+                 -resize.off_y, resize.fill);
+
+  if (on_resize)
+    on_resize(resize.old_width, resize.old_height, -resize.off_x,
+              -resize.off_y, resize.fill);
+
+  offset -= Vector(static_cast<float>(resize.off_x),
+                   static_cast<float>(resize.off_y));
+}
+
+void
+EditorHistory::redo_resize(const ResizeChange& resize, Tilemap& tilemap,
+                           Vector& offset, const ResizeCallback& on_resize)
+{
+  // The tiles placed in the new area are restored by the tile changes which
+  // follow
+  tilemap.resize(resize.new_width, resize.new_height, resize.off_x,
+                 resize.off_y, resize.fill);
+
+  if (on_resize)
+    on_resize(resize.new_width, resize.new_height, resize.off_x,
+              resize.off_y, resize.fill);
+
+  offset += Vector(static_cast<float>(resize.off_x),
+                   static_cast<float>(resize.off_y));
+}
+
+/** Drops the oldest actions until the journal fits in its budget. */
+void
+EditorHistory::enforce_budget()
+{
+  // The last action is always kept, so that it can at least be undone
+  while (m_bytes > m_max_bytes && m_actions.size() > 1 && m_position > 1)
+  {
+    m_bytes -= get_size(m_actions.front());
+    m_actions.pop_front();
+    m_position--;
+  }
+}
@@ -0,0 +1,215 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_EDITOR_EDITORHISTORY_HPP
+#define HEADER_STM_EDITOR_EDITORHISTORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "level/tilemap.hpp"
+#include "util/vector.hpp"
+
+/**
+ * Undo/redo journal for the level editor. Instead of snapshots of the level,
+ * each action stores the tiles it changed (with their old and new IDs) and the
+ * resizes it did, so undoing or redoing an action costs as much as the action
+ * itself, whatever the size of the level.
+ *
+ * Changes are stored as horizontal spans of tiles set to the same ID, with the
+ * old IDs of the span run-length encoded, so that filling big areas stays
+ * compact.
+ *
+ * Changes are grouped in actions with begin_action() and end_action(); a whole
+ * stroke of the mouse is a single action, and a tile changed several times in
+ * an action is only stored once. When the journal grows past its memory
+ * budget, the oldest actions are dropped.
+ */
+class EditorHistory final
+{
+public:
+  static const size_t DEFAULT_MAX_BYTES;
+
+  /** Told about each Tilemap::fill() done when undoing or redoing */
+  typedef std::function<void(size_t x, size_t y, size_t length,
+                             uint32_t id)> FillCallback;
+  /** Told about each Tilemap::resize() done when undoing or redoing */
+  typedef std::function<void(size_t width, size_t height, int off_x,
+                             int off_y, uint32_t fill)> ResizeCallback;
+
+public:
+  EditorHistory(size_t max_bytes = DEFAULT_MAX_BYTES);
+
+  void begin_action();
+  void end_action();
+
+  void record_tile(size_t x, size_t y, uint32_t old_id, uint32_t new_id);
+  template<typename T>
+  void record_span(size_t x, size_t y, const T* old_ids, size_t length,
+                   uint32_t new_id);
+  template<typename T, typename U>
+  void record_row(size_t x, size_t y, const T* old_ids, const U* new_ids,
+                  size_t length);
+  void record_resize(size_t old_width, size_t old_height, size_t new_width,
+                     size_t new_height, int off_x, int off_y, uint32_t fill);
+
+  bool can_undo() const;
+  bool can_redo() const;
+  bool undo(Tilemap& tilemap, Vector& offset,
+            const FillCallback& on_fill = nullptr,
+            const ResizeCallback& on_resize = nullptr);
+  bool redo(Tilemap& tilemap, Vector& offset,
+            const FillCallback& on_fill = nullptr,
+            const ResizeCallback& on_resize = nullptr);
+
+  void clear();
+  size_t get_memory_usage() const;
+  void set_max_bytes(size_t max_bytes);
+
+private:
+  class SpanChange final
+  {
+  public:
+    uint32_t x;
+    uint32_t y;
+    uint32_t length;
+    uint32_t new_id;
+    /** Number of runs of old IDs of this span, in Action::runs */
+    uint32_t run_count;
+  };
+
+  class Run final
+  {
+  public:
+    uint32_t length;
+    uint32_t id;
+  };
+
+  class ResizeChange final
+  {
+  public:
+    /** Number of spans in the action before this resize */
+    size_t span_index;
+    uint32_t old_width;
+    uint32_t old_height;
+    uint32_t new_width;
+    uint32_t new_height;
+    int32_t off_x;
+    int32_t off_y;
+    uint32_t fill;
+  };
+
+  class Action final
+  {
+  public:
+    std::vector<SpanChange> spans;
+    std::vector<Run> runs;
+    std::vector<ResizeChange> resizes;
+  };
+
+private:
+  static size_t get_size(const Action& action);
+  static bool changes_anything(const Action& action);
+  static void undo_resize(const ResizeChange& resize, Tilemap& tilemap,
+                          Vector& offset, const ResizeCallback& on_resize);
+  static void redo_resize(const ResizeChange& resize, Tilemap& tilemap,
+                          Vector& offset, const ResizeCallback& on_resize);
+
+  void enforce_budget();
+
+private:
+  size_t m_max_bytes;
+  size_t m_bytes;
+  std::deque<Action> m_actions;
+  /** Index of the first action that can be redone */
+  size_t m_position;
+  bool m_recording;
+  Action m_current;
+  /** Position of single tiles in m_current.spans, since the last resize */
+  std::unordered_map<uint64_t, size_t> m_current_index;
+
+private:
+  EditorHistory(const EditorHistory&) = delete;
+  EditorHistory& operator=(const EditorHistory&) = delete;
+};
+
+/**
+ * Records that the @p length tiles from (@p x, @p y) are about to be set to
+ * @p new_id. Must be called before the change, with @p old_ids pointing to the
+ * current tiles, between begin_action() and end_action().
+ */
+template<typename T>
+void
+EditorHistory::record_span(size_t x, size_t y, const T* old_ids, size_t length,
+                           uint32_t new_id)
+{
+  if (!m_recording)
+    throw std::runtime_error("Can't record a change outside of an action");
+
+  if (length == 0)
+    return;
+
+  // Single tiles recorded earlier may now be overwritten by this span
+  m_current_index.clear();
+
+  uint32_t run_count = 0;
+
+  for (size_t i = 0; i < length;)
+  {
+    size_t end = i + 1;
+    while (end < length && old_ids[end] == old_ids[i])
+      end++;
+
+    m_current.runs.push_back({ static_cast<uint32_t>(end - i),
+                               static_cast<uint32_t>(old_ids[i]) });
+    run_count++;
+    i = end;
+  }
+
+  m_current.spans.push_back({ static_cast<uint32_t>(x),
+                              static_cast<uint32_t>(y),
+                              static_cast<uint32_t>(length), new_id,
+                              run_count });
+}
+
+/**
+ * Records that the @p length tiles from (@p x, @p y) are about to be replaced
+ * with @p new_ids, e. g. when pasting. Each run of identical new IDs is stored
+ * as a span.
+ */
+template<typename T, typename U>
+void
+EditorHistory::record_row(size_t x, size_t y, const T* old_ids,
+                          const U* new_ids, size_t length)
+{
+  for (size_t i = 0; i < length;)
+  {
+    size_t end = i + 1;
+    while (end < length && new_ids[end] == new_ids[i])
+      end++;
+
+    record_span(x + i, y, old_ids + i, end - i,
+                static_cast<uint32_t>(new_ids[i]));
+    i = end;
+  }
+}
+
+#endif
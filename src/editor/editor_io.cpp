@@ -0,0 +1,243 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "editor/editor_io.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "level/level_bmp.hpp"
+#include "level/level_file.hpp"
+#include "util/fs.hpp"
+#include "util/log.hpp"
+#include "util/profiler.hpp"
+
+EditorIO::EditorIO() :
+  m_thread(),
+  m_running(false),
+  m_progress(0.0f),
+  m_mutex(),
+  m_result(),
+  m_error(),
+  m_pending(false),
+  m_loading(false),
+  m_file(),
+  m_status(),
+  m_cache(),
+  m_revision(0),
+  m_compress(false),
+  m_saved_revision(0),
+  m_saved_compress(false),
+  m_saved_file()
+{
+}
+
+EditorIO::~EditorIO()
+{
+  // Let pending saves finish, the level would be lost otherwise
+  if (m_thread.joinable())
+    m_thread.join();
+}
+
+bool
+EditorIO::is_busy() const
+{
+  return m_pending;
+}
+
+float
+EditorIO::get_progress() const
+{
+  return m_progress;
+}
+
+/** Returns a message describing the current or last operation, if any. */
+const std::string&
+EditorIO::get_status() const
+{
+  return m_status;
+}
+
+/**
+ * Starts saving @p tilemap, either in the native format or, if @p file ends
+ * with ".bmp", as an image where each pixel is a tile. Nothing is written if
+ * @p file already holds the same level, encoded the same way, and the tilemap
+ * wasn't changed since.
+ */
+void
+EditorIO::save(const Tilemap& tilemap, const std::string& file, bool compress)
+{
+  uint64_t revision = tilemap.get_revision();
+
+  if (!m_pending && is_saved(revision, file, compress))
+  {
+    m_status = "No changes to save in " + file;
+    return;
+  }
+
+  // The snapshot shares its tiles with the editor's tilemap until it changes
+  auto snapshot = std::make_shared<Tilemap>(tilemap);
+
+  start(file, false, [this, snapshot, file, compress] {
+    auto progress = [this] (float done) { m_progress = done; };
+    std::string tmp_file = file + ".tmp";
+
+    if (LevelBmp::is_bmp(file))
+      LevelBmp::save(*snapshot, tmp_file);
+    else
+      LevelFile::save(*snapshot, tmp_file, compress, progress, &m_cache);
+
+    FS::rename(tmp_file, file);
+  });
+
+  m_revision = revision;
+  m_compress = compress;
+}
+
+/**
+ * Starts loading a level, either in the native format or, if @p file ends with
+ * ".bmp", from an image where each pixel is a tile.
+ */
+void
+EditorIO::load(const std::string& file, uint32_t max_id)
+{
+  start(file, true, [this, file, max_id] {
+    auto progress = [this] (float done) { m_progress = done; };
+    std::unique_ptr<Tilemap> tilemap;
+    bool compressed = false;
+
+    if (LevelBmp::is_bmp(file))
+      tilemap = std::make_unique<Tilemap>(LevelBmp::load(file, max_id));
+    else
+      tilemap = std::make_unique<Tilemap>(LevelFile::load(file, max_id,
+                                                          progress,
+                                                          &compressed));
+
+    // Hashing on the worker spares the editor from hashing the whole level
+    // the first time it saves it; the hashes are kept in the tiles
+    tilemap->get_hash();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_revision = tilemap->get_revision();
+    m_compress = compressed;
+    m_result = std::move(tilemap);
+  });
+}
+
+/**
+ * Collects the result of the operation once it is done. Errors are logged and
+ * shown through get_status().
+ *
+ * @returns Whether a level was loaded in @p tilemap.
+ */
+bool
+EditorIO::update(Tilemap& tilemap)
+{
+  if (!m_pending || m_running)
+    return false;
+
+  if (m_thread.joinable())
+    m_thread.join();
+
+  m_pending = false;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!m_error.empty())
+  {
+    log_error << m_error << std::endl;
+    m_status = m_error;
+    m_error.clear();
+    m_result.reset();
+
+    // A failed save may have replaced the file or not, don't trust it anymore
+    if (m_file == m_saved_file)
+      m_saved_file.clear();
+
+    return false;
+  }
+
+  m_saved_revision = m_revision;
+  m_saved_compress = m_compress;
+  m_saved_file = m_file;
+
+  if (!m_loading)
+  {
+    m_status = "Saved " + m_file;
+    return false;
+  }
+
+  m_status = "Loaded " + m_file;
+  tilemap = std::move(*m_result);
+  m_result.reset();
+  return true;
+}
+
+/**
+ * Whether @p file already holds the tilemap with the given @p revision. Hashes
+ * of the tiles aren't enough to tell, as they may collide.
+ */
+bool
+EditorIO::is_saved(uint64_t revision, const std::string& file,
+                   bool compress) const
+{
+  // The file may have been removed or replaced by something else in between
+  return file == m_saved_file && revision == m_saved_revision
+         && (compress == m_saved_compress || LevelBmp::is_bmp(file))
+         && FS::exists(file);
+}
+
+void
+EditorIO::start(const std::string& file, bool loading,
+                std::function<void()> task)
+{
+  if (m_pending)
+  {
+    throw std::runtime_error("Can't access '" + file + "': busy with '"
+                             + m_file + "'");
+  }
+
+  m_pending = true;
+  m_loading = loading;
+  m_file = file;
+  m_status = (loading ? "Loading " : "Saving ") + file;
+  m_progress = 0.0f;
+  m_running = true;
+
+  auto run = [this, task] {
+    try
+    {
+      task();
+    }
+    catch (const std::exception& e)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_error = e.what();
+    }
+
+    m_running = false;
+  };
+
+#ifdef EMSCRIPTEN
+  // No threads, but the result is still only collected in update()
+  run();
+#else
+  m_thread = std::thread([run] {
+    Profiler::set_thread_name("Editor I/O");
+    run();
+  });
+#endif
+}
@@ -0,0 +1,97 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_EDITOR_EDITORIO_HPP
+#define HEADER_STM_EDITOR_EDITORIO_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "level/level_file.hpp"
+#include "level/tilemap.hpp"
+
+/**
+ * Saves and loads levels on a worker thread, so that the editor keeps running
+ * while big levels are encoded, decoded and written.
+ *
+ * Saving works on a snapshot of the tilemap, which is cheap to take since the
+ * tiles are copy-on-write. The level is written to a temporary file which then
+ * replaces the target, so an interrupted save never leaves a broken level.
+ *
+ * Results are only handed back in update(), which the editor calls once per
+ * frame, so the tilemap is never swapped in the middle of a frame. Only one
+ * operation can run at a time.
+ *
+ * The revision and encoding of the last level saved or loaded are kept, so
+ * that saving a level which didn't change since is skipped. The chunks of the
+ * last compressed save are also kept, so that only the chunks which changed
+ * are encoded again.
+ *
+ * Emscripten builds have no threads; the work is done when it is requested,
+ * but still reported in update().
+ */
+class EditorIO final
+{
+public:
+  EditorIO();
+  ~EditorIO();
+
+  bool is_busy() const;
+  float get_progress() const;
+  const std::string& get_status() const;
+
+  void save(const Tilemap& tilemap, const std::string& file, bool compress);
+  void load(const std::string& file, uint32_t max_id);
+
+  bool update(Tilemap& tilemap);
+
+private:
+  void start(const std::string& file, bool loading,
+             std::function<void()> task);
+  bool is_saved(uint64_t revision, const std::string& file,
+                bool compress) const;
+
+private:
+  std::thread m_thread;
+  std::atomic<bool> m_running;
+  std::atomic<float> m_progress;
+  std::mutex m_mutex;
+  std::unique_ptr<Tilemap> m_result;
+  std::string m_error;
+  bool m_pending;
+  bool m_loading;
+  std::string m_file;
+  std::string m_status;
+  /** Only used by the worker thread, one operation at a time */
+  LevelFile::SaveCache m_cache;
+  /** Level being saved or loaded, set by the worker on loads */
+  uint64_t m_revision;
+  bool m_compress;
+  /** Level currently in the file m_saved_file, if m_saved_file isn't empty */
+  uint64_t m_saved_revision;
+  bool m_saved_compress;
+  std::string m_saved_file;
+
+private:
+  EditorIO(const EditorIO&) = delete;
+  EditorIO& operator=(const EditorIO&) = delete;
+};
+
+#endif
@@ -16,47 +16,144 @@
 
 #include "editor/editor_tilemap.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
 #include <string>
 
+#include "level/mapped_tilemap.hpp"
+#include "level/tile_fill.hpp"
+#include "level/tile_raycast.hpp"
 #include "util/fs.hpp"
 #include "util/math.hpp"
 #include "video/drawing_context.hpp"
 
-typedef std::unique_ptr<SDL_Surface, void (&) (SDL_Surface*)> SurfPtr;
-
 static const std::vector<std::string> g_tiles = {
   "",
   "images/tiles/block.png",
   "images/tiles/brick.png"
 };
 
+/** Whether each tile of g_tiles blocks movement */
+static const std::vector<bool> g_solid_tiles = {
+  false,
+  true,
+  true
+};
+
 // g_tile_null should probably be called g_tile_default, the code allows it to
 // point to a non-null tile (g_tiles[g_tile_null] is allowed to be non-empty)
 static const int g_tile_null = 0;
 
 static const Size g_tile_size(32.0f, 32.0f);
 
+// Layers can't be removed, so the one created second by the constructor stays
+static const size_t g_interactive_layer = 1;
+
+/** Converts a tile coordinate to an index in [0, size]. */
+static size_t
+clamp_index(float coord, size_t size)
+{
+  if (coord <= 0.0f)
+    return 0;
+
+  return std::min(static_cast<size_t>(coord), size);
+}
+
+/** Draws the tiles of @p row from @p x1 (inclusive) to @p x2 (exclusive). */
+template<typename T>
+static void
+draw_row(DrawingContext& context, size_t y, const T* row, size_t x1,
+         size_t x2)
+{
+  for (size_t x = x1; x < x2; x++)
+  {
+    // This does not use g_tile_null because other tiles may need to be empty.
+    // IDs from mapped levels aren't validated when opened, check them here.
+    if (row[x] >= g_tiles.size() || g_tiles[row[x]].empty())
+      continue;
+
+    Rect tile_rect(Vector(g_tile_size) * Vector(x, y), g_tile_size);
+
+    context.draw_texture(g_tiles[row[x]], true, {}, tile_rect,
+                         Color(1.0f, 1.0f, 1.0f), Blend::BLEND);
+  }
+}
+
+/** Returns the largest tile ID of the tileset. */
+uint32_t
+EditorTilemap::get_max_tile_id()
+{
+  return static_cast<uint32_t>(g_tiles.size() - 1);
+}
+
+/** Returns the image of each tile ID of the tileset, empty for no image. */
+const std::vector<std::string>&
+EditorTilemap::get_tile_textures()
+{
+  return g_tiles;
+}
+
+/** Returns, for each tile ID of the tileset, whether the tile is solid. */
+const std::vector<bool>&
+EditorTilemap::get_solid_tiles()
+{
+  return g_solid_tiles;
+}
+
+EditorTilemap::Layer::Layer(const std::string& layer_name, uint32_t max_id) :
+  name(layer_name),
+  tilemap(max_id),
+  solids(g_solid_tiles),
+  offset(0.0f, 0.0f),
+  history(),
+  visible(true),
+  opacity(1.0f),
+  cache(),
+  cache_valid(false),
+  cache_hash(0),
+  cache_x1(0),
+  cache_y1(0),
+  cache_x2(0),
+  cache_y2(0)
+{
+}
+
 EditorTilemap::EditorTilemap() :
-  m_tilemap(),
+  m_layers(),
+  m_layer(0),
+  m_mapped(),
+  m_io(),
+  m_io_layer(0),
+  m_painting(false),
+  m_tool(Tool::BRUSH),
+  m_drawing_rect(false),
+  m_rect_start(),
+  m_has_selection(false),
+  m_selection_p1(),
+  m_selection_p2(),
+  m_moving(false),
+  m_move_start(),
+  m_clipboard(),
   m_camera(),
   m_tilebox(*this, g_tiles),
-  m_tilemap_offset(0.0f, 0.0f),
   m_tile_id(g_tile_null),
-  m_mouse_pos()
+  m_mouse_pos(),
+  m_redraw(true)
 {
-  m_tilemap.resize(5);
-
-  for (auto& row : m_tilemap)
-    row.resize(10, g_tile_null);
+  add_layer("background");
+  add_layer("interactive");
+  add_layer("foreground");
+  m_layer = g_interactive_layer;
 }
 
 void
 EditorTilemap::event(const SDL_Event& event)
 {
+  Layer& layer = get_layer();
+
   if (m_tilebox.event(event))
     return;
 
@@ -68,17 +165,35 @@ EditorTilemap::event(const SDL_Event& event)
       switch (event.button.button)
       {
         case SDL_BUTTON_LEFT:
+          // Mapped levels can't be resized, only the brush works on them
+          if (m_tool == Tool::BRUSH || m_mapped)
           {
-            float x = static_cast<float>(event.button.x);
-            float y = static_cast<float>(event.button.y);
-
-            Vector tile_coord = screen_to_tilemap(Vector(x, y));
-
-            resize_tilemap_to(tile_coord);
-
-            tile_coord += m_tilemap_offset;
+            // A whole stroke is undone at once
+            m_painting = true;
+            layer.history.begin_action();
+            paint_at(Vector(event.button.x, event.button.y));
+          }
+          else if (m_tool == Tool::LINE || m_tool == Tool::RECTANGLE
+                   || m_tool == Tool::SELECT)
+          {
+            Vector point = screen_to_tilemap(Vector(event.button.x,
+                                                    event.button.y));
 
-            m_tilemap.at(tile_coord.y).at(tile_coord.x) = m_tile_id;
+            // Dragging the selection moves it, dragging elsewhere replaces it
+            if (m_tool == Tool::SELECT && selection_contains(point))
+            {
+              m_moving = true;
+              m_move_start = point;
+            }
+            else
+            {
+              m_drawing_rect = true;
+              m_rect_start = point;
+            }
+          }
+          else
+          {
+            flood_at(Vector(event.button.x, event.button.y));
           }
           break;
 
@@ -87,8 +202,69 @@ EditorTilemap::event(const SDL_Event& event)
       }
       break;
 
+    case SDL_MOUSEBUTTONUP:
+      if (event.button.button == SDL_BUTTON_LEFT && m_painting)
+      {
+        m_painting = false;
+        layer.history.end_action();
+      }
+
+      if (event.button.button == SDL_BUTTON_LEFT && m_drawing_rect)
+      {
+        Vector point = screen_to_tilemap(Vector(event.button.x,
+                                                event.button.y));
+        m_drawing_rect = false;
+
+        if (m_tool == Tool::SELECT)
+        {
+          m_has_selection = true;
+          m_selection_p1 = Vector(std::min(point.x, m_rect_start.x),
+                                  std::min(point.y, m_rect_start.y));
+          m_selection_p2 = Vector(std::max(point.x, m_rect_start.x),
+                                  std::max(point.y, m_rect_start.y));
+        }
+        else if (m_tool == Tool::LINE)
+        {
+          paint_line(m_rect_start, point);
+        }
+        else
+        {
+          fill_rect(m_rect_start, point);
+        }
+      }
+
+      if (event.button.button == SDL_BUTTON_LEFT && m_moving)
+      {
+        m_moving = false;
+        move_selection(screen_to_tilemap(Vector(event.button.x,
+                                                event.button.y))
+                       - m_move_start);
+      }
+      break;
+
     case SDL_MOUSEMOTION:
       m_mouse_pos = Vector(event.motion.x, event.motion.y);
+
+      if (m_painting)
+      {
+        // The button may have been released over the tilebox
+        if (event.motion.state & SDL_BUTTON_LMASK)
+        {
+          paint_at(m_mouse_pos);
+        }
+        else
+        {
+          m_painting = false;
+          layer.history.end_action();
+        }
+      }
+
+      // Releasing the button over the tilebox cancels the rectangle or move
+      if (!(event.motion.state & SDL_BUTTON_LMASK))
+      {
+        m_drawing_rect = false;
+        m_moving = false;
+      }
       break;
 
     default:
@@ -100,57 +276,90 @@ void
 EditorTilemap::update(float dt_sec)
 {
   m_camera.update(dt_sec);
+
+  Layer& layer = *m_layers[m_io_layer];
+
+  // The progress shown changes, and so will the status once done
+  if (m_io.is_busy())
+    m_redraw = true;
+
+  // Levels loaded in the background are only swapped in between frames
+  if (m_io.update(layer.tilemap))
+  {
+    if (m_io_layer == m_layer)
+      end_stroke();
+
+    m_mapped.reset();
+    layer.solids.build(layer.tilemap);
+    layer.history.clear();
+    m_has_selection = false;
+  }
 }
 
 void
 EditorTilemap::draw(DrawingContext& context) const
 {
+  m_redraw = false;
+
   context.draw_filled_rect(context.target_size, Color(0.1f, 0.2f, 0.4f),
                            Blend::NONE);
 
-  if (m_tilemap.size() != 0 && m_tilemap.at(0).size() != 0)
+  context.push_transform();
+  m_camera.apply_transform(context);
+
+  if (m_mapped)
   {
-    context.push_transform();
-    m_camera.apply_transform(context);
+    draw_mapped(context);
+  }
+  else
+  {
+    for (const auto& layer : m_layers)
+    {
+      // Hidden and transparent layers cost nothing
+      if (layer->visible && layer->opacity > 0.0f)
+        draw_layer(context, *layer);
+    }
 
-    context.get_transform().move(-m_tilemap_offset * g_tile_size.vector());
+    const Layer& layer = get_layer();
+    draw_grid(context, layer.offset, layer.tilemap.get_width(),
+              layer.tilemap.get_height());
+  }
 
-    // Tiles
-    for (int y = 0.0f; y < m_tilemap.size(); y++)
-    {
-      for (float x = 0.0f; x < m_tilemap.at(y).size(); x++)
-      {
-        // This does not use g_tile_null because other tiles may need to be
-        // empty
-        if (g_tiles[m_tilemap.at(y).at(x)].empty())
-          continue;
+  context.pop_transform();
 
-        Rect tile_rect(Vector(g_tile_size) * Vector(x, y), g_tile_size);
+  if (m_has_selection)
+  {
+    Vector move = m_moving ? screen_to_tilemap(m_mouse_pos) - m_move_start
+                           : Vector(0.0f, 0.0f);
 
-        context.draw_texture(g_tiles.at(m_tilemap.at(y).at(x)), true, {},
-                             tile_rect, Color(1.0f, 1.0f, 1.0f), Blend::BLEND);
-      }
-    }
+    context.draw_filled_rect(Rect(tilemap_to_screen(m_selection_p1 + move),
+                                  tilemap_to_screen(m_selection_p2 + move
+                                                    + Vector(1.0f, 1.0f))),
+                             Color(0.5f, 0.7f, 1.0f, 0.25f), Blend::BLEND);
+  }
 
-    // Grid
-    if (m_tilemap.size() > 0)
-    {
-      for (float x = 0.0f; x <= m_tilemap.at(0).size(); x++)
-      {
-        context.draw_line(Vector(x * 32.0f, 0.0f),
-                          Vector(x * 32.0f, m_tilemap.size() * 32.0f),
-                          Color(1.0f, 1.0f, 1.0f, 0.5f), Blend::BLEND);
-      }
+  if (m_drawing_rect && m_tool == Tool::LINE)
+  {
+    Vector half(0.5f, 0.5f);
 
-      for (int y = 0.0f; y <= m_tilemap.size(); y++)
-      {
-        context.draw_line(Vector(0.0f, y * 32.0f),
-                          Vector(m_tilemap.at(0).size() * 32.0f, y * 32.0f),
-                          Color(1.0f, 1.0f, 1.0f, 0.5f), Blend::BLEND);
-      }
-    }
+    TileRaycast::walk(m_rect_start + half,
+                      screen_to_tilemap(m_mouse_pos) + half,
+                      [&] (long x, long y) {
+      Vector p(x, y);
+      context.draw_filled_rect(Rect(tilemap_to_screen(p),
+                                    tilemap_to_screen(p + Vector(1.0f, 1.0f))),
+                               Color(1.0f, 1.0f, 1.0f, 0.25f), Blend::BLEND);
+    });
+  }
+  else if (m_drawing_rect)
+  {
+    Vector p = screen_to_tilemap(m_mouse_pos);
+    Vector p1(std::min(p.x, m_rect_start.x), std::min(p.y, m_rect_start.y));
+    Vector p2(std::max(p.x, m_rect_start.x), std::max(p.y, m_rect_start.y));
 
-    context.pop_transform();
+    context.draw_filled_rect(Rect(tilemap_to_screen(p1),
+                                  tilemap_to_screen(p2 + Vector(1.0f, 1.0f))),
+                             Color(1.0f, 1.0f, 1.0f, 0.25f), Blend::BLEND);
   }
 
   if (m_tile_id < g_tiles.size() && !g_tiles[m_tile_id].empty())
@@ -165,108 +374,416 @@ EditorTilemap::draw(DrawingContext& context) const
   m_tilebox.draw(context);
 
   /** @todo de-hardcode the tilebox width here */
-  context.draw_text("Press Ctrl+S to save and Ctrl+O to load",
+  context.draw_text("Press Ctrl+S to save and Ctrl+O to load, add Shift to "
+                    "export or import as BMP. Press Ctrl+E to export "
+                    "uncompressed and Ctrl+M to view it memory-mapped. Press "
+                    "Ctrl+Z to undo and Ctrl+Y to redo. Press B, L, R, F or S "
+                    "to switch to the brush, line, rectangle, fill or select "
+                    "tool, then Ctrl+C, Ctrl+X and Ctrl+V to copy, cut and "
+                    "paste at the mouse. Drag the selection to move it. Press "
+                    "1-9 to select a layer, H to hide it, - and = to change "
+                    "its opacity and Ctrl+N to add one. Press P to play from "
+                    "the mouse",
                     "fonts/SuperTux-Medium.ttf", true, 12, TextAlign::TOP_LEFT,
                     Rect(context.target_size).with_x1(128).grown(-8.0f),
                     Color(1.0f, 1.0f, 1.0f), Blend::BLEND);
+
+  const Layer& layer = get_layer();
+  std::string layer_status = "Layer " + std::to_string(m_layer + 1) + "/"
+                             + std::to_string(m_layers.size()) + ": "
+                             + layer.name;
+
+  if (!layer.visible)
+    layer_status += " (hidden)";
+  else if (layer.opacity < 1.0f)
+    layer_status += " (" + std::to_string(static_cast<int>(layer.opacity
+                                                           * 100.0f)) + "%)";
+
+  context.draw_text(layer_status, "fonts/SuperTux-Medium.ttf", true, 12,
+                    TextAlign::BOT_RIGHT,
+                    Rect(context.target_size).with_x1(128).grown(-8.0f),
+                    Color(1.0f, 1.0f, 1.0f), Blend::BLEND);
+
+  std::string status = m_io.get_status();
+
+  if (m_io.is_busy())
+  {
+    status += " (" + std::to_string(static_cast<int>(m_io.get_progress()
+                                                     * 100.0f)) + "%)";
+  }
+
+  if (!status.empty())
+  {
+    context.draw_text(status, "fonts/SuperTux-Medium.ttf", true, 12,
+                      TextAlign::BOT_LEFT,
+                      Rect(context.target_size).with_x1(128).grown(-8.0f),
+                      Color(1.0f, 1.0f, 1.0f), Blend::BLEND);
+  }
+}
+
+/**
+ * Returns whether drawing again would show something new, other than because
+ * of an event: the camera gliding to its target, or a level being saved or
+ * loaded in the background.
+ */
+bool
+EditorTilemap::needs_redraw() const
+{
+  return m_redraw || !m_camera.is_settled();
+}
+
+EditorTilemap::Layer&
+EditorTilemap::get_layer()
+{
+  return *m_layers[m_layer];
+}
+
+const EditorTilemap::Layer&
+EditorTilemap::get_layer() const
+{
+  return *m_layers[m_layer];
 }
 
+/** Ends the stroke or drag in progress, if any. */
 void
-EditorTilemap::load_tilemap(const std::string& file)
+EditorTilemap::end_stroke()
+{
+  if (m_painting)
+    get_layer().history.end_action();
+
+  m_painting = false;
+  m_drawing_rect = false;
+  m_moving = false;
+}
+
+/**
+ * Finds the tiles of a tilemap of @p width by @p height tiles with the given
+ * @p offset which are on screen, as the range [x1, x2) by [y1, y2).
+ */
+void
+EditorTilemap::get_visible_area(const DrawingContext& context,
+                                const Vector& offset, size_t width,
+                                size_t height, size_t& x1, size_t& y1,
+                                size_t& x2, size_t& y2) const
+{
+  Vector top_left = screen_to_tilemap(Vector(0.0f, 0.0f)) + offset;
+  Vector bottom_right = screen_to_tilemap(context.target_size.vector())
+                        + offset + Vector(1.0f, 1.0f);
+
+  x1 = clamp_index(top_left.x, width);
+  y1 = clamp_index(top_left.y, height);
+  x2 = clamp_index(bottom_right.x, width);
+  y2 = clamp_index(bottom_right.y, height);
+}
+
+/**
+ * Draws the tiles of @p layer which are on screen. The list of tiles to draw
+ * is kept in the layer, and only built again once the tiles of that layer or
+ * the visible area change, so that the layers that aren't being edited don't
+ * need to be scanned every frame.
+ */
+void
+EditorTilemap::draw_layer(DrawingContext& context, const Layer& layer) const
 {
-  SurfPtr img(SDL_LoadBMP_RW(FS::get_rwops(file.c_str(), FS::OP::READ), true),
-               SDL_FreeSurface);
+  size_t x1, y1, x2, y2;
+  get_visible_area(context, layer.offset, layer.tilemap.get_width(),
+                   layer.tilemap.get_height(), x1, y1, x2, y2);
 
-  if (!img)
+  // Only the bands changed since the last frame are hashed again
+  uint64_t hash = layer.tilemap.get_hash();
+
+  if (!layer.cache_valid || layer.cache_hash != hash || layer.cache_x1 != x1
+      || layer.cache_y1 != y1 || layer.cache_x2 != x2 || layer.cache_y2 != y2)
   {
-    throw std::runtime_error("Can't open BMP at '" + file + "': "
-                            + std::string(SDL_GetError()));
+    layer.cache.clear();
+    layer.tilemap.visit([&] (const auto& grid) {
+      for (size_t y = y1; y < y2; y++)
+      {
+        const auto* row = grid.get_row(y);
+
+        for (size_t x = x1; x < x2; x++)
+        {
+          // This does not use g_tile_null because other tiles may need to be
+          // empty
+          if (row[x] < g_tiles.size() && !g_tiles[row[x]].empty())
+          {
+            layer.cache.push_back({ static_cast<uint32_t>(x),
+                                    static_cast<uint32_t>(y),
+                                    static_cast<uint32_t>(row[x]) });
+          }
+        }
+      }
+    });
+
+    layer.cache_valid = true;
+    layer.cache_hash = hash;
+    layer.cache_x1 = x1;
+    layer.cache_y1 = y1;
+    layer.cache_x2 = x2;
+    layer.cache_y2 = y2;
   }
 
-  SurfPtr data(SDL_ConvertSurfaceFormat(img.get(), SDL_PIXELFORMAT_ARGB8888, 0),
-               SDL_FreeSurface);
+  context.push_transform();
+  context.get_transform().move(-layer.offset * g_tile_size.vector());
 
-  if (!data)
+  for (const auto& tile : layer.cache)
   {
-    throw std::runtime_error("Can't convert '" + file + "' to ARGB8888: "
-                            + std::string(SDL_GetError()));
+    Rect tile_rect(Vector(g_tile_size) * Vector(tile.x, tile.y), g_tile_size);
+
+    context.draw_texture(g_tiles[tile.id], true, {}, tile_rect,
+                         Color(1.0f, 1.0f, 1.0f, layer.opacity),
+                         Blend::BLEND);
   }
 
-  auto w = data->w;
-  auto h = data->h;
-  auto bpp = data->format->BytesPerPixel;
+  context.pop_transform();
+}
 
-  m_tilemap.clear();
-  m_tilemap.resize(h);
+/** Draws the mapped level, placed like the selected layer. */
+void
+EditorTilemap::draw_mapped(DrawingContext& context) const
+{
+  const Vector& offset = get_layer().offset;
+  size_t x1, y1, x2, y2;
 
-  for (int y = 0; y < h; y++)
-  {
-    m_tilemap.at(y).resize(w);
+  // Only the tiles on screen are drawn, which also keeps mapped levels from
+  // paging in rows that aren't visible
+  get_visible_area(context, offset, m_mapped->get_width(),
+                   m_mapped->get_height(), x1, y1, x2, y2);
 
-    for (int x = 0; x < w; x++)
-    {
-      int tile = *((Uint32*) ((Uint8*) data->pixels + y * data->pitch
-                  + x * bpp)) ^ 0xff000000;
+  context.push_transform();
+  context.get_transform().move(-offset * g_tile_size.vector());
 
-      if (tile >= g_tiles.size())
-      {
-        throw std::runtime_error("Can't load file " + file + ": tile overflow "
-                                + std::to_string(tile) + " at location "
-                                + std::to_string(x) + "x" + std::to_string(y));
-      }
+  m_mapped->visit_rows(y1, y2, [&] (size_t y, const auto* row) {
+    draw_row(context, y, row, x1, x2);
+  });
 
-      m_tilemap.at(y).at(x) = tile;
-    }
-  }
+  context.pop_transform();
+
+  draw_grid(context, offset, m_mapped->get_width(), m_mapped->get_height());
 }
 
+/** Draws the outline of the tiles which are on screen. */
 void
-EditorTilemap::save_tilemap(const std::string& file) const
+EditorTilemap::draw_grid(DrawingContext& context, const Vector& offset,
+                         size_t width, size_t height) const
 {
-  auto h = m_tilemap.size(), w = h ? m_tilemap.at(0).size() : 0;
+  if (!width || !height)
+    return;
 
-  auto format = SDL_PIXELFORMAT_ARGB8888;
-#if SDL_VERSION_ATLEAST(2, 0, 5)
-  SurfPtr surface(SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, format),
-                  SDL_FreeSurface);
-#else
-  SurfPtr surface(nullptr, SDL_FreeSurface);
+  size_t x1, y1, x2, y2;
+  get_visible_area(context, offset, width, height, x1, y1, x2, y2);
 
-  {
-    Uint32 r, g, b, a;
-    int bpp; // Unused, but required by SDL
-    auto success = SDL_PixelFormatEnumToMasks(format, &bpp, &r, &g, &b, &a);
+  context.push_transform();
+  context.get_transform().move(-offset * g_tile_size.vector());
 
-    if (success == SDL_FALSE)
-    {
-      throw std::runtime_error("Can't obtain image format info: "
-                               + std::string(SDL_GetError()));
-    }
+  float fx1 = static_cast<float>(x1) * g_tile_size.w;
+  float fy1 = static_cast<float>(y1) * g_tile_size.h;
+  float fx2 = static_cast<float>(x2) * g_tile_size.w;
+  float fy2 = static_cast<float>(y2) * g_tile_size.h;
 
-    surface.reset(SDL_CreateRGBSurface(0, w, h, 32, r, g, b, a));
+  for (size_t x = x1; x <= x2; x++)
+  {
+    float fx = static_cast<float>(x) * g_tile_size.w;
+    context.draw_line(Vector(fx, fy1), Vector(fx, fy2),
+                      Color(1.0f, 1.0f, 1.0f, 0.5f), Blend::BLEND);
   }
-#endif
 
-  if (!surface)
+  for (size_t y = y1; y <= y2; y++)
   {
-    throw std::runtime_error("Can't create image surface: "
-                             + std::string(SDL_GetError()));
+    float fy = static_cast<float>(y) * g_tile_size.h;
+    context.draw_line(Vector(fx1, fy), Vector(fx2, fy),
+                      Color(1.0f, 1.0f, 1.0f, 0.5f), Blend::BLEND);
   }
 
-  auto bpp = surface->format->BytesPerPixel;
+  context.pop_transform();
+}
 
-  for (int y = 0; y < h; y++)
-  {
-    for (int x = 0; x < w; x++)
-    {
-      auto* p = (Uint32 *) ((Uint8 *) surface->pixels + y * surface->pitch
-                                          + x * surface->format->BytesPerPixel);
-      *p = m_tilemap.at(y).at(x) ^ 0xff000000;
-    }
-  }
+/**
+ * Starts loading a level in the background, either in the native format or, if
+ * @p file ends with ".bmp", from an image where each pixel is a tile. Once
+ * loaded, the level replaces the tiles of the selected layer and closes the
+ * mapped level, if any.
+ */
+void
+EditorTilemap::load_tilemap(const std::string& file)
+{
+  m_io.load(file, get_max_tile_id());
+  m_io_layer = m_layer;
+}
+
+/**
+ * Starts saving the tiles of the selected layer in the background, either in
+ * the native format or, if @p file ends with ".bmp", as an image where each
+ * pixel is a tile. Changes made while saving aren't included in the saved
+ * level.
+ *
+ * @param compress Whether to compress the level in the native format. Only
+ *                 uncompressed levels can be opened with open_mapped().
+ */
+void
+EditorTilemap::save_tilemap(const std::string& file, bool compress)
+{
+  Layer& layer = get_layer();
+
+  if (m_mapped)
+    throw std::runtime_error("Mapped levels are read-only, can't save them");
+
+  m_io.save(layer.tilemap, file, compress);
+}
+
+/**
+ * Opens an uncompressed level for viewing without loading it. Changes made to
+ * the level are kept in memory and can't be saved. The level being edited is
+ * left untouched, and comes back when another level is loaded.
+ */
+void
+EditorTilemap::open_mapped(const std::string& file)
+{
+  m_mapped = std::make_unique<MappedTilemap>(FS::get_real_path(file));
+}
+
+/**
+ * Reverts the last stroke on the selected layer. Changes to mapped levels
+ * can't be undone.
+ */
+void
+EditorTilemap::undo()
+{
+  // Undoing ends the current stroke
+  m_painting = false;
+
+  if (!m_mapped)
+    replay_history(get_layer(), false);
+}
 
-  SDL_SaveBMP_RW(surface.get(), FS::get_rwops(file.c_str(), FS::OP::WRITE),
-                 true);
+void
+EditorTilemap::redo()
+{
+  m_painting = false;
+
+  if (!m_mapped)
+    replay_history(get_layer(), true);
+}
+
+/**
+ * Undoes or redoes the last action of @p layer, updating its solid mask only
+ * where the action changed tiles.
+ */
+void
+EditorTilemap::replay_history(Layer& layer, bool redo)
+{
+  auto on_fill = [&layer] (size_t x, size_t y, size_t length, uint32_t id) {
+    layer.solids.fill(x, y, length, id);
+  };
+
+  auto on_resize = [&layer] (size_t width, size_t height, int off_x,
+                             int off_y, uint32_t fill) {
+    layer.solids.resize(width, height, off_x, off_y, fill);
+  };
+
+  if (redo)
+    layer.history.redo(layer.tilemap, layer.offset, on_fill, on_resize);
+  else
+    layer.history.undo(layer.tilemap, layer.offset, on_fill, on_resize);
+}
+
+/** Returns the tiles the player walks on. */
+const Tilemap&
+EditorTilemap::get_interactive_tilemap() const
+{
+  return m_layers[g_interactive_layer]->tilemap;
+}
+
+/** Returns the tile under the mouse in get_interactive_tilemap(). */
+Vector
+EditorTilemap::get_mouse_tile() const
+{
+  return screen_to_tilemap(m_mouse_pos)
+         + m_layers[g_interactive_layer]->offset;
+}
+
+/** Adds a layer on top of the others, and selects it. */
+void
+EditorTilemap::add_layer(const std::string& name)
+{
+  m_layers.push_back(std::make_unique<Layer>(name, get_max_tile_id()));
+  m_layers.back()->tilemap.resize(10, 5, 0, 0, g_tile_null);
+  m_layers.back()->solids.build(m_layers.back()->tilemap);
+
+  select_layer(m_layers.size() - 1);
+}
+
+/** Selects the layer the tools work on. Invalid indexes are ignored. */
+void
+EditorTilemap::select_layer(size_t index)
+{
+  if (index >= m_layers.size())
+    return;
+
+  end_stroke();
+  m_layer = index;
+}
+
+void
+EditorTilemap::toggle_layer_visibility()
+{
+  get_layer().visible = !get_layer().visible;
+}
+
+void
+EditorTilemap::change_layer_opacity(float delta)
+{
+  Layer& layer = get_layer();
+  layer.opacity = Math::clamp(layer.opacity + delta, 0.0f, 1.0f);
+}
+
+/** Copies the selected tiles, including those outside of the layer. */
+void
+EditorTilemap::copy_selection()
+{
+  if (m_mapped || !m_has_selection)
+    return;
+
+  copy_selection_to(m_clipboard);
+}
+
+void
+EditorTilemap::cut_selection()
+{
+  Layer& layer = get_layer();
+
+  if (m_mapped || !m_has_selection)
+    return;
+
+  copy_selection();
+
+  layer.history.begin_action();
+  fill_tiles(m_selection_p1, m_selection_p2, g_tile_null);
+  layer.history.end_action();
+}
+
+/**
+ * Pastes the copied tiles with their top-left corner under the mouse, and
+ * selects them so that they can be moved right away.
+ */
+void
+EditorTilemap::paste()
+{
+  Layer& layer = get_layer();
+
+  if (m_mapped || m_clipboard.empty())
+    return;
+
+  Vector point = screen_to_tilemap(m_mouse_pos);
+
+  layer.history.begin_action();
+  paste_at(m_clipboard, point);
+  layer.history.end_action();
+
+  m_has_selection = true;
+  m_selection_p1 = point;
+  m_selection_p2 = point + Vector(m_clipboard.get_width() - 1,
+                                  m_clipboard.get_height() - 1);
 }
 
 void
@@ -277,61 +794,287 @@ EditorTilemap::set_tile_id(size_t id)
   m_tile_id = id;
 }
 
+void
+EditorTilemap::set_tool(Tool tool)
+{
+  m_tool = tool;
+  m_drawing_rect = false;
+  m_moving = false;
+}
+
 void
 EditorTilemap::resize_tilemap_to(const Vector& tilemap_point)
 {
-  int x = static_cast<int>(tilemap_point.x + m_tilemap_offset.x);
-  int y = static_cast<int>(tilemap_point.y + m_tilemap_offset.y);
+  resize_tilemap_to(tilemap_point, tilemap_point);
+}
+
+/** Grows the level so that it contains the rectangle from @p p1 to @p p2. */
+void
+EditorTilemap::resize_tilemap_to(const Vector& p1, const Vector& p2)
+{
+  Layer& layer = get_layer();
 
-  int width = (m_tilemap.size() > 0) ? m_tilemap.at(0).size() : 1;
+  int x1 = static_cast<int>(std::min(p1.x, p2.x) + layer.offset.x);
+  int y1 = static_cast<int>(std::min(p1.y, p2.y) + layer.offset.y);
+  int x2 = static_cast<int>(std::max(p1.x, p2.x) + layer.offset.x);
+  int y2 = static_cast<int>(std::max(p1.y, p2.y) + layer.offset.y);
 
-  if (y < 0)
-  {
-    m_tilemap.resize(m_tilemap.size() - y);
+  int width = static_cast<int>(layer.tilemap.get_width());
+  int height = static_cast<int>(layer.tilemap.get_height());
 
-    for (int i = m_tilemap.size() - 1; i >= -y; i--)
-    {
-      m_tilemap.at(i) = std::move(m_tilemap.at(i + y));
-    }
-  }
-  else if (y >= m_tilemap.size())
+  // Space to add before the first column/row, if the area is left/above
+  int left = std::max(-x1, 0);
+  int top = std::max(-y1, 0);
+
+  int new_width = std::max(width, x2 + 1) + left;
+  int new_height = std::max(height, y2 + 1) + top;
+
+  // A single resize, so that the tiles are moved at most once
+  if (new_width != width || new_height != height)
   {
-    m_tilemap.resize(y + 1);
+    layer.tilemap.resize(new_width, new_height, left, top, g_tile_null);
+    layer.solids.resize(new_width, new_height, left, top, g_tile_null);
+    layer.history.record_resize(width, height, new_width, new_height, left,
+                                top, g_tile_null);
   }
 
-  if (x < 0)
-  {
-    for (auto& row : m_tilemap)
-    {
-      row.resize(width - x, g_tile_null);
+  layer.offset += Vector(left, top);
+}
 
-      for (int i = row.size() - 1; i >= -x; i--)
-      {
-        row.at(i) = std::move(row.at(i + x));
-      }
+/** Places the selected tile at @p screen_point, growing the level if needed. */
+void
+EditorTilemap::paint_at(const Vector& screen_point)
+{
+  Layer& layer = get_layer();
 
-      for (int i = 0; i < -x; i++)
-      {
-        row.at(i) = g_tile_null;
-      }
-    }
-  }
-  else if (x >= width)
+  Vector tile_coord = screen_to_tilemap(screen_point);
+
+  if (m_mapped)
   {
-    for (auto& row : m_tilemap)
+    // Mapped levels can't be resized, only tiles inside are changed
+    tile_coord += layer.offset;
+
+    if (tile_coord.x >= 0.0f && tile_coord.y >= 0.0f
+        && tile_coord.x < static_cast<float>(m_mapped->get_width())
+        && tile_coord.y < static_cast<float>(m_mapped->get_height()))
     {
-      row.resize(x + 1, g_tile_null);
+      m_mapped->set(static_cast<size_t>(tile_coord.x),
+                    static_cast<size_t>(tile_coord.y),
+                    static_cast<uint32_t>(m_tile_id));
     }
+    return;
   }
-  else
+
+  resize_tilemap_to(tile_coord);
+
+  tile_coord += layer.offset;
+
+  set_tile(static_cast<size_t>(tile_coord.x),
+           static_cast<size_t>(tile_coord.y), static_cast<uint32_t>(m_tile_id));
+}
+
+/**
+ * Draws a line of the selected tile from the tile @p p1 to the tile @p p2
+ * (both included), growing the level once if needed. Does NOT take tilemap
+ * offset in consideration.
+ */
+void
+EditorTilemap::paint_line(const Vector& p1, const Vector& p2)
+{
+  Layer& layer = get_layer();
+
+  layer.history.begin_action();
+
+  resize_tilemap_to(p1, p2);
+
+  // Between the centers of the tiles, so that the line looks the same both ways
+  Vector half(0.5f, 0.5f);
+
+  TileRaycast::walk(p1 + layer.offset + half, p2 + layer.offset + half,
+                    [this] (long x, long y) {
+    set_tile(static_cast<size_t>(x), static_cast<size_t>(y),
+             static_cast<uint32_t>(m_tile_id));
+  });
+
+  layer.history.end_action();
+}
+
+/**
+ * Sets the tile at (@p x, @p y) in the selected layer, which must be inside of
+ * it, recording it in the current action.
+ */
+void
+EditorTilemap::set_tile(size_t x, size_t y, uint32_t id)
+{
+  Layer& layer = get_layer();
+  auto old_id = layer.tilemap.get(x, y);
+
+  if (old_id != id)
   {
-    for (auto& row : m_tilemap)
-    {
-      row.resize(width, g_tile_null);
-    }
+    layer.tilemap.set(x, y, id);
+    layer.solids.set(x, y, id);
+    layer.history.record_tile(x, y, old_id, id);
   }
+}
+
+/**
+ * Fills the rectangle between the tiles @p p1 and @p p2 (both included) with
+ * the selected tile, growing the level once if needed. Does NOT take tilemap
+ * offset in consideration.
+ */
+void
+EditorTilemap::fill_rect(const Vector& p1, const Vector& p2)
+{
+  Layer& layer = get_layer();
+
+  layer.history.begin_action();
+
+  resize_tilemap_to(p1, p2);
+  fill_tiles(p1, p2, static_cast<uint32_t>(m_tile_id));
+
+  layer.history.end_action();
+}
+
+/**
+ * Sets the tiles between @p p1 and @p p2 (both included) which are inside the
+ * level to @p id, recording them in the current action. Does NOT take tilemap
+ * offset in consideration.
+ */
+void
+EditorTilemap::fill_tiles(const Vector& p1, const Vector& p2, uint32_t id)
+{
+  Layer& layer = get_layer();
+
+  Vector top_left = Vector(std::min(p1.x, p2.x), std::min(p1.y, p2.y))
+                    + layer.offset;
+  Vector bottom_right = Vector(std::max(p1.x, p2.x), std::max(p1.y, p2.y))
+                        + layer.offset;
+
+  if (bottom_right.x < 0.0f || bottom_right.y < 0.0f)
+    return;
 
-  m_tilemap_offset += Vector((x < 0) ? -x : 0, (y < 0) ? -y : 0);
+  auto x1 = static_cast<size_t>(std::max(top_left.x, 0.0f));
+  auto y1 = static_cast<size_t>(std::max(top_left.y, 0.0f));
+  auto x2 = static_cast<size_t>(bottom_right.x);
+  auto y2 = static_cast<size_t>(bottom_right.y);
+
+  layer.tilemap.reserve_id(id);
+  layer.tilemap.visit([&] (auto& grid) {
+    TileFill::rect(grid, x1, y1, x2, y2, id,
+                   [&] (size_t x, size_t y, const auto* old_ids, size_t len) {
+      layer.history.record_span(x, y, old_ids, len, id);
+      layer.solids.fill(x, y, len, id);
+    });
+  });
+}
+
+/**
+ * Replaces the area of identical tiles around @p screen_point with the selected
+ * tile. The level is never resized; clicks outside of it are ignored.
+ */
+void
+EditorTilemap::flood_at(const Vector& screen_point)
+{
+  Layer& layer = get_layer();
+
+  Vector tile_coord = screen_to_tilemap(screen_point) + layer.offset;
+
+  if (tile_coord.x < 0.0f || tile_coord.y < 0.0f
+      || tile_coord.x >= static_cast<float>(layer.tilemap.get_width())
+      || tile_coord.y >= static_cast<float>(layer.tilemap.get_height()))
+    return;
+
+  auto x = static_cast<size_t>(tile_coord.x);
+  auto y = static_cast<size_t>(tile_coord.y);
+  auto id = static_cast<uint32_t>(m_tile_id);
+
+  layer.history.begin_action();
+
+  layer.tilemap.reserve_id(id);
+  layer.tilemap.visit([&] (auto& grid) {
+    TileFill::flood(grid, x, y, id,
+                    [&] (size_t sx, size_t sy, const auto* old_ids,
+                         size_t len) {
+      layer.history.record_span(sx, sy, old_ids, len, id);
+      layer.solids.fill(sx, sy, len, id);
+    });
+  });
+
+  layer.history.end_action();
+}
+
+/**
+ * Pastes @p clipboard with its top-left corner at @p tilemap_point, growing
+ * the level once if needed. The tiles are recorded in the current action.
+ * Does NOT take tilemap offset in consideration.
+ */
+void
+EditorTilemap::paste_at(const TileClipboard& clipboard,
+                        const Vector& tilemap_point)
+{
+  Layer& layer = get_layer();
+
+  if (clipboard.empty())
+    return;
+
+  resize_tilemap_to(tilemap_point,
+                    tilemap_point + Vector(clipboard.get_width() - 1,
+                                           clipboard.get_height() - 1));
+
+  Vector pos = tilemap_point + layer.offset;
+
+  clipboard.paste(layer.tilemap, static_cast<size_t>(pos.x),
+                  static_cast<size_t>(pos.y),
+                  [&layer] (size_t x, size_t y, const auto* old_ids,
+                            const auto* new_ids, size_t len) {
+    layer.history.record_row(x, y, old_ids, new_ids, len);
+    layer.solids.assign(x, y, new_ids, len);
+  });
+}
+
+void
+EditorTilemap::copy_selection_to(TileClipboard& clipboard) const
+{
+  const Layer& layer = get_layer();
+
+  Vector pos = m_selection_p1 + layer.offset;
+  Vector size = m_selection_p2 - m_selection_p1 + Vector(1.0f, 1.0f);
+
+  clipboard.copy(layer.tilemap, static_cast<long>(pos.x),
+                 static_cast<long>(pos.y), static_cast<size_t>(size.x),
+                 static_cast<size_t>(size.y), g_tile_null);
+}
+
+/** Moves the selected tiles by @p offset tiles, as a single action. */
+void
+EditorTilemap::move_selection(const Vector& offset)
+{
+  Layer& layer = get_layer();
+
+  if (m_mapped || !m_has_selection || (offset.x == 0.0f && offset.y == 0.0f))
+    return;
+
+  TileClipboard moved;
+  copy_selection_to(moved);
+
+  layer.history.begin_action();
+  fill_tiles(m_selection_p1, m_selection_p2, g_tile_null);
+  paste_at(moved, m_selection_p1 + offset);
+  layer.history.end_action();
+
+  m_selection_p1 += offset;
+  m_selection_p2 += offset;
+}
+
+/** Does NOT take tilemap offset in consideration. */
+bool
+EditorTilemap::selection_contains(const Vector& tilemap_point) const
+{
+  return m_has_selection
+         && tilemap_point.x >= m_selection_p1.x
+         && tilemap_point.y >= m_selection_p1.y
+         && tilemap_point.x <= m_selection_p2.x
+         && tilemap_point.y <= m_selection_p2.y;
 }
 
 /** Does NOT take tilemap offset in consideration. */
@@ -17,38 +17,166 @@
 #ifndef HEADER_STM_EDITOR_EDITORTILEMAP_HPP
 #define HEADER_STM_EDITOR_EDITORTILEMAP_HPP
 
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "editor/editor_camera.hpp"
+#include "editor/editor_history.hpp"
+#include "editor/editor_io.hpp"
 #include "editor/editor_tilebox.hpp"
+#include "level/mapped_tilemap.hpp"
+#include "level/solid_mask.hpp"
+#include "level/tile_clipboard.hpp"
+#include "level/tilemap.hpp"
 #include "util/vector.hpp"
 #include "video/drawing_context.hpp"
 
+/**
+ * The level being edited, made of layers of tiles drawn in order. Tools
+ * always work on the selected layer; each layer has its own tiles, offset and
+ * undo history, so editing one layer never touches the others.
+ */
 class EditorTilemap final
 {
+public:
+  enum class Tool
+  {
+    BRUSH,
+    LINE,
+    RECTANGLE,
+    FILL,
+    SELECT
+  };
+
+public:
+  static uint32_t get_max_tile_id();
+  static const std::vector<std::string>& get_tile_textures();
+  static const std::vector<bool>& get_solid_tiles();
+
 public:
   EditorTilemap();
 
   void event(const SDL_Event& event);
   void update(float dt_sec);
   void draw(DrawingContext& context) const;
+  bool needs_redraw() const;
 
   void load_tilemap(const std::string& file);
-  void save_tilemap(const std::string& file) const;
+  void save_tilemap(const std::string& file, bool compress = true);
+  void open_mapped(const std::string& file);
+
+  void undo();
+  void redo();
+
+  const Tilemap& get_interactive_tilemap() const;
+  Vector get_mouse_tile() const;
+
+  void add_layer(const std::string& name);
+  void select_layer(size_t index);
+  void toggle_layer_visibility();
+  void change_layer_opacity(float delta);
+
+  void copy_selection();
+  void cut_selection();
+  void paste();
 
   void set_tile_id(size_t id);
+  void set_tool(Tool tool);
   void resize_tilemap_to(const Vector& tilemap_point);
+  void resize_tilemap_to(const Vector& p1, const Vector& p2);
 
   Vector screen_to_tilemap(const Vector& screen_point) const;
   Vector tilemap_to_screen(const Vector& tilemap_point) const;
 
 private:
-  std::vector<std::vector<int>> m_tilemap;
+  class CachedTile final
+  {
+  public:
+    uint32_t x;
+    uint32_t y;
+    uint32_t id;
+  };
+
+  class Layer final
+  {
+  public:
+    Layer(const std::string& layer_name, uint32_t max_id);
+
+  public:
+    std::string name;
+    Tilemap tilemap;
+    /** Solid tiles of the tilemap, updated along with every edit */
+    SolidMask solids;
+    /** Position of the world origin in the tilemap, in tiles */
+    Vector offset;
+    EditorHistory history;
+    bool visible;
+    float opacity;
+
+    /** Visible tiles, kept until the tiles or the visible area change */
+    mutable std::vector<CachedTile> cache;
+    mutable bool cache_valid;
+    mutable uint64_t cache_hash;
+    mutable size_t cache_x1;
+    mutable size_t cache_y1;
+    mutable size_t cache_x2;
+    mutable size_t cache_y2;
+
+  private:
+    Layer(const Layer&) = delete;
+    Layer& operator=(const Layer&) = delete;
+  };
+
+private:
+  Layer& get_layer();
+  const Layer& get_layer() const;
+  void end_stroke();
+  void replay_history(Layer& layer, bool redo);
+
+  void get_visible_area(const DrawingContext& context, const Vector& offset,
+                        size_t width, size_t height, size_t& x1, size_t& y1,
+                        size_t& x2, size_t& y2) const;
+  void draw_layer(DrawingContext& context, const Layer& layer) const;
+  void draw_mapped(DrawingContext& context) const;
+  void draw_grid(DrawingContext& context, const Vector& offset, size_t width,
+                 size_t height) const;
+
+  void paint_at(const Vector& screen_point);
+  void paint_line(const Vector& p1, const Vector& p2);
+  void set_tile(size_t x, size_t y, uint32_t id);
+  void fill_rect(const Vector& p1, const Vector& p2);
+  void fill_tiles(const Vector& p1, const Vector& p2, uint32_t id);
+  void flood_at(const Vector& screen_point);
+  void paste_at(const TileClipboard& clipboard, const Vector& tilemap_point);
+  void copy_selection_to(TileClipboard& clipboard) const;
+  void move_selection(const Vector& offset);
+  bool selection_contains(const Vector& tilemap_point) const;
+
+private:
+  std::vector<std::unique_ptr<Layer>> m_layers;
+  size_t m_layer;
+  std::unique_ptr<MappedTilemap> m_mapped;
+  EditorIO m_io;
+  /** Layer being saved or loaded */
+  size_t m_io_layer;
+  bool m_painting;
+  Tool m_tool;
+  bool m_drawing_rect;
+  Vector m_rect_start;
+  bool m_has_selection;
+  /** Corners of the selection, both included */
+  Vector m_selection_p1;
+  Vector m_selection_p2;
+  bool m_moving;
+  Vector m_move_start;
+  TileClipboard m_clipboard;
   EditorCamera m_camera;
   EditorTilebox m_tilebox;
-  Vector m_tilemap_offset;
   size_t m_tile_id;
   Vector m_mouse_pos;
+  /** Whether something changed outside of events since the last draw */
+  mutable bool m_redraw;
 
 private:
   EditorTilemap(const EditorTilemap&) = delete;
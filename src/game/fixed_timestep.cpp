@@ -0,0 +1,84 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "game/fixed_timestep.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @param tick_rate Number of updates per second of game time.
+ * @param max_ticks Most updates to run for a single frame. When the machine
+ *                  can't keep up, the game slows down instead of spending ever
+ *                  longer catching up.
+ */
+FixedTimestep::FixedTimestep(float tick_rate, int max_ticks) :
+  m_tick_duration(0.0f),
+  m_accumulator(0.0f),
+  m_max_ticks(max_ticks)
+{
+  set_tick_rate(tick_rate);
+}
+
+void
+FixedTimestep::set_tick_rate(float tick_rate)
+{
+  if (!(tick_rate > 0.0f))
+    throw std::invalid_argument("Tick rate must be positive");
+
+  m_tick_duration = 1.0f / tick_rate;
+}
+
+/** Returns the game time simulated by each update, in seconds. */
+float
+FixedTimestep::get_tick_duration() const
+{
+  return m_tick_duration;
+}
+
+/** Returns the time elapsed since the last update, in ticks, in [0, 1). */
+float
+FixedTimestep::get_alpha() const
+{
+  return m_accumulator / m_tick_duration;
+}
+
+/**
+ * Accounts for @p elapsed_sec seconds of real time.
+ *
+ * @returns The number of updates to run now.
+ */
+int
+FixedTimestep::advance(float elapsed_sec)
+{
+  if (elapsed_sec > 0.0f)
+    m_accumulator += elapsed_sec;
+
+  int ticks = 0;
+
+  while (m_accumulator >= m_tick_duration && ticks < m_max_ticks)
+  {
+    m_accumulator -= m_tick_duration;
+    ticks++;
+  }
+
+  // Whole ticks beyond the cap are dropped rather than caught up on later;
+  // the remainder is kept, so that the phase of the ticks doesn't jump
+  if (m_accumulator >= m_tick_duration)
+    m_accumulator = std::fmod(m_accumulator, m_tick_duration);
+
+  return ticks;
+}
@@ -0,0 +1,51 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_GAME_FIXEDTIMESTEP_HPP
+#define HEADER_STM_GAME_FIXEDTIMESTEP_HPP
+
+/**
+ * Turns the real time elapsed between frames into a number of updates of a
+ * fixed duration, so that the game runs at the same speed and the same way on
+ * every machine, whatever the frame rate.
+ *
+ * Time which doesn't make a whole tick is kept for the next frame; the
+ * fraction of a tick it represents is the interpolation alpha, with which
+ * drawing can blend the last two updates.
+ */
+class FixedTimestep final
+{
+public:
+  FixedTimestep(float tick_rate, int max_ticks);
+
+  void set_tick_rate(float tick_rate);
+  float get_tick_duration() const;
+  float get_alpha() const;
+
+  int advance(float elapsed_sec);
+
+private:
+  float m_tick_duration;
+  /** Real time not simulated yet, in seconds */
+  float m_accumulator;
+  int m_max_ticks;
+
+private:
+  FixedTimestep(const FixedTimestep&) = delete;
+  FixedTimestep& operator=(const FixedTimestep&) = delete;
+};
+
+#endif
@@ -0,0 +1,103 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "game/frame_pacer.hpp"
+
+#include <stdexcept>
+#include <thread>
+
+const float FramePacer::MAX_PERIOD = 1.0f;
+
+/** How long before a deadline to stop sleeping and start spinning */
+static const std::chrono::microseconds g_spin_time(2000);
+
+/**
+ * @param period_sec Time between the start of two frames, in seconds. 0 lets
+ *                   frames run as fast as they can.
+ */
+FramePacer::FramePacer(float period_sec) :
+  m_period(),
+  m_deadline(Clock::now()),
+  m_missed(0)
+{
+  set_period(period_sec);
+}
+
+void
+FramePacer::set_period(float period_sec)
+{
+  if (!(period_sec >= 0.0f))
+    throw std::invalid_argument("Frame period can't be negative");
+
+  // Also rejects infinity, which can't be converted to a duration
+  if (!(period_sec <= MAX_PERIOD))
+    throw std::invalid_argument("Frame period can't exceed a second");
+
+  m_period = std::chrono::duration_cast<Clock::duration>(
+                               std::chrono::duration<float>(period_sec));
+}
+
+/** Returns the time between the start of two frames, in seconds. */
+float
+FramePacer::get_period() const
+{
+  return std::chrono::duration<float>(m_period).count();
+}
+
+/** Returns the number of frames which took longer than the period. */
+unsigned long
+FramePacer::get_missed() const
+{
+  return m_missed;
+}
+
+/** Makes the next frame start one period from now. */
+void
+FramePacer::reset()
+{
+  m_deadline = Clock::now();
+}
+
+/**
+ * Waits until the next frame should start.
+ *
+ * @returns true if the frame ended in time, false if the deadline was already
+ *          past. Missed deadlines aren't caught up on: the next frame gets a
+ *          full period again.
+ */
+bool
+FramePacer::wait()
+{
+  m_deadline += m_period;
+  auto now = Clock::now();
+
+  if (now > m_deadline)
+  {
+    if (m_period != Clock::duration::zero())
+      m_missed++;
+
+    m_deadline = now;
+    return m_period == Clock::duration::zero();
+  }
+
+  if (m_deadline - now > g_spin_time)
+    std::this_thread::sleep_for(m_deadline - now - g_spin_time);
+
+  while (Clock::now() < m_deadline)
+    std::this_thread::yield();
+
+  return true;
+}
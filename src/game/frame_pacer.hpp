@@ -0,0 +1,59 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_GAME_FRAMEPACER_HPP
+#define HEADER_STM_GAME_FRAMEPACER_HPP
+
+#include <chrono>
+
+/**
+ * Keeps frames a regular distance apart by waiting until the deadline of the
+ * next frame, rather than for a fixed time after each frame whatever it took.
+ *
+ * Most of the wait is a sleep, which the system may stretch by a millisecond
+ * or two; the end of it is spent spinning so that frames start on time.
+ */
+class FramePacer final
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+public:
+  /** Longest period allowed, in seconds */
+  static const float MAX_PERIOD;
+
+public:
+  FramePacer(float period_sec);
+
+  void set_period(float period_sec);
+  float get_period() const;
+  unsigned long get_missed() const;
+
+  void reset();
+  bool wait();
+
+private:
+  Clock::duration m_period;
+  Clock::time_point m_deadline;
+  /** Number of frames which ended after their deadline */
+  unsigned long m_missed;
+
+private:
+  FramePacer(const FramePacer&) = delete;
+  FramePacer& operator=(const FramePacer&) = delete;
+};
+
+#endif
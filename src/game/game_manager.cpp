@@ -16,9 +16,15 @@
 
 #include "game/game_manager.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #ifdef EMSCRIPTEN
 #include "emscripten.h"
@@ -28,10 +34,13 @@
 #include "SDL2/SDL_image.h"
 #include "SDL2/SDL_ttf.h"
 
+#include "editor/editor_tilemap.hpp"
+#include "level/level_validator.hpp"
 #include "scenes/level_editor.hpp"
 #include "tests/tests.hpp"
 #include "util/fs.hpp"
 #include "util/log.hpp"
+#include "util/profiler.hpp"
 #include "video/drawing_context.hpp"
 #include "video/window.hpp"
 
@@ -41,6 +50,9 @@
 
 #define STARTING_SCENE LevelEditor
 
+// Longest time to wait for an event while there is nothing new to draw
+#define IDLE_TIMEOUT_MS 250
+
 #define STRVER(X) (std::to_string((X).major) + "." + std::to_string((X).minor)\
                   + "." + std::to_string((X).patch))
 
@@ -58,10 +70,15 @@ GameManager::GameManager() :
   m_scene_manager(this),
   m_return_code(1),
   m_arg_data_folder(""),
+  m_arg_validate_dir(""),
+  m_arg_trace_file(""),
   m_window(),
   m_context(),
+  m_render_thread(),
   m_last_time(),
-  m_delay(0.01f)
+  m_timestep(100.0f, 5),
+  m_pacer(0.01f),
+  m_perf_overlay()
 {
 }
 
@@ -71,6 +88,23 @@ GameManager::run(int argc, const char* const* argv)
   if (!parse_cli_args(argc, argv))
     return m_return_code;
 
+  if (!m_arg_trace_file.empty())
+  {
+#ifndef STM_PROFILING
+    log_warning << "Built without STM_PROFILING, the trace will be empty"
+                << std::endl;
+#endif
+    Profiler::set_enabled(true);
+    Profiler::set_thread_name("Main");
+  }
+
+  if (!m_arg_validate_dir.empty())
+  {
+    int return_code = validate_levels(argv[0]);
+    write_trace();
+    return return_code;
+  }
+
   if (!init(argv[0]))
     return m_return_code;
 
@@ -79,14 +113,26 @@ GameManager::run(int argc, const char* const* argv)
       break;
 
   deinit();
+  write_trace();
 
   return m_return_code;
 }
 
+/**
+ * Sets the time between the start of two frames, in seconds. 0 draws frames as
+ * fast as possible.
+ */
 void
 GameManager::set_delay(float delay)
 {
-  m_delay = delay;
+  m_pacer.set_period(delay);
+}
+
+/** Sets the number of updates per second of game time. */
+void
+GameManager::set_tick_rate(float tick_rate)
+{
+  m_timestep.set_tick_rate(tick_rate);
 }
 
 /**
@@ -131,17 +177,80 @@ GameManager::parse_cli_args(int argc, const char* const* argv)
               << "Options:\n"
               << "  -d, --data [PATH]   Change the data folder\n"
               << "  -h, --help          Show this help text and exit\n"
+              << "  -m, --max-fps [FPS] Draw at most FPS frames per second, "
+                 "or as many as\n"
+              << "                      possible if 0, else at least 1\n"
               << "  -t, --test          Run the test suite\n"
+              << "  -T, --trace [FILE]  Save how long each part of the game "
+                 "took to FILE, in\n"
+              << "                      the Chrome trace format\n"
+              << "  -l, --validate-levels [DIR]\n"
+              << "                      Check the levels in DIR and print "
+                 "their statistics\n"
+              << "                      as JSON, without opening a window\n"
               << "  -v, --version       Show version info and exit\n"
               << std::flush;
       m_return_code = 0;
       return false;
     }
+    else if (arg == "-m" || arg == "--max-fps")
+    {
+      if (++i >= argc)
+      {
+        log_fatal << "Missing number after '--max-fps'" << std::endl;
+        m_return_code = 1;
+        return false;
+      }
+
+      char* end;
+      float fps = std::strtof(argv[i], &end);
+
+      if (!*argv[i] || *end || !(fps >= 0.0f))
+      {
+        log_fatal << "Invalid frame rate '" << argv[i] << "'" << std::endl;
+        m_return_code = 1;
+        return false;
+      }
+
+      // Tiny rates would make the delay between frames overflow
+      if (fps > 0.0f && fps < 1.0f / FramePacer::MAX_PERIOD)
+      {
+        log_fatal << "Frame rate '" << argv[i] << "' must be 0 or at least "
+                  << 1.0f / FramePacer::MAX_PERIOD << std::endl;
+        m_return_code = 1;
+        return false;
+      }
+
+      set_delay(fps > 0.0f ? 1.0f / fps : 0.0f);
+    }
     else if (arg == "-t" || arg == "--test")
     {
       m_return_code = run_tests(argc, argv);
       return false;
     }
+    else if (arg == "-T" || arg == "--trace")
+    {
+      if (++i >= argc || !*argv[i])
+      {
+        log_fatal << "Missing file after '--trace'" << std::endl;
+        m_return_code = 1;
+        return false;
+      }
+
+      m_arg_trace_file = argv[i];
+    }
+    else if (arg == "-l" || arg == "--validate-levels")
+    {
+      if (++i >= argc || !*argv[i])
+      {
+        log_fatal << "Missing directory after '--validate-levels'"
+                  << std::endl;
+        m_return_code = 1;
+        return false;
+      }
+
+      m_arg_validate_dir = argv[i];
+    }
     else if (arg == "-v" || arg == "--version")
     {
       console << "stmeltdown " STM_VERSION << std::endl;
@@ -238,9 +347,8 @@ GameManager::init(const char* arg0)
     return false;
   }
 
-  if (!PHYSFS_init(arg0))
+  if (!init_physfs(arg0))
   {
-    log_fatal << "Could not init PhysFS: " << FS::get_physfs_err() << std::endl;
     TTF_Quit();
     IMG_Quit();
     SDL_Quit();
@@ -253,6 +361,46 @@ GameManager::init(const char* arg0)
               << std::endl;
   }
 
+  bool inited = generic_try([this] {
+    this->m_window = std::make_unique<Window>();
+    this->m_window->set_title("SuperTux Meltdown " STM_VERSION);
+    this->m_render_thread = std::make_unique<RenderThread>(*this->m_window,
+                                                           this->m_context);
+    this->m_last_time = std::chrono::steady_clock::now();
+    this->m_pacer.reset();
+
+    auto& ctrl = this->m_scene_manager.get_controller();
+    this->m_scene_manager.push_scene(std::make_unique<STARTING_SCENE>(ctrl));
+  });
+
+  if (!inited)
+  {
+    log_fatal << "Couldn't load resources" << std::endl;
+    deinit();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Loads PhysFS and mounts the data and user directories. Only failing to load
+ * PhysFS is an error; the game can go on without any of the directories.
+ *
+ * @param arg0 The value of argv[0].
+ *
+ * @returns true if PhysFS was loaded, false otherwise. If true is returned,
+ *          PHYSFS_deinit() should be called once PhysFS is no longer needed.
+ */
+bool
+GameManager::init_physfs(const char* arg0)
+{
+  if (!PHYSFS_init(arg0))
+  {
+    log_fatal << "Could not init PhysFS: " << FS::get_physfs_err() << std::endl;
+    return false;
+  }
+
   if (m_arg_data_folder.empty())
   {
     // None of the PhysFS functions below may error and/or return null
@@ -304,24 +452,59 @@ GameManager::init(const char* arg0)
               << FS::get_physfs_err() << std::endl;
   }
 
-  bool inited = generic_try([this] {
-    this->m_window = std::make_unique<Window>();
-    this->m_last_time = std::chrono::steady_clock::now();
+  return true;
+}
 
-    this->m_window->set_title("SuperTux Meltdown " STM_VERSION);
+/**
+ * Checks every level under the directory given with `--validate-levels` and
+ * prints a report in JSON on the standard output. Only PhysFS is loaded, so
+ * this works without a display.
+ *
+ * @param arg0 The value of argv[0]. Necessary to load PhysFS.
+ *
+ * @returns The code to exit with: 0 if all levels are valid, 1 otherwise.
+ */
+int
+GameManager::validate_levels(const char* arg0)
+{
+  if (!init_physfs(arg0))
+    return 1;
 
-    auto& ctrl = this->m_scene_manager.get_controller();
-    this->m_scene_manager.push_scene(std::make_unique<STARTING_SCENE>(ctrl));
-  });
+  int code = 1;
 
-  if (!inited)
+  try
   {
-    log_fatal << "Couldn't load resources" << std::endl;
-    deinit();
-    return false;
+    std::vector<std::string> files;
+
+    for (const auto& file : FS::list_files(m_arg_validate_dir))
+      if (LevelValidator::is_level(file))
+        files.push_back(file);
+
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    auto reports = LevelValidator::validate(files,
+                                            EditorTilemap::get_max_tile_id(),
+                                            threads);
+
+    LevelValidator::write_json(console, reports);
+
+    code = std::all_of(reports.begin(), reports.end(),
+                       [] (const LevelValidator::Report& report) {
+      return report.error.empty();
+    }) ? 0 : 1;
+  }
+  catch (const std::exception& e)
+  {
+    log_fatal << "Could not validate levels: " << e.what() << std::endl;
   }
 
-  return true;
+  if (!PHYSFS_deinit())
+  {
+    log_error << "Problem when closing PhysFS: " << FS::get_physfs_err()
+              << std::endl;
+    code = 1;
+  }
+
+  return code;
 }
 
 /**
@@ -354,18 +537,48 @@ GameManager::main_loop()
 /**
  * Performs a single game loop.
  *
- * This takes care of handling the events, calculating the delta time, and
- * rendering on the window, by using the appropriate functions on the
- * `m_scene_manager`.
+ * This takes care of handling the events, running as many fixed-length updates
+ * as the elapsed time calls for, and rendering on the window, by using the
+ * appropriate functions on the `m_scene_manager`.
+ *
+ * Frames are only drawn if an event happened or if the scene has changed on
+ * its own. Otherwise, or if the window can't be seen, this waits until the
+ * next event, but no longer than `IDLE_TIMEOUT_MS` so that updates still run
+ * now and then.
  *
  * This may be called independently from `main_loop()`.
  */
 void
 GameManager::single_loop()
 {
+  STM_PROFILE_SCOPE("GameManager::single_loop");
+
+  auto start = std::chrono::steady_clock::now();
+  bool redraw = false;
+
+  // The render thread may be using the renderer, which reacts to the events
+  // when they are pumped, so they are read without pumping them
+  m_render_thread->pump_events();
+
   SDL_Event e;
-  while (SDL_PollEvent(&e) && !m_scene_manager.empty())
+  while (SDL_PeepEvents(&e, 1, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) > 0
+         && !m_scene_manager.empty())
   {
+    redraw = true;
+
+    if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3
+        && !e.key.repeat)
+    {
+      m_perf_overlay.toggle();
+      continue;
+    }
+
+    if (e.type == SDL_RENDER_TARGETS_RESET
+        || e.type == SDL_RENDER_DEVICE_RESET)
+    {
+      m_context.reset_targets(e.type == SDL_RENDER_DEVICE_RESET);
+    }
+
     m_scene_manager.event(e);
 
     if (e.type == SDL_QUIT)
@@ -384,20 +597,83 @@ GameManager::single_loop()
                 / static_cast<float>(decltype(time)::period::den);
   m_last_time = time;
 
-  m_scene_manager.update(0.01f);
+  int ticks = m_timestep.advance(diff);
+
+  for (int i = 0; i < ticks && !m_scene_manager.empty(); i++)
+    m_scene_manager.update(m_timestep.get_tick_duration());
 
   if (m_scene_manager.empty())
     return;
 
+  auto updated = std::chrono::steady_clock::now();
+
+  bool shown = m_window->get_visible()
+               && m_window->get_status() != Window::Status::MINIMIZED;
+
+  if (!shown || (!redraw && !m_scene_manager.needs_redraw()
+                 && !m_perf_overlay.needs_redraw()))
+  {
+    // In browsers, this function is already called once per frame and must
+    // return quickly
+#ifndef EMSCRIPTEN
+    STM_PROFILE_SCOPE("idle");
+    m_render_thread->wait_events(IDLE_TIMEOUT_MS);
+    m_pacer.reset();
+#endif
+    return;
+  }
+
   m_context.target_size = m_window->get_size();
+  m_context.alpha = m_timestep.get_alpha();
 
   m_scene_manager.draw(m_context);
+  auto drawn = std::chrono::steady_clock::now();
+  m_perf_overlay.draw(m_context);
+
+  {
+    // Drawn while the next frame is prepared
+    STM_PROFILE_SCOPE("submit");
+    m_render_thread->submit();
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  m_perf_overlay.set_missed(m_pacer.get_missed());
+  m_perf_overlay.record(std::chrono::duration<float>(end - start).count(),
+                        std::chrono::duration<float>(updated - time).count(),
+                        std::chrono::duration<float>(drawn - updated).count(),
+                        m_context.get_render_stats());
+
+  STM_PROFILE_SCOPE("wait");
+  if (!m_pacer.wait())
+  {
+    // Only when the count reaches a power of two, so that slow levels don't
+    // flood the log; the F3 overlay shows the exact count
+    unsigned long missed = m_pacer.get_missed();
+
+    if ((missed & (missed - 1)) == 0)
+      log_debug << "Frames took longer than " << m_pacer.get_period()
+                << "s (" << missed << " so far)" << std::endl;
+  }
+}
 
+/**
+ * Saves the timings recorded by the profiler to the file given with `--trace`,
+ * if any. Must be called once the other threads are stopped.
+ */
+void
+GameManager::write_trace()
+{
+  if (m_arg_trace_file.empty())
+    return;
 
-  m_context.render(m_window->get_renderer());
-  m_context.clear();
+  Profiler::set_enabled(false);
 
-  SDL_Delay(static_cast<int>(m_delay * 1000.0f));
+  std::ofstream file(m_arg_trace_file);
+  Profiler::write_trace(file);
+
+  if (!file)
+    log_error << "Could not write trace to '" << m_arg_trace_file << "'"
+              << std::endl;
 }
 
 /**
@@ -420,6 +696,7 @@ GameManager::deinit()
 {
   bool success = true;
 
+  m_render_thread = nullptr;
   m_window = nullptr;
   m_context.reset();
 
@@ -473,9 +750,11 @@ GameManager::recover()
 
   log_debug << "Attempting to reset data..." << std::endl;
 
+  m_render_thread = nullptr;
   m_window = std::make_unique<Window>();
   m_window->set_title("SuperTux Meltdown " STM_VERSION);
   m_context.reset();
+  m_render_thread = std::make_unique<RenderThread>(*m_window, m_context);
 
   if (generic_try([this] { this->single_loop(); }))
   {
@@ -20,8 +20,12 @@
 #include <chrono>
 #include <string>
 
+#include "game/fixed_timestep.hpp"
+#include "game/frame_pacer.hpp"
+#include "game/perf_overlay.hpp"
 #include "game/scene_manager.hpp"
 #include "video/drawing_context.hpp"
+#include "video/render_thread.hpp"
 #include "video/window.hpp"
 
 /**
@@ -47,14 +51,18 @@ public:
   int run(int argc, const char* const* argv);
 
   void set_delay(float delay);
+  void set_tick_rate(float tick_rate);
 
 private:
   bool parse_cli_args(int argc, const char* const* argv);
   bool init(const char* arg0);
+  bool init_physfs(const char* arg0);
+  int validate_levels(const char* arg0);
   bool main_loop();
   void single_loop();
   bool deinit();
   bool recover();
+  void write_trace();
 
   template<typename F> bool generic_try(F func);
 
@@ -62,8 +70,12 @@ private:
   SceneManager m_scene_manager;
   int m_return_code;
   std::string m_arg_data_folder;
+  std::string m_arg_validate_dir;
+  std::string m_arg_trace_file;
   std::unique_ptr<Window> m_window;
   DrawingContext m_context;
+  // Uses the window and the context, so it must be destroyed before them
+  std::unique_ptr<RenderThread> m_render_thread;
   // https://en.cppreference.com/w/cpp/chrono/steady_clock says:
   //   "This clock [...] is most suitable for measuring intervals."
   // std::chrono::high_resolution_clock is merely an alias to another clock,
@@ -71,7 +83,9 @@ private:
   // the user changes their computer time, including back in time. See the
   // notes: https://en.cppreference.com/w/cpp/chrono/high_resolution_clock
   std::chrono::steady_clock::time_point m_last_time;
-  float m_delay;
+  FixedTimestep m_timestep;
+  FramePacer m_pacer;
+  PerfOverlay m_perf_overlay;
 
 private:
   GameManager(const GameManager&) = delete;
@@ -0,0 +1,213 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "game/perf_overlay.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+/** Number of frames in the graph and the percentiles */
+static const size_t g_samples = 120;
+static const float g_refresh_sec = 0.25f;
+
+static const float g_bar_width = 2.0f;
+static const float g_graph_height = 60.0f;
+/** Frame time at the top of the graph, in seconds */
+static const float g_graph_max_sec = 1.0f / 30.0f;
+static const float g_graph_target_sec = 1.0f / 60.0f;
+
+PerfOverlay::PerfOverlay() :
+  m_visible(false),
+  m_frame_times(g_samples, 0.0f),
+  m_next_frame(0),
+  m_frames_kept(0),
+  m_refresh_start(),
+  m_frames(0),
+  m_update_sec(0.0f),
+  m_draw_sec(0.0f),
+  m_render_sec(0.0f),
+  m_present_sec(0.0f),
+  m_hud_sec(0.0f),
+  m_missed(0),
+  m_text("Measuring..."),
+  m_graph(),
+  m_redraw(false)
+{
+}
+
+/** Shows or hides the overlay, forgetting the frames recorded so far. */
+void
+PerfOverlay::toggle()
+{
+  m_visible = !m_visible;
+  m_next_frame = 0;
+  m_frames_kept = 0;
+  m_refresh_start = Clock::now();
+  m_frames = 0;
+  m_update_sec = m_draw_sec = m_render_sec = m_present_sec = m_hud_sec = 0.0f;
+  m_text = "Measuring...";
+  m_graph.clear();
+  m_redraw = true;
+}
+
+bool
+PerfOverlay::is_visible() const
+{
+  return m_visible;
+}
+
+/**
+ * Records a frame which was just drawn. Does nothing while hidden.
+ *
+ * @param frame_sec Time spent on the whole frame, without waiting.
+ * @param update_sec Time spent updating the scenes, part of @p frame_sec.
+ * @param draw_sec Time spent drawing the scenes, part of @p frame_sec.
+ * @param stats What rendering the last rendered frame took.
+ */
+void
+PerfOverlay::record(float frame_sec, float update_sec, float draw_sec,
+                    const DrawingContext::RenderStats& stats)
+{
+  if (!m_visible)
+    return;
+
+  m_frame_times[m_next_frame] = frame_sec;
+  m_next_frame = (m_next_frame + 1) % g_samples;
+  m_frames_kept = std::min(m_frames_kept + 1, g_samples);
+
+  m_frames++;
+  m_update_sec += update_sec;
+  m_draw_sec += draw_sec;
+  m_render_sec += stats.draw_sec;
+  m_present_sec += stats.present_sec;
+
+  float elapsed = std::chrono::duration<float>(Clock::now()
+                                               - m_refresh_start).count();
+
+  if (elapsed >= g_refresh_sec)
+    refresh(elapsed, stats);
+}
+
+/** Sets the number of frames which missed their deadline, shown as "late". */
+void
+PerfOverlay::set_missed(unsigned long missed)
+{
+  m_missed = missed;
+}
+
+/** Returns true if what the overlay shows changed since it was last drawn. */
+bool
+PerfOverlay::needs_redraw() const
+{
+  return m_visible && m_redraw;
+}
+
+/** Draws the overlay in the top left corner of the target, if visible. */
+void
+PerfOverlay::draw(DrawingContext& context) const
+{
+  if (!m_visible)
+    return;
+
+  auto start = Clock::now();
+  float graph_width = static_cast<float>(g_samples) * g_bar_width;
+
+  context.draw_filled_rect(Rect(8.0f, 8.0f, 24.0f + graph_width, 176.0f),
+                           Color(0.0f, 0.0f, 0.0f, 0.6f), Blend::BLEND);
+  context.draw_text(m_text, "fonts/SuperTux-Medium.ttf", true, 12,
+                    TextAlign::TOP_LEFT,
+                    Rect(16.0f, 16.0f, 16.0f + graph_width, 96.0f),
+                    Color(1.0f, 1.0f, 1.0f), Blend::BLEND, false);
+
+  float bottom = 168.0f;
+  float x = 16.0f + graph_width - g_bar_width * m_graph.size();
+
+  for (float frame_sec : m_graph)
+  {
+    float height = std::min(frame_sec / g_graph_max_sec, 1.0f)
+                   * g_graph_height;
+    Color color = frame_sec <= g_graph_target_sec ? Color(0.2f, 0.8f, 0.2f)
+                : frame_sec <= g_graph_max_sec ? Color(0.9f, 0.8f, 0.1f)
+                : Color(0.9f, 0.2f, 0.1f);
+
+    context.draw_filled_rect(Rect(x, bottom - height, x + g_bar_width, bottom),
+                             color, Blend::NONE);
+    x += g_bar_width;
+  }
+
+  float target = bottom - g_graph_target_sec / g_graph_max_sec
+                          * g_graph_height;
+  context.draw_line(Vector(16.0f, target), Vector(16.0f + graph_width, target),
+                    Color(1.0f, 1.0f, 1.0f, 0.5f), Blend::BLEND);
+
+  m_redraw = false;
+  m_hud_sec += std::chrono::duration<float>(Clock::now() - start).count();
+}
+
+/**
+ * Returns the value under which @p fraction of the samples are.
+ *
+ * @throws std::invalid_argument if there are no samples.
+ */
+float
+PerfOverlay::get_percentile(std::vector<float> samples, float fraction)
+{
+  if (samples.empty())
+    throw std::invalid_argument("Can't get percentile of no samples");
+
+  float pos = fraction * static_cast<float>(samples.size() - 1);
+  size_t index = static_cast<size_t>(std::max(0.0f, pos + 0.5f));
+  index = std::min(index, samples.size() - 1);
+
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+/** Updates what is shown from the totals since the last refresh. */
+void
+PerfOverlay::refresh(float elapsed_sec,
+                     const DrawingContext::RenderStats& stats)
+{
+  // Oldest first
+  m_graph.clear();
+  size_t first = (m_next_frame + g_samples - m_frames_kept) % g_samples;
+  for (size_t i = 0; i < m_frames_kept; i++)
+    m_graph.push_back(m_frame_times[(first + i) % g_samples]);
+
+  float frames = static_cast<float>(m_frames);
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(1)
+       << "FPS " << frames / elapsed_sec << ", " << m_missed << " late\n"
+       << std::setprecision(2)
+       << "Frame p50 " << get_percentile(m_graph, 0.5f) * 1000.0f
+       << " ms, p99 " << get_percentile(m_graph, 0.99f) * 1000.0f << " ms\n"
+       << "Update " << m_update_sec / frames * 1000.0f
+       << ", draw " << m_draw_sec / frames * 1000.0f
+       << ", HUD " << m_hud_sec / frames * 1000.0f << " ms\n"
+       << "Render " << m_render_sec / frames * 1000.0f
+       << ", present " << m_present_sec / frames * 1000.0f << " ms\n"
+       << "Draw calls " << stats.draw_calls << ", textures "
+       << std::setprecision(1)
+       << static_cast<float>(stats.texture_bytes) / 1048576.0f << " MiB";
+  m_text = text.str();
+
+  m_refresh_start = Clock::now();
+  m_frames = 0;
+  m_update_sec = m_draw_sec = m_render_sec = m_present_sec = m_hud_sec = 0.0f;
+  m_redraw = true;
+}
@@ -0,0 +1,86 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_GAME_PERFOVERLAY_HPP
+#define HEADER_STM_GAME_PERFOVERLAY_HPP
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "video/drawing_context.hpp"
+
+/**
+ * Shows how fast frames are made, on top of every scene.
+ *
+ * Frame times only count the time spent working on a frame, not the time
+ * spent waiting for events or for the next frame; they are what would limit
+ * the frame rate.
+ *
+ * To keep its own cost low, the overlay changes a few times per second only,
+ * and always draws the same small number of requests.
+ */
+class PerfOverlay final
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+public:
+  PerfOverlay();
+
+  void toggle();
+  bool is_visible() const;
+
+  void record(float frame_sec, float update_sec, float draw_sec,
+              const DrawingContext::RenderStats& stats);
+  void set_missed(unsigned long missed);
+  bool needs_redraw() const;
+  void draw(DrawingContext& context) const;
+
+  static float get_percentile(std::vector<float> samples, float fraction);
+
+private:
+  void refresh(float elapsed_sec, const DrawingContext::RenderStats& stats);
+
+private:
+  bool m_visible;
+  /** Recent frame times, in seconds, as a ring buffer */
+  std::vector<float> m_frame_times;
+  size_t m_next_frame;
+  size_t m_frames_kept;
+
+  // Totals since the last refresh
+  Clock::time_point m_refresh_start;
+  unsigned long m_frames;
+  float m_update_sec;
+  float m_draw_sec;
+  float m_render_sec;
+  float m_present_sec;
+  mutable float m_hud_sec;
+  /** Frames which missed their deadline since the game started */
+  unsigned long m_missed;
+
+  // What is shown, as of the last refresh
+  std::string m_text;
+  std::vector<float> m_graph;
+  mutable bool m_redraw;
+
+private:
+  PerfOverlay(const PerfOverlay&) = delete;
+  PerfOverlay& operator=(const PerfOverlay&) = delete;
+};
+
+#endif
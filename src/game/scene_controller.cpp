@@ -18,6 +18,7 @@
 
 #include "game/game_manager.hpp"
 #include "game/scene_manager.hpp"
+#include "scenes/loading_scene.hpp"
 
 DefaultSceneController::DefaultSceneController(SceneManager* scene_manager,
                                                GameManager* game_manager) :
@@ -37,6 +38,21 @@ DefaultSceneController::push_scene(std::unique_ptr<Scene> scene)
   return !!m_scene_manager;
 }
 
+/**
+ * Pushes the scene made by @p factory on a worker thread, see LoadingScene.
+ * Until then, a loading screen is shown above the current scene.
+ */
+bool
+DefaultSceneController::push_scene_async(SceneFactory factory)
+{
+  if (m_scene_manager)
+    m_scene_manager->push_scene(std::make_unique<LoadingScene>(
+                                                        *this,
+                                                        std::move(factory)));
+
+  return !!m_scene_manager;
+}
+
 bool
 DefaultSceneController::pop_scene()
 {
@@ -54,3 +70,12 @@ DefaultSceneController::set_delay(float delay)
 
   return !!m_game_manager;
 }
+
+bool
+DefaultSceneController::set_tick_rate(float tick_rate)
+{
+  if (m_game_manager)
+    m_game_manager->set_tick_rate(tick_rate);
+
+  return !!m_game_manager;
+}
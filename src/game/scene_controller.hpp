@@ -17,6 +17,7 @@
 #ifndef HEADER_STM_GAME_SCENECONTROLLER_HPP
 #define HEADER_STM_GAME_SCENECONTROLLER_HPP
 
+#include <functional>
 #include <memory>
 
 class Scene;
@@ -27,13 +28,18 @@ class SceneManager;
 // the Scene class from the SceneManager class.
 class SceneController
 {
+public:
+  typedef std::function<std::unique_ptr<Scene>()> SceneFactory;
+
 public:
   SceneController() = default;
   virtual ~SceneController() = default;
 
   virtual bool push_scene(std::unique_ptr<Scene> scene) = 0;
+  virtual bool push_scene_async(SceneFactory factory) = 0;
   virtual bool pop_scene() = 0;
   virtual bool set_delay(float delay) = 0;
+  virtual bool set_tick_rate(float tick_rate) = 0;
 
 private:
   SceneController(const SceneController&) = delete;
@@ -49,8 +55,10 @@ public:
   virtual ~DefaultSceneController() override = default;
 
   virtual bool push_scene(std::unique_ptr<Scene> scene) override;
+  virtual bool push_scene_async(SceneFactory factory) override;
   virtual bool pop_scene() override;
   virtual bool set_delay(float delay) override;
+  virtual bool set_tick_rate(float tick_rate) override;
 
 private:
   SceneManager* m_scene_manager;
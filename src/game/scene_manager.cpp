@@ -19,10 +19,13 @@
 #include <stdexcept>
 
 #include "game/game_manager.hpp"
+#include "util/profiler.hpp"
 
 SceneManager::SceneManager(GameManager* game_manager) :
   m_controller(this, game_manager),
-  m_scenes()
+  m_scenes(),
+  m_changed(false),
+  m_frozen()
 {
 }
 
@@ -30,6 +33,7 @@ void
 SceneManager::push_scene(std::unique_ptr<Scene> scene)
 {
   m_scenes.push_back(std::move(scene));
+  m_changed = true;
 }
 
 void
@@ -38,7 +42,9 @@ SceneManager::pop_scene()
   if (m_scenes.size() < 1)
     throw std::runtime_error("Cannot pop scene: stack empty");
 
+  m_frozen.erase(m_scenes.back().get());
   m_scenes.pop_back();
+  m_changed = true;
 }
 
 SceneController&
@@ -62,12 +68,15 @@ SceneManager::empty() const
 void
 SceneManager::quit()
 {
+  m_frozen.clear();
   m_scenes.clear();
 }
 
 void
 SceneManager::event(const SDL_Event& event)
 {
+  STM_PROFILE_SCOPE("SceneManager::event");
+
   if (!m_scenes.empty())
     m_scenes.back()->event(event);
 }
@@ -75,13 +84,91 @@ SceneManager::event(const SDL_Event& event)
 void
 SceneManager::update(float dt_sec)
 {
-  if (!m_scenes.empty())
-    m_scenes.back()->update(dt_sec);
+  STM_PROFILE_SCOPE("SceneManager::update");
+
+  // Scenes pushed meanwhile are first updated on the next tick, and scenes may
+  // be popped by those updated before them
+  size_t count = m_scenes.size();
+
+  for (size_t i = 0; i < count && i < m_scenes.size(); i++)
+    if (i + 1 == count || m_scenes[i]->updates_in_background())
+      m_scenes[i]->update(dt_sec);
 }
 
 void
 SceneManager::draw(DrawingContext& context) const
 {
-  if (!m_scenes.empty())
-    m_scenes.back()->draw(context);
+  STM_PROFILE_SCOPE("SceneManager::draw");
+
+  m_changed = false;
+
+  for (size_t i = get_first_drawn(); i < m_scenes.size(); i++)
+  {
+    const Scene* scene = m_scenes[i].get();
+
+    if (!is_suspended(i))
+    {
+      m_frozen.erase(scene);
+      scene->draw(context);
+      continue;
+    }
+
+    // Recorded once, then drawn from a texture until the scene is back on top
+    auto& frozen = m_frozen[scene];
+
+    if (!frozen || frozen->size != context.target_size)
+    {
+      frozen = context.record_layer([scene] (DrawingContext& layer_context) {
+        scene->draw(layer_context);
+      });
+    }
+
+    context.draw_layer(frozen);
+  }
+}
+
+bool
+SceneManager::needs_redraw() const
+{
+  if (m_changed)
+    return true;
+
+  for (size_t i = get_first_drawn(); i < m_scenes.size(); i++)
+  {
+    if (is_suspended(i) && m_frozen.count(m_scenes[i].get()))
+      continue;
+
+    if (m_scenes[i]->needs_redraw())
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * Returns the index of the topmost opaque scene, which hides all the scenes
+ * beneath it, or 0 if there is none.
+ */
+size_t
+SceneManager::get_first_drawn() const
+{
+  for (size_t i = m_scenes.size(); i > 0; i--)
+    if (m_scenes[i - 1]->is_opaque())
+      return i - 1;
+
+  return 0;
+}
+
+/**
+ * Returns whether the scene at @p index can't change until it is back on top,
+ * because it gets neither events nor updates, or it has nothing new to draw.
+ */
+bool
+SceneManager::is_suspended(size_t index) const
+{
+  if (index + 1 >= m_scenes.size())
+    return false;
+
+  const Scene& scene = *m_scenes[index];
+  return !scene.updates_in_background() || !scene.needs_redraw();
 }
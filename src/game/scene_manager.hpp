@@ -18,10 +18,12 @@
 #define HEADER_STM_GAME_SCENEMANAGER_HPP
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "game/scene_controller.hpp"
 #include "scenes/scene.hpp"
+#include "video/drawing_context.hpp"
 
 class GameManager;
 
@@ -47,10 +49,21 @@ public:
   void event(const SDL_Event& event);
   void update(float dt_sec);
   void draw(DrawingContext& context) const;
+  bool needs_redraw() const;
+
+private:
+  size_t get_first_drawn() const;
+  bool is_suspended(size_t index) const;
 
 private:
   DefaultSceneController m_controller;
   std::vector<std::unique_ptr<Scene>> m_scenes;
+  /** Whether the scene on top changed since the last draw */
+  mutable bool m_changed;
+  /** Last frames of the suspended scenes, drawn instead of the scenes */
+  mutable std::unordered_map<const Scene*,
+                             std::shared_ptr<const DrawingContext::Layer>>
+    m_frozen;
 
 private:
   SceneManager(const SceneManager&) = delete;
@@ -0,0 +1,436 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/level_bmp.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "util/fs.hpp"
+#include "util/profiler.hpp"
+
+typedef std::unique_ptr<SDL_RWops, void (*) (SDL_RWops*)> RWopsPtr;
+
+// Compression methods, as defined by the BMP format
+static const uint32_t g_bi_rgb = 0;
+static const uint32_t g_bi_bitfields = 3;
+static const uint32_t g_bi_alphabitfields = 6;
+
+static const size_t g_file_header_size = 14;
+static const size_t g_info_header_size = 40;
+static const size_t g_v4_header_size = 108;
+static const size_t g_v5_header_size = 124;
+
+// Windows color space, "Win " in little-endian
+static const uint32_t g_lcs_windows_color_space = 0x57696e20;
+
+struct BmpChannel
+{
+  uint32_t mask;
+  uint32_t shift;
+  uint32_t bits;
+};
+
+static void
+close_rwops(SDL_RWops* ops)
+{
+  // Errors when closing a file that was only read can safely be ignored
+  SDL_RWclose(ops);
+}
+
+static void
+read_bytes(SDL_RWops* ops, void* data, size_t size)
+{
+  if (size && SDL_RWread(ops, data, size, 1) != 1)
+    throw std::runtime_error("Unexpected end of file");
+}
+
+static void
+write_bytes(SDL_RWops* ops, const void* data, size_t size)
+{
+  if (size && SDL_RWwrite(ops, data, size, 1) != 1)
+    throw std::runtime_error("Write error: " + std::string(SDL_GetError()));
+}
+
+static uint32_t
+get_u32(const Uint8* data)
+{
+  return static_cast<uint32_t>(data[0])
+       | static_cast<uint32_t>(data[1]) << 8
+       | static_cast<uint32_t>(data[2]) << 16
+       | static_cast<uint32_t>(data[3]) << 24;
+}
+
+static uint16_t
+get_u16(const Uint8* data)
+{
+  return static_cast<uint16_t>(data[0] | data[1] << 8);
+}
+
+static void
+put_u32(Uint8* data, uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+    data[i] = static_cast<Uint8>(value >> (i * 8));
+}
+
+static void
+put_u16(Uint8* data, uint16_t value)
+{
+  data[0] = static_cast<Uint8>(value);
+  data[1] = static_cast<Uint8>(value >> 8);
+}
+
+static BmpChannel
+make_channel(uint32_t mask)
+{
+  BmpChannel channel = { mask, 0, 0 };
+
+  if (!mask)
+    return channel;
+
+  while (!(mask & 1))
+  {
+    mask >>= 1;
+    channel.shift++;
+  }
+
+  while (mask & 1)
+  {
+    mask >>= 1;
+    channel.bits++;
+  }
+
+  return channel;
+}
+
+/** Scales the channel's value to 8 bits. */
+static uint32_t
+extract_channel(const BmpChannel& channel, uint32_t pixel)
+{
+  if (!channel.mask)
+    return 0;
+
+  uint32_t value = (pixel & channel.mask) >> channel.shift;
+
+  if (channel.bits >= 8)
+    return value >> (channel.bits - 8);
+
+  return value * 255 / ((1u << channel.bits) - 1);
+}
+
+/** Whether @p file should be handled as a BMP image, from its extension. */
+bool
+LevelBmp::is_bmp(const std::string& file)
+{
+  return file.size() >= 4 && file.compare(file.size() - 4, 4, ".bmp") == 0;
+}
+
+void
+LevelBmp::save(const Tilemap& tilemap, const std::string& file)
+{
+  RWopsPtr ops(FS::get_rwops(file, FS::OP::WRITE), close_rwops);
+
+  try
+  {
+    save(tilemap, ops.get());
+  }
+  catch (const std::exception& e)
+  {
+    throw std::runtime_error("Can't save BMP '" + file + "': " + e.what());
+  }
+
+  // Closing flushes the file, so errors here mean the image wasn't saved
+  if (SDL_RWclose(ops.release()))
+  {
+    throw std::runtime_error("Can't save BMP '" + file + "': "
+                             + std::string(SDL_GetError()));
+  }
+}
+
+Tilemap
+LevelBmp::load(const std::string& file, uint32_t max_id)
+{
+  RWopsPtr ops(FS::get_rwops(file, FS::OP::READ), close_rwops);
+
+  try
+  {
+    return load(ops.get(), max_id);
+  }
+  catch (const std::exception& e)
+  {
+    throw std::runtime_error("Can't load file " + file + ": " + e.what());
+  }
+}
+
+/**
+ * Writes @p tilemap as a 32 bits ARGB bottom-up BMP, the same layout as the one
+ * SDL_SaveBMP() produces for ARGB8888 surfaces. The RWops is not closed.
+ */
+void
+LevelBmp::save(const Tilemap& tilemap, SDL_RWops* ops)
+{
+  STM_PROFILE_SCOPE("LevelBmp::save");
+
+  uint64_t width = tilemap.get_width();
+  uint64_t height = tilemap.get_height();
+  uint64_t stride = width * 4;
+  uint64_t image_size = stride * height;
+  uint64_t offset = g_file_header_size + g_v4_header_size;
+
+  if (width > 0x7fffffff || height > 0x7fffffff
+      || image_size + offset > 0xffffffff)
+  {
+    throw std::runtime_error("Level too big to be stored as a BMP");
+  }
+
+  Uint8 header[g_file_header_size + g_v4_header_size] = {};
+
+  header[0] = 'B';
+  header[1] = 'M';
+  put_u32(header + 2, static_cast<uint32_t>(offset + image_size));
+  put_u32(header + 10, static_cast<uint32_t>(offset));
+
+  Uint8* info = header + g_file_header_size;
+  put_u32(info, static_cast<uint32_t>(g_v4_header_size));
+  put_u32(info + 4, static_cast<uint32_t>(width));
+  put_u32(info + 8, static_cast<uint32_t>(height));
+  put_u16(info + 12, 1);
+  put_u16(info + 14, 32);
+  put_u32(info + 16, g_bi_bitfields);
+  put_u32(info + 20, static_cast<uint32_t>(image_size));
+  put_u32(info + 40, 0x00ff0000);
+  put_u32(info + 44, 0x0000ff00);
+  put_u32(info + 48, 0x000000ff);
+  put_u32(info + 52, 0xff000000);
+  put_u32(info + 56, g_lcs_windows_color_space);
+
+  write_bytes(ops, header, sizeof(header));
+
+  std::vector<Uint8> row_buffer(static_cast<size_t>(stride));
+
+  tilemap.visit([&] (const auto& grid) {
+    // Rows are stored bottom-up
+    for (size_t y = static_cast<size_t>(height); y-- > 0;)
+    {
+      const auto* row = grid.get_row(y);
+
+      for (size_t x = 0; x < width; x++)
+        put_u32(row_buffer.data() + x * 4, row[x] ^ 0xff000000);
+
+      write_bytes(ops, row_buffer.data(), row_buffer.size());
+    }
+  });
+}
+
+/**
+ * Reads a BMP from @p ops, one row at a time. The RWops is not closed.
+ *
+ * @param max_id The largest valid tile ID. Images containing bigger IDs are
+ *               rejected.
+ */
+Tilemap
+LevelBmp::load(SDL_RWops* ops, uint32_t max_id)
+{
+  STM_PROFILE_SCOPE("LevelBmp::load");
+
+  Sint64 start = SDL_RWtell(ops);
+
+  Uint8 file_header[g_file_header_size];
+  read_bytes(ops, file_header, sizeof(file_header));
+
+  if (file_header[0] != 'B' || file_header[1] != 'M')
+    throw std::runtime_error("Not a BMP file");
+
+  uint32_t pixel_offset = get_u32(file_header + 10);
+
+  // Only the fields up to BITMAPV5HEADER are used; the rest is skipped
+  Uint8 info[g_v5_header_size] = {};
+  read_bytes(ops, info, 4);
+
+  uint32_t info_size = get_u32(info);
+
+  if (info_size < g_info_header_size)
+    throw std::runtime_error("Unsupported BMP header");
+
+  read_bytes(ops, info + 4,
+             std::min(static_cast<size_t>(info_size), g_v5_header_size) - 4);
+
+  if (info_size > g_v5_header_size)
+    SDL_RWseek(ops, info_size - g_v5_header_size, RW_SEEK_CUR);
+
+  auto width = static_cast<int32_t>(get_u32(info + 4));
+  auto height = static_cast<int32_t>(get_u32(info + 8));
+  uint16_t bpp = get_u16(info + 14);
+  uint32_t compression = get_u32(info + 16);
+  uint32_t colors_used = get_u32(info + 32);
+
+  // The lowest height has no positive counterpart
+  if (height == std::numeric_limits<int32_t>::min())
+    throw std::runtime_error("Invalid BMP height");
+
+  bool top_down = height < 0;
+  height = top_down ? -height : height;
+
+  if (width < 0)
+    throw std::runtime_error("Invalid BMP width");
+
+  if (bpp != 1 && bpp != 4 && bpp != 8 && bpp != 16 && bpp != 24 && bpp != 32)
+    throw std::runtime_error("Unsupported BMP depth " + std::to_string(bpp));
+
+  uint32_t masks[4] = {};
+
+  switch (compression)
+  {
+    case g_bi_rgb:
+      if (bpp == 16)
+      {
+        masks[0] = 0x7c00;
+        masks[1] = 0x03e0;
+        masks[2] = 0x001f;
+      }
+      else
+      {
+        masks[0] = 0x00ff0000;
+        masks[1] = 0x0000ff00;
+        masks[2] = 0x000000ff;
+        masks[3] = (bpp == 32) ? 0xff000000 : 0;
+      }
+      break;
+
+    case g_bi_bitfields:
+    case g_bi_alphabitfields:
+      if (bpp != 16 && bpp != 32)
+        throw std::runtime_error("Invalid BMP bitfields");
+
+      if (info_size == g_info_header_size)
+      {
+        // The masks follow the header
+        Uint8 buf[16] = {};
+        int count = (compression == g_bi_alphabitfields) ? 4 : 3;
+        read_bytes(ops, buf, count * 4);
+
+        for (int i = 0; i < count; i++)
+          masks[i] = get_u32(buf + i * 4);
+      }
+      else
+      {
+        for (int i = 0; i < 4; i++)
+          masks[i] = get_u32(info + 40 + i * 4);
+      }
+      break;
+
+    default:
+      throw std::runtime_error("Unsupported BMP compression "
+                               + std::to_string(compression));
+  }
+
+  BmpChannel channels[4];
+  for (int i = 0; i < 4; i++)
+    channels[i] = make_channel(masks[i]);
+
+  // SDL considers a 32 bits image without bitfields to have no alpha if the
+  // alpha bytes are all zero. Since the image is read one row at a time, this
+  // is approximated per pixel.
+  bool zero_alpha_is_opaque = (bpp == 32 && compression == g_bi_rgb);
+
+  std::vector<uint32_t> palette;
+
+  if (bpp <= 8)
+  {
+    uint32_t count = colors_used ? colors_used : (1u << bpp);
+
+    if (count > 256)
+      throw std::runtime_error("Invalid BMP palette");
+
+    std::vector<Uint8> buf(count * 4);
+    read_bytes(ops, buf.data(), buf.size());
+
+    for (uint32_t i = 0; i < count; i++)
+      palette.push_back(0xff000000 | (get_u32(buf.data() + i * 4) & 0xffffff));
+  }
+
+  if (SDL_RWseek(ops, start + pixel_offset, RW_SEEK_SET) < 0)
+    throw std::runtime_error("Can't seek to BMP pixels");
+
+  size_t stride = ((static_cast<size_t>(bpp) * width + 31) / 32) * 4;
+  std::vector<Uint8> row_buffer(stride);
+
+  Tilemap tilemap(max_id);
+  tilemap.resize(width, height, 0, 0, 0);
+
+  tilemap.visit([&] (auto& grid) {
+    for (int32_t i = 0; i < height; i++)
+    {
+      read_bytes(ops, row_buffer.data(), row_buffer.size());
+
+      int32_t y = top_down ? i : height - 1 - i;
+      auto* row = grid.get_row(y);
+      const Uint8* in = row_buffer.data();
+
+      for (int32_t x = 0; x < width; x++)
+      {
+        uint32_t argb = 0;
+
+        if (bpp <= 8)
+        {
+          uint32_t bit = static_cast<uint32_t>(x) * bpp;
+          uint32_t index = (in[bit / 8] >> (8 - bpp - bit % 8))
+                         & ((1u << bpp) - 1);
+
+          if (index >= palette.size())
+            throw std::runtime_error("BMP palette index out of range");
+
+          argb = palette[index];
+        }
+        else
+        {
+          uint32_t pixel = 0;
+          for (uint16_t b = 0; b < bpp / 8; b++)
+            pixel |= static_cast<uint32_t>(in[x * (bpp / 8) + b]) << (b * 8);
+
+          uint32_t alpha = channels[3].mask ? extract_channel(channels[3],
+                                                              pixel) : 0xff;
+
+          if (alpha == 0 && zero_alpha_is_opaque)
+            alpha = 0xff;
+
+          argb = alpha << 24
+               | extract_channel(channels[0], pixel) << 16
+               | extract_channel(channels[1], pixel) << 8
+               | extract_channel(channels[2], pixel);
+        }
+
+        uint32_t tile = argb ^ 0xff000000;
+
+        if (tile > max_id)
+        {
+          throw std::runtime_error("tile overflow " + std::to_string(tile)
+                                   + " at location " + std::to_string(x) + "x"
+                                   + std::to_string(y));
+        }
+
+        row[x] = tile;
+      }
+    }
+  });
+
+  return tilemap;
+}
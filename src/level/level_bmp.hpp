@@ -0,0 +1,48 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_LEVELBMP_HPP
+#define HEADER_STM_LEVEL_LEVELBMP_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "SDL2/SDL.h"
+
+#include "level/tilemap.hpp"
+
+/**
+ * Imports and exports levels as BMP images, where each pixel is a tile whose ID
+ * is the pixel's RGB value (the alpha channel must be opaque).
+ *
+ * The images are processed one row at a time, directly from and to the RWops,
+ * so only a single row of pixels is ever held in memory besides the tilemap.
+ * Uncompressed 1, 4, 8, 16, 24 and 32 bits images are supported, top-down or
+ * bottom-up, with or without bitfields.
+ */
+class LevelBmp final
+{
+public:
+  static bool is_bmp(const std::string& file);
+
+  static void save(const Tilemap& tilemap, const std::string& file);
+  static Tilemap load(const std::string& file, uint32_t max_id);
+
+  static void save(const Tilemap& tilemap, SDL_RWops* ops);
+  static Tilemap load(SDL_RWops* ops, uint32_t max_id);
+};
+
+#endif
@@ -0,0 +1,643 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/level_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "util/fs.hpp"
+#include "util/profiler.hpp"
+
+typedef std::unique_ptr<SDL_RWops, void (*) (SDL_RWops*)> RWopsPtr;
+
+const uint16_t LevelFile::VERSION = 1;
+const uint32_t LevelFile::CHUNK_ROWS = 64;
+const uint32_t LevelFile::MAX_SIZE = 1 << 16;
+// 1 GiB with 32-bit IDs
+const uint64_t LevelFile::MAX_TILES = 1 << 28;
+
+static const char g_magic[4] = { 'S', 'T', 'M', 'L' };
+
+// Magic (4), version (2), ID bytes (1), reserved (1), width, height, chunk rows
+static const size_t g_header_size = 4 + 2 + 1 + 1 + 4 + 4 + 4;
+
+// Offset (8), size (4), encoding (1)
+static const size_t g_toc_entry_size = 8 + 4 + 1;
+
+// TOC offset (8), chunk count (4), magic (4)
+static const size_t g_footer_size = 8 + 4 + 4;
+
+/** Throws if a level of @p width x @p height tiles is too big. */
+static void
+check_size(uint64_t width, uint64_t height)
+{
+  if (width > LevelFile::MAX_SIZE || height > LevelFile::MAX_SIZE
+      || width * height > LevelFile::MAX_TILES)
+  {
+    throw std::runtime_error("Level too big (" + std::to_string(width) + "x"
+                             + std::to_string(height) + " tiles)");
+  }
+}
+
+static void
+close_rwops(SDL_RWops* ops)
+{
+  // Errors when closing a file that was only read can safely be ignored
+  SDL_RWclose(ops);
+}
+
+static uint32_t
+get_id_bytes(Tilemap::IdWidth id_width)
+{
+  switch (id_width)
+  {
+    case Tilemap::IdWidth::BITS_8:
+      return 1;
+
+    case Tilemap::IdWidth::BITS_16:
+      return 2;
+
+    case Tilemap::IdWidth::BITS_32:
+      return 4;
+  }
+
+  return 4;
+}
+
+static void
+write_varint(std::vector<Uint8>& out, uint32_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(static_cast<Uint8>(value | 0x80));
+    value >>= 7;
+  }
+
+  out.push_back(static_cast<Uint8>(value));
+}
+
+static uint32_t
+read_varint(const Uint8*& in, const Uint8* end)
+{
+  uint32_t value = 0;
+
+  for (int shift = 0; shift < 35; shift += 7)
+  {
+    if (in == end)
+      throw std::runtime_error("Truncated chunk data");
+
+    Uint8 byte = *in++;
+    value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+
+    if (!(byte & 0x80))
+      return value;
+  }
+
+  throw std::runtime_error("Invalid varint in chunk data");
+}
+
+template<typename T>
+static void
+encode_rle(const TileGrid<T>& grid, size_t y1, size_t y2,
+           std::vector<Uint8>& out)
+{
+  size_t width = grid.get_width();
+
+  // Runs are allowed to continue from one row to the next
+  T current = 0;
+  uint32_t run = 0;
+
+  for (size_t y = y1; y < y2; y++)
+  {
+    const T* row = grid.get_row(y);
+    size_t x = 0;
+
+    while (x < width)
+    {
+      if (run == 0 || row[x] != current)
+      {
+        if (run)
+        {
+          write_varint(out, run);
+          write_varint(out, current);
+        }
+
+        current = row[x];
+        run = 0;
+      }
+
+      size_t end = x;
+      while (end < width && row[end] == current)
+        end++;
+
+      run += static_cast<uint32_t>(end - x);
+      x = end;
+    }
+  }
+
+  if (run)
+  {
+    write_varint(out, run);
+    write_varint(out, current);
+  }
+}
+
+template<typename T>
+static void
+encode_raw(const TileGrid<T>& grid, size_t y1, size_t y2, uint32_t id_bytes,
+           std::vector<Uint8>& out)
+{
+  for (size_t y = y1; y < y2; y++)
+  {
+    const T* row = grid.get_row(y);
+
+    for (size_t x = 0; x < grid.get_width(); x++)
+    {
+      uint32_t id = row[x];
+
+      for (uint32_t i = 0; i < id_bytes; i++)
+        out.push_back(static_cast<Uint8>(id >> (i * 8)));
+    }
+  }
+}
+
+template<typename T>
+static void
+decode_chunk(const std::vector<Uint8>& in, LevelFile::Encoding encoding,
+             uint32_t id_bytes, uint32_t max_id, TileGrid<T>& grid, size_t y1,
+             size_t y2)
+{
+  size_t width = grid.get_width();
+  size_t count = (y2 - y1) * width;
+  size_t pos = 0;
+
+  const Uint8* data = in.data();
+  const Uint8* end = data + in.size();
+
+  while (pos < count)
+  {
+    uint32_t run = 1;
+    uint32_t id = 0;
+
+    switch (encoding)
+    {
+      case LevelFile::Encoding::RAW:
+        if (static_cast<size_t>(end - data) < id_bytes)
+          throw std::runtime_error("Truncated chunk data");
+
+        for (uint32_t i = 0; i < id_bytes; i++)
+          id |= static_cast<uint32_t>(*data++) << (i * 8);
+        break;
+
+      case LevelFile::Encoding::RLE:
+        run = read_varint(data, end);
+        id = read_varint(data, end);
+
+        if (run == 0 || run > count - pos)
+          throw std::runtime_error("Invalid run length in chunk data");
+        break;
+    }
+
+    if (id > max_id)
+    {
+      throw std::runtime_error("tile overflow " + std::to_string(id)
+                               + " at location " + std::to_string(pos % width)
+                               + "x" + std::to_string(y1 + pos / width));
+    }
+
+    // Fill the run row by row
+    while (run > 0)
+    {
+      size_t y = y1 + pos / width;
+      size_t x = pos % width;
+      size_t n = std::min(static_cast<size_t>(run), width - x);
+
+      T* row = grid.get_row(y);
+      std::fill(row + x, row + x + n, static_cast<T>(id));
+
+      pos += n;
+      run -= static_cast<uint32_t>(n);
+    }
+  }
+
+  if (data != end)
+    throw std::runtime_error("Trailing data at the end of a chunk");
+}
+
+static void
+write_bytes(SDL_RWops* ops, const void* data, size_t size)
+{
+  if (size && SDL_RWwrite(ops, data, size, 1) != 1)
+    throw std::runtime_error("Write error: " + std::string(SDL_GetError()));
+}
+
+static void
+read_bytes(SDL_RWops* ops, void* data, size_t size)
+{
+  if (size && SDL_RWread(ops, data, size, 1) != 1)
+    throw std::runtime_error("Unexpected end of file");
+}
+
+static void
+write_u8(std::vector<Uint8>& out, uint8_t value)
+{
+  out.push_back(value);
+}
+
+static void
+write_u16(std::vector<Uint8>& out, uint16_t value)
+{
+  for (int i = 0; i < 2; i++)
+    out.push_back(static_cast<Uint8>(value >> (i * 8)));
+}
+
+static void
+write_u32(std::vector<Uint8>& out, uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+    out.push_back(static_cast<Uint8>(value >> (i * 8)));
+}
+
+static void
+write_u64(std::vector<Uint8>& out, uint64_t value)
+{
+  for (int i = 0; i < 8; i++)
+    out.push_back(static_cast<Uint8>(value >> (i * 8)));
+}
+
+static uint64_t
+read_uint(const Uint8*& in, int bytes)
+{
+  uint64_t value = 0;
+
+  for (int i = 0; i < bytes; i++)
+    value |= static_cast<uint64_t>(*in++) << (i * 8);
+
+  return value;
+}
+
+/**
+ * Reads and validates the header, the footer and the table of contents of the
+ * level in @p ops.
+ */
+static void
+read_index(SDL_RWops* ops, uint32_t& width, uint32_t& height,
+           uint32_t& id_bytes, uint32_t& chunk_rows, uint64_t& toc_offset,
+           std::vector<Uint8>& toc)
+{
+  Uint8 header[g_header_size];
+  read_bytes(ops, header, sizeof(header));
+
+  if (std::memcmp(header, g_magic, 4))
+    throw std::runtime_error("Not a level file (invalid magic)");
+
+  const Uint8* in = header + 4;
+  auto version = read_uint(in, 2);
+  id_bytes = static_cast<uint32_t>(read_uint(in, 1));
+  in++; // Reserved
+  width = static_cast<uint32_t>(read_uint(in, 4));
+  height = static_cast<uint32_t>(read_uint(in, 4));
+  chunk_rows = static_cast<uint32_t>(read_uint(in, 4));
+
+  if (version > LevelFile::VERSION)
+  {
+    throw std::runtime_error("Unsupported format version "
+                             + std::to_string(version));
+  }
+
+  if (id_bytes != 1 && id_bytes != 2 && id_bytes != 4)
+    throw std::runtime_error("Invalid tile ID size");
+
+  if (chunk_rows == 0)
+    throw std::runtime_error("Invalid chunk size");
+
+  check_size(width, height);
+
+  uint32_t chunk_count = height / chunk_rows + (height % chunk_rows ? 1 : 0);
+
+  Sint64 file_size = SDL_RWsize(ops);
+
+  if (file_size < static_cast<Sint64>(g_header_size + g_footer_size)
+      || SDL_RWseek(ops, file_size - g_footer_size, RW_SEEK_SET) < 0)
+  {
+    throw std::runtime_error("Can't read level footer");
+  }
+
+  Uint8 footer[g_footer_size];
+  read_bytes(ops, footer, sizeof(footer));
+
+  in = footer;
+  toc_offset = read_uint(in, 8);
+  auto footer_chunk_count = static_cast<uint32_t>(read_uint(in, 4));
+
+  if (std::memcmp(in, g_magic, 4) || footer_chunk_count != chunk_count)
+    throw std::runtime_error("Corrupted level footer");
+
+  // The table of contents must fit between the header and the footer
+  uint64_t toc_size = static_cast<uint64_t>(chunk_count) * g_toc_entry_size;
+  uint64_t toc_end = static_cast<uint64_t>(file_size) - g_footer_size;
+
+  if (toc_offset < g_header_size || toc_size > toc_end - g_header_size
+      || toc_offset > toc_end - toc_size)
+  {
+    throw std::runtime_error("Corrupted table of contents");
+  }
+
+  toc.resize(static_cast<size_t>(toc_size));
+
+  if (SDL_RWseek(ops, toc_offset, RW_SEEK_SET) < 0)
+    throw std::runtime_error("Can't read table of contents");
+
+  read_bytes(ops, toc.data(), toc.size());
+}
+
+void
+LevelFile::save(const Tilemap& tilemap, const std::string& file, bool compress,
+                const ProgressCallback& progress, SaveCache* cache)
+{
+  RWopsPtr ops(FS::get_rwops(file, FS::OP::WRITE), close_rwops);
+
+  try
+  {
+    save(tilemap, ops.get(), compress, progress, cache);
+  }
+  catch (const std::exception& e)
+  {
+    throw std::runtime_error("Can't save level '" + file + "': " + e.what());
+  }
+
+  // Closing flushes the file, so errors here mean the level wasn't saved
+  if (SDL_RWclose(ops.release()))
+  {
+    throw std::runtime_error("Can't save level '" + file + "': "
+                             + std::string(SDL_GetError()));
+  }
+}
+
+Tilemap
+LevelFile::load(const std::string& file, uint32_t max_id,
+                const ProgressCallback& progress, bool* compressed)
+{
+  RWopsPtr ops(FS::get_rwops(file, FS::OP::READ), close_rwops);
+
+  try
+  {
+    return load(ops.get(), max_id, progress, compressed);
+  }
+  catch (const std::exception& e)
+  {
+    throw std::runtime_error("Can't load level '" + file + "': " + e.what());
+  }
+}
+
+/**
+ * Writes @p tilemap to @p ops, one chunk at a time. The RWops is not closed.
+ *
+ * @param compress If false, all chunks are stored raw, which makes the file
+ *                 usable with get_raw_offset().
+ * @param progress If set, called after each chunk.
+ * @param cache If set and @p compress is true, chunks which are the same as
+ *              in the cache are written without being encoded, and the others
+ *              are stored in the cache after being encoded.
+ */
+void
+LevelFile::save(const Tilemap& tilemap, SDL_RWops* ops, bool compress,
+                const ProgressCallback& progress, SaveCache* cache)
+{
+  STM_PROFILE_SCOPE("LevelFile::save");
+
+  check_size(tilemap.get_width(), tilemap.get_height());
+
+  uint32_t width = static_cast<uint32_t>(tilemap.get_width());
+  uint32_t height = static_cast<uint32_t>(tilemap.get_height());
+  uint32_t id_bytes = get_id_bytes(tilemap.get_id_width());
+  uint32_t chunk_count = (height + CHUNK_ROWS - 1) / CHUNK_ROWS;
+
+  std::vector<Uint8> buffer;
+
+  buffer.insert(buffer.end(), g_magic, g_magic + 4);
+  write_u16(buffer, VERSION);
+  write_u8(buffer, static_cast<uint8_t>(id_bytes));
+  write_u8(buffer, 0);
+  write_u32(buffer, width);
+  write_u32(buffer, height);
+  write_u32(buffer, CHUNK_ROWS);
+  write_bytes(ops, buffer.data(), buffer.size());
+
+  uint64_t offset = buffer.size();
+  std::vector<Uint8> toc;
+  std::vector<Uint8> raw;
+
+  // Raw chunks are as fast to encode as to copy, don't bother caching them
+  if (!compress)
+    cache = nullptr;
+
+  if (cache)
+    cache->resize(chunk_count);
+
+  for (uint32_t chunk = 0; chunk < chunk_count; chunk++)
+  {
+    size_t y1 = chunk * CHUNK_ROWS;
+    size_t y2 = std::min(y1 + CHUNK_ROWS, static_cast<size_t>(height));
+
+    uint64_t hash = 0;
+    CachedChunk* cached = cache ? &(*cache)[chunk] : nullptr;
+
+    if (cached)
+    {
+      tilemap.visit([&] (const auto& grid) {
+        hash = grid.get_hash(y1, y2);
+      });
+    }
+
+    const std::vector<Uint8>* data = &buffer;
+    Encoding encoding = Encoding::RLE;
+
+    if (cached && cached->id_bytes == id_bytes && cached->hash == hash)
+    {
+      data = &cached->data;
+      encoding = cached->encoding;
+    }
+    else
+    {
+      buffer.clear();
+
+      if (compress)
+      {
+        tilemap.visit([&] (const auto& grid) {
+          encode_rle(grid, y1, y2, buffer);
+        });
+      }
+
+      // Noisy chunks may get bigger with RLE; store those as-is
+      if (!compress || buffer.size() > (y2 - y1) * width * id_bytes)
+      {
+        raw.clear();
+        tilemap.visit([&] (const auto& grid) {
+          encode_raw(grid, y1, y2, id_bytes, raw);
+        });
+        buffer.swap(raw);
+        encoding = Encoding::RAW;
+      }
+
+      if (cached)
+      {
+        cached->hash = hash;
+        cached->id_bytes = id_bytes;
+        cached->encoding = encoding;
+        cached->data = buffer;
+      }
+    }
+
+    write_bytes(ops, data->data(), data->size());
+
+    write_u64(toc, offset);
+    write_u32(toc, static_cast<uint32_t>(data->size()));
+    write_u8(toc, static_cast<uint8_t>(encoding));
+
+    offset += data->size();
+
+    if (progress)
+      progress(static_cast<float>(chunk + 1) / chunk_count);
+  }
+
+  write_u64(toc, offset);
+  write_u32(toc, chunk_count);
+  toc.insert(toc.end(), g_magic, g_magic + 4);
+  write_bytes(ops, toc.data(), toc.size());
+}
+
+/**
+ * Reads a level from @p ops, one chunk at a time. The RWops is not closed.
+ *
+ * @param max_id The largest valid tile ID. Files containing bigger IDs are
+ *               rejected.
+ * @param progress If set, called after each chunk.
+ * @param compressed If set, receives whether the level was saved compressed,
+ *                   that is whether get_raw_offset() would reject it.
+ */
+Tilemap
+LevelFile::load(SDL_RWops* ops, uint32_t max_id,
+                const ProgressCallback& progress, bool* compressed)
+{
+  STM_PROFILE_SCOPE("LevelFile::load");
+
+  uint32_t width, height, id_bytes, chunk_rows;
+  uint64_t toc_offset;
+  std::vector<Uint8> toc;
+
+  read_index(ops, width, height, id_bytes, chunk_rows, toc_offset, toc);
+
+  uint32_t chunk_count = static_cast<uint32_t>(toc.size() / g_toc_entry_size);
+
+  Tilemap tilemap(max_id);
+  tilemap.resize(width, height, 0, 0, 0);
+
+  std::vector<Uint8> buffer;
+  const Uint8* in = toc.data();
+  uint64_t row_size = static_cast<uint64_t>(width) * id_bytes;
+  uint64_t raw_offset = g_header_size;
+  bool raw = true;
+
+  for (uint32_t chunk = 0; chunk < chunk_count; chunk++)
+  {
+    auto offset = read_uint(in, 8);
+    auto size = static_cast<size_t>(read_uint(in, 4));
+    auto encoding = static_cast<Encoding>(read_uint(in, 1));
+
+    if (encoding != Encoding::RAW && encoding != Encoding::RLE)
+      throw std::runtime_error("Unknown chunk encoding");
+
+    if (offset + size > toc_offset)
+      throw std::runtime_error("Chunk out of bounds");
+
+    size_t y1 = static_cast<size_t>(chunk) * chunk_rows;
+    size_t y2 = std::min(y1 + chunk_rows, static_cast<size_t>(height));
+
+    // Same layout as checked by get_raw_offset()
+    raw = raw && encoding == Encoding::RAW && offset == raw_offset
+          && size == (y2 - y1) * row_size;
+    raw_offset += size;
+
+    buffer.resize(size);
+
+    if (SDL_RWseek(ops, offset, RW_SEEK_SET) < 0)
+      throw std::runtime_error("Can't seek to chunk");
+
+    read_bytes(ops, buffer.data(), buffer.size());
+
+    tilemap.visit([&] (auto& grid) {
+      decode_chunk(buffer, encoding, id_bytes, max_id, grid, y1, y2);
+    });
+
+    if (progress)
+      progress(static_cast<float>(chunk + 1) / chunk_count);
+  }
+
+  if (compressed)
+    *compressed = !raw;
+
+  return tilemap;
+}
+
+/**
+ * Checks that the level in @p ops was saved without compression, in which case
+ * all rows are stored back to back and can be accessed in place.
+ *
+ * @returns The offset of the first row in the file.
+ */
+uint64_t
+LevelFile::get_raw_offset(SDL_RWops* ops, uint32_t& width, uint32_t& height,
+                          uint32_t& id_bytes)
+{
+  uint32_t chunk_rows;
+  uint64_t toc_offset;
+  std::vector<Uint8> toc;
+
+  read_index(ops, width, height, id_bytes, chunk_rows, toc_offset, toc);
+
+  uint64_t row_size = static_cast<uint64_t>(width) * id_bytes;
+  uint64_t expected_offset = g_header_size;
+  uint32_t chunk_count = static_cast<uint32_t>(toc.size() / g_toc_entry_size);
+  const Uint8* in = toc.data();
+
+  for (uint32_t chunk = 0; chunk < chunk_count; chunk++)
+  {
+    auto offset = read_uint(in, 8);
+    auto size = read_uint(in, 4);
+    auto encoding = static_cast<Encoding>(read_uint(in, 1));
+
+    uint64_t y1 = static_cast<uint64_t>(chunk) * chunk_rows;
+    uint64_t y2 = std::min(y1 + chunk_rows, static_cast<uint64_t>(height));
+
+    if (encoding != Encoding::RAW || offset != expected_offset
+        || size != (y2 - y1) * row_size)
+    {
+      throw std::runtime_error("Level is compressed");
+    }
+
+    expected_offset += size;
+  }
+
+  if (expected_offset > toc_offset)
+    throw std::runtime_error("Chunk out of bounds");
+
+  return g_header_size;
+}
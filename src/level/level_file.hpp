@@ -0,0 +1,115 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_LEVELFILE_HPP
+#define HEADER_STM_LEVEL_LEVELFILE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "SDL2/SDL.h"
+
+#include "level/tilemap.hpp"
+
+/**
+ * Reads and writes levels in the native binary format.
+ *
+ * All integers are little-endian. A file is made of:
+ *
+ * - A header: the magic "STML", the format version (u16), the number of bytes
+ *   per tile ID used by raw chunks (u8), a reserved byte, the width and height
+ *   of the level in tiles (u32 each) and the number of rows per chunk (u32).
+ * - The chunks, in order. Each chunk holds a band of rows, compressed on its
+ *   own so that it can be encoded and decoded without the rest of the level.
+ * - The table of contents: for every chunk, its offset in the file (u64), its
+ *   size in bytes (u32) and its encoding (u8).
+ * - A footer: the offset of the table of contents (u64), the number of chunks
+ *   (u32) and the magic "STML" again.
+ *
+ * Since the table of contents is at the end, files are written in a single
+ * sequential pass, one chunk at a time.
+ *
+ * Levels are at most MAX_SIZE tiles wide and high, and MAX_TILES tiles in all.
+ * Bigger levels can't be saved, and files claiming bigger sizes are rejected
+ * before anything is allocated for them.
+ *
+ * Levels saved without compression have all their rows stored back to back
+ * right after the header, which allows them to be memory-mapped and read in
+ * place (see MappedTilemap).
+ */
+class LevelFile final
+{
+public:
+  enum class Encoding
+  {
+    /** Tile IDs stored as-is, with the number of bytes given in the header */
+    RAW = 0,
+    /** Sequence of (run length, tile ID) pairs, both stored as varints */
+    RLE = 1
+  };
+
+  /** Called with the fraction of the work done, between 0 and 1. */
+  typedef std::function<void(float)> ProgressCallback;
+
+  /** Compressed chunk kept from a previous save. */
+  class CachedChunk final
+  {
+  public:
+    /** Hash of the rows of the chunk, see TileGrid::get_hash() */
+    uint64_t hash;
+    /** Bytes per tile ID of the save, 0 if nothing is cached */
+    uint32_t id_bytes;
+    Encoding encoding;
+    std::vector<Uint8> data;
+  };
+
+  /**
+   * Chunks of the last compressed save of a level, by index. Chunks which
+   * didn't change since are written from the cache instead of being encoded
+   * again.
+   */
+  typedef std::vector<CachedChunk> SaveCache;
+
+public:
+  static const uint16_t VERSION;
+  static const uint32_t CHUNK_ROWS;
+  static const uint32_t MAX_SIZE;
+  static const uint64_t MAX_TILES;
+
+public:
+  static void save(const Tilemap& tilemap, const std::string& file,
+                   bool compress = true,
+                   const ProgressCallback& progress = nullptr,
+                   SaveCache* cache = nullptr);
+  static Tilemap load(const std::string& file, uint32_t max_id,
+                      const ProgressCallback& progress = nullptr,
+                      bool* compressed = nullptr);
+
+  static void save(const Tilemap& tilemap, SDL_RWops* ops,
+                   bool compress = true,
+                   const ProgressCallback& progress = nullptr,
+                   SaveCache* cache = nullptr);
+  static Tilemap load(SDL_RWops* ops, uint32_t max_id,
+                      const ProgressCallback& progress = nullptr,
+                      bool* compressed = nullptr);
+
+  static uint64_t get_raw_offset(SDL_RWops* ops, uint32_t& width,
+                                 uint32_t& height, uint32_t& id_bytes);
+};
+
+#endif
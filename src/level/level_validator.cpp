@@ -0,0 +1,166 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/level_validator.hpp"
+
+#include <algorithm>
+#include <exception>
+
+#include "level/level_bmp.hpp"
+#include "level/level_file.hpp"
+#include "util/json.hpp"
+#include "util/parallel.hpp"
+
+LevelValidator::Report::Report(const std::string& level_file) :
+  file(level_file),
+  error(),
+  width(0),
+  height(0),
+  non_empty(0),
+  histogram()
+{
+}
+
+/** Whether @p file is in one of the formats levels can be loaded from. */
+bool
+LevelValidator::is_level(const std::string& file)
+{
+  return LevelBmp::is_bmp(file)
+         || (file.size() >= 5
+             && file.compare(file.size() - 5, 5, ".stml") == 0);
+}
+
+/**
+ * Loads @p file, either in the native format or, if it ends with ".bmp", from
+ * an image, and gathers its statistics. Errors are stored in the report.
+ */
+LevelValidator::Report
+LevelValidator::validate(const std::string& file, uint32_t max_id)
+{
+  Report report(file);
+
+  try
+  {
+    Tilemap tilemap = LevelBmp::is_bmp(file) ? LevelBmp::load(file, max_id)
+                                             : LevelFile::load(file, max_id);
+    gather_stats(tilemap, max_id, report);
+  }
+  catch (const std::exception& e)
+  {
+    report.error = e.what();
+  }
+
+  return report;
+}
+
+/**
+ * Validates all @p files, spread over @p threads threads. The reports are in
+ * the same order as the files.
+ */
+std::vector<LevelValidator::Report>
+LevelValidator::validate(const std::vector<std::string>& files,
+                         uint32_t max_id, size_t threads)
+{
+  std::vector<Report> reports;
+  reports.reserve(files.size());
+
+  for (const auto& file : files)
+    reports.emplace_back(file);
+
+  // One level at a time, so that big levels don't hold back others
+  Parallel::run(files.size(), 1, threads, [&] (size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+      reports[i] = validate(files[i], max_id);
+  });
+
+  return reports;
+}
+
+/**
+ * Fills the size and statistics of @p report from @p tilemap, whose IDs must
+ * not be greater than @p max_id.
+ */
+void
+LevelValidator::gather_stats(const Tilemap& tilemap, uint32_t max_id,
+                             Report& report)
+{
+  report.width = tilemap.get_width();
+  report.height = tilemap.get_height();
+  report.histogram.assign(static_cast<size_t>(max_id) + 1, 0);
+
+  tilemap.visit([&report] (const auto& grid) {
+    for (size_t y = 0; y < grid.get_height(); y++)
+    {
+      const auto* row = grid.get_row(y);
+
+      for (size_t x = 0; x < grid.get_width(); x++)
+        report.histogram[row[x]]++;
+    }
+  });
+
+  report.non_empty = report.width * report.height - report.histogram[0];
+}
+
+/**
+ * Writes @p reports as a JSON object: the number of valid and invalid levels,
+ * and the list of levels with either their statistics or their error.
+ */
+void
+LevelValidator::write_json(std::ostream& out,
+                           const std::vector<Report>& reports)
+{
+  size_t invalid = std::count_if(reports.begin(), reports.end(),
+                                 [] (const Report& report) {
+    return !report.error.empty();
+  });
+
+  out << "{\n  \"valid\": " << reports.size() - invalid
+      << ",\n  \"invalid\": " << invalid << ",\n  \"levels\": [";
+
+  for (size_t i = 0; i < reports.size(); i++)
+  {
+    const Report& report = reports[i];
+
+    out << (i ? ",\n" : "\n") << "    {\n      \"file\": ";
+    Json::write_string(out, report.file);
+
+    if (!report.error.empty())
+    {
+      out << ",\n      \"valid\": false,\n      \"error\": ";
+      Json::write_string(out, report.error);
+      out << "\n    }";
+      continue;
+    }
+
+    size_t tiles = report.width * report.height;
+    double ratio = tiles ? static_cast<double>(report.non_empty)
+                           / static_cast<double>(tiles) : 0.0;
+
+    out << ",\n      \"valid\": true"
+        << ",\n      \"width\": " << report.width
+        << ",\n      \"height\": " << report.height
+        << ",\n      \"non_empty\": " << report.non_empty
+        << ",\n      \"non_empty_ratio\": " << ratio
+        << ",\n      \"histogram\": [";
+
+    for (size_t id = 0; id < report.histogram.size(); id++)
+      out << (id ? ", " : "") << report.histogram[id];
+
+    out << "]\n    }";
+  }
+
+  out << (reports.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
@@ -0,0 +1,68 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_LEVELVALIDATOR_HPP
+#define HEADER_STM_LEVEL_LEVELVALIDATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "level/tilemap.hpp"
+
+/**
+ * Checks batches of levels against a tileset and gathers statistics about
+ * them, for content pipelines. Levels are loaded on several threads at once.
+ *
+ * A level is valid if it can be loaded and all its tile IDs exist in the
+ * tileset, which is the same check as when loading levels in the editor.
+ */
+class LevelValidator final
+{
+public:
+  class Report final
+  {
+  public:
+    Report(const std::string& level_file);
+
+  public:
+    std::string file;
+    /** Why the level is invalid, empty if it is valid */
+    std::string error;
+    size_t width;
+    size_t height;
+    /** Number of tiles other than 0 */
+    size_t non_empty;
+    /** Number of tiles with each ID */
+    std::vector<size_t> histogram;
+  };
+
+public:
+  static bool is_level(const std::string& file);
+
+  static Report validate(const std::string& file, uint32_t max_id);
+  static std::vector<Report> validate(const std::vector<std::string>& files,
+                                      uint32_t max_id, size_t threads);
+  static void gather_stats(const Tilemap& tilemap, uint32_t max_id,
+                           Report& report);
+
+  static void write_json(std::ostream& out,
+                         const std::vector<Report>& reports);
+};
+
+#endif
@@ -0,0 +1,248 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/mapped_tilemap.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#if !defined(EMSCRIPTEN) && !defined(_WIN32)
+#define STM_MAPPED_TILEMAP_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "SDL2/SDL.h"
+
+#include "level/level_file.hpp"
+
+typedef std::unique_ptr<SDL_RWops, int (*) (SDL_RWops*)> RWopsPtr;
+
+bool
+MappedTilemap::is_supported()
+{
+#if defined(STM_MAPPED_TILEMAP_MMAP) && SDL_BYTEORDER == SDL_LIL_ENDIAN
+  return true;
+#else
+  return false;
+#endif
+}
+
+MappedTilemap::MappedTilemap(const std::string& path) :
+  m_width(0),
+  m_height(0),
+  m_id_bytes(0),
+  m_mapping(nullptr),
+  m_mapping_size(0),
+  m_tiles(nullptr),
+  m_overlay()
+{
+  if (!is_supported())
+    throw std::runtime_error("Memory-mapped levels aren't supported here");
+
+  uint32_t width, height, id_bytes;
+  uint64_t offset;
+
+  {
+    // The header is read normally; only the tiles need to be mapped
+    RWopsPtr ops(SDL_RWFromFile(path.c_str(), "rb"), SDL_RWclose);
+
+    if (!ops)
+    {
+      throw std::runtime_error("Can't open level '" + path + "': "
+                               + std::string(SDL_GetError()));
+    }
+
+    try
+    {
+      offset = LevelFile::get_raw_offset(ops.get(), width, height, id_bytes);
+    }
+    catch (const std::exception& e)
+    {
+      throw std::runtime_error("Can't map level '" + path + "': " + e.what());
+    }
+  }
+
+  uint64_t size = offset + static_cast<uint64_t>(width) * height * id_bytes;
+
+  if (size > SIZE_MAX)
+    throw std::runtime_error("Level '" + path + "' is too big to be mapped");
+
+  m_width = width;
+  m_height = height;
+  m_id_bytes = id_bytes;
+
+  if (m_width == 0 || m_height == 0)
+    return;
+
+#ifdef STM_MAPPED_TILEMAP_MMAP
+  int fd = open(path.c_str(), O_RDONLY);
+
+  if (fd < 0)
+  {
+    throw std::runtime_error("Can't open level '" + path + "': "
+                             + std::string(std::strerror(errno)));
+  }
+
+  struct stat info;
+
+  if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < size)
+  {
+    close(fd);
+    throw std::runtime_error("Level '" + path + "' is truncated");
+  }
+
+  // The mapping stays valid after the descriptor is closed
+  void* mapping = mmap(nullptr, static_cast<size_t>(size), PROT_READ,
+                       MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (mapping == MAP_FAILED)
+  {
+    throw std::runtime_error("Can't map level '" + path + "': "
+                             + std::string(std::strerror(errno)));
+  }
+
+  // The camera usually only covers a few rows far apart in the file, so
+  // reading ahead would mostly load tiles that will never be shown
+  madvise(mapping, static_cast<size_t>(size), MADV_RANDOM);
+
+  m_mapping = mapping;
+  m_mapping_size = static_cast<size_t>(size);
+  m_tiles = static_cast<const uint8_t*>(mapping) + offset;
+#endif
+}
+
+MappedTilemap::~MappedTilemap()
+{
+#ifdef STM_MAPPED_TILEMAP_MMAP
+  if (m_mapping)
+    munmap(m_mapping, m_mapping_size);
+#endif
+}
+
+size_t
+MappedTilemap::get_width() const
+{
+  return m_width;
+}
+
+size_t
+MappedTilemap::get_height() const
+{
+  return m_height;
+}
+
+Tilemap::IdWidth
+MappedTilemap::get_id_width() const
+{
+  switch (m_id_bytes)
+  {
+    case 1:
+      return Tilemap::IdWidth::BITS_8;
+
+    case 2:
+      return Tilemap::IdWidth::BITS_16;
+
+    default:
+      return Tilemap::IdWidth::BITS_32;
+  }
+}
+
+/** Returns the number of rows that were modified and copied in memory. */
+size_t
+MappedTilemap::get_overlay_rows() const
+{
+  return m_overlay.size();
+}
+
+uint32_t
+MappedTilemap::get(size_t x, size_t y) const
+{
+  if (x >= m_width || y >= m_height)
+    throw std::out_of_range("Tile out of the mapped level");
+
+  const uint8_t* tile = get_row_data(y) + x * m_id_bytes;
+
+  switch (m_id_bytes)
+  {
+    case 1:
+      return *tile;
+
+    case 2:
+      return *reinterpret_cast<const uint16_t*>(tile);
+
+    default:
+      return *reinterpret_cast<const uint32_t*>(tile);
+  }
+}
+
+/**
+ * Changes a tile in memory only. The first change in a row copies that row in
+ * the overlay; the file itself is never modified.
+ *
+ * @throws std::runtime_error if @p id doesn't fit in the file's ID size.
+ */
+void
+MappedTilemap::set(size_t x, size_t y, uint32_t id)
+{
+  if (x >= m_width || y >= m_height)
+    throw std::out_of_range("Tile out of the mapped level");
+
+  if (Tilemap::get_id_width_for(id) > get_id_width())
+    throw std::runtime_error("Tile ID too big for the mapped level");
+
+  auto it = m_overlay.find(y);
+
+  if (it == m_overlay.end())
+  {
+    const uint8_t* row = get_row_data(y);
+    it = m_overlay.emplace(y, std::vector<uint8_t>(row, row + m_width
+                                                        * m_id_bytes)).first;
+  }
+
+  uint8_t* tile = it->second.data() + x * m_id_bytes;
+
+  switch (m_id_bytes)
+  {
+    case 1:
+      *tile = static_cast<uint8_t>(id);
+      break;
+
+    case 2:
+      *reinterpret_cast<uint16_t*>(tile) = static_cast<uint16_t>(id);
+      break;
+
+    default:
+      *reinterpret_cast<uint32_t*>(tile) = id;
+      break;
+  }
+}
+
+const uint8_t*
+MappedTilemap::get_row_data(size_t y) const
+{
+  auto it = m_overlay.find(y);
+
+  if (it != m_overlay.end())
+    return it->second.data();
+
+  return m_tiles + y * m_width * m_id_bytes;
+}
@@ -0,0 +1,108 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_MAPPEDTILEMAP_HPP
+#define HEADER_STM_LEVEL_MAPPEDTILEMAP_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "level/tilemap.hpp"
+
+/**
+ * Read-only view of an uncompressed level file (see LevelFile), memory-mapped
+ * rather than loaded. Rows are paged in by the OS only when they are accessed,
+ * so opening a level is instant regardless of its size, and memory usage only
+ * grows with the parts of the level that are actually looked at.
+ *
+ * Changes are never written to the file; modified rows are copied into an
+ * overlay kept in memory. Tile IDs aren't validated when opening the file, as
+ * that would require reading all of it; users must check IDs before using
+ * them.
+ *
+ * Memory-mapping is only available on native POSIX builds (see
+ * is_supported()).
+ */
+class MappedTilemap final
+{
+public:
+  static bool is_supported();
+
+public:
+  /** @param path A path on the native filesystem, not a PhysFS path. */
+  MappedTilemap(const std::string& path);
+  ~MappedTilemap();
+
+  size_t get_width() const;
+  size_t get_height() const;
+  Tilemap::IdWidth get_id_width() const;
+  size_t get_overlay_rows() const;
+
+  uint32_t get(size_t x, size_t y) const;
+  void set(size_t x, size_t y, uint32_t id);
+
+  template<typename F> void visit_rows(size_t y1, size_t y2, F func) const;
+
+private:
+  const uint8_t* get_row_data(size_t y) const;
+
+private:
+  size_t m_width;
+  size_t m_height;
+  uint32_t m_id_bytes;
+  void* m_mapping;
+  size_t m_mapping_size;
+  const uint8_t* m_tiles;
+  std::unordered_map<size_t, std::vector<uint8_t>> m_overlay;
+
+private:
+  MappedTilemap(const MappedTilemap&) = delete;
+  MappedTilemap& operator=(const MappedTilemap&) = delete;
+};
+
+/**
+ * Calls @p func with each row between @p y1 (inclusive) and @p y2 (exclusive),
+ * as `func(y, row)` where `row` points to the row's tiles, in the integer type
+ * used by the file. A generic lambda is the easiest way to accept all types.
+ */
+template<typename F>
+void
+MappedTilemap::visit_rows(size_t y1, size_t y2, F func) const
+{
+  for (size_t y = y1; y < y2 && y < m_height; y++)
+  {
+    const uint8_t* data = get_row_data(y);
+
+    switch (m_id_bytes)
+    {
+      case 1:
+        func(y, data);
+        break;
+
+      case 2:
+        func(y, reinterpret_cast<const uint16_t*>(data));
+        break;
+
+      default:
+        func(y, reinterpret_cast<const uint32_t*>(data));
+        break;
+    }
+  }
+}
+
+#endif
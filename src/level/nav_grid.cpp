@@ -0,0 +1,378 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/nav_grid.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+NavGrid::Chunk::Chunk() :
+  valid(false),
+  version(0),
+  first_region(0),
+  regions(0),
+  labels(),
+  right_links(),
+  down_links()
+{
+}
+
+/** @param mask Must outlive this object. */
+NavGrid::NavGrid(const SolidMask& mask) :
+  m_mask(mask),
+  m_generation(mask.get_generation() - 1),
+  m_chunks_x(0),
+  m_chunks_y(0),
+  m_chunks(),
+  m_parents(),
+  m_stack(),
+  m_row_words(0),
+  m_column_words(0),
+  m_rows(),
+  m_columns()
+{
+}
+
+/**
+ * Labels again the chunks which changed in the mask since the last update.
+ * Done automatically by the queries.
+ *
+ * @returns The number of chunks labelled again.
+ */
+size_t
+NavGrid::update()
+{
+  const size_t chunk_size = SolidMask::CHUNK_SIZE;
+
+  if (m_generation != m_mask.get_generation())
+  {
+    m_generation = m_mask.get_generation();
+    m_chunks_x = (m_mask.get_width() + chunk_size - 1) / chunk_size;
+    m_chunks_y = (m_mask.get_height() + chunk_size - 1) / chunk_size;
+    m_chunks.clear();
+    m_chunks.resize(m_chunks_x * m_chunks_y);
+
+    // Bits past the end of the rows and columns stay set, as if solid
+    m_row_words = m_chunks_x;
+    m_column_words = m_chunks_y;
+    m_rows.assign(m_mask.get_height() * m_row_words, ~0ull);
+    m_columns.assign(m_mask.get_width() * m_column_words, ~0ull);
+  }
+
+  size_t labelled = 0;
+  std::vector<bool> relink(m_chunks.size(), false);
+
+  for (size_t cy = 0; cy < m_chunks_y; cy++)
+  {
+    for (size_t cx = 0; cx < m_chunks_x; cx++)
+    {
+      Chunk& chunk = m_chunks[cy * m_chunks_x + cx];
+      uint32_t version = m_mask.get_chunk_version(cx, cy);
+
+      if (!chunk.valid || chunk.version != version)
+      {
+        label_chunk(cx, cy);
+        copy_chunk(cx, cy);
+        chunk.valid = true;
+        chunk.version = version;
+        labelled++;
+
+        // Links are kept by the chunk on the left or above the border
+        relink[cy * m_chunks_x + cx] = true;
+        if (cx > 0)
+          relink[cy * m_chunks_x + cx - 1] = true;
+        if (cy > 0)
+          relink[(cy - 1) * m_chunks_x + cx] = true;
+      }
+    }
+  }
+
+  if (labelled == 0)
+    return 0;
+
+  for (size_t cy = 0; cy < m_chunks_y; cy++)
+    for (size_t cx = 0; cx < m_chunks_x; cx++)
+      if (relink[cy * m_chunks_x + cx])
+        link_chunk(cx, cy);
+
+  merge_regions();
+
+  return labelled;
+}
+
+/**
+ * Whether a path exists between two free tiles. Solid tiles and tiles outside
+ * of the mask aren't connected to anything.
+ */
+bool
+NavGrid::connected(size_t x1, size_t y1, size_t x2, size_t y2)
+{
+  update();
+
+  if (!m_mask.is_solid(static_cast<long>(x1), static_cast<long>(y1))
+      && !m_mask.is_solid(static_cast<long>(x2), static_cast<long>(y2))
+      && x1 < m_mask.get_width() && y1 < m_mask.get_height()
+      && x2 < m_mask.get_width() && y2 < m_mask.get_height())
+    return find(get_region(x1, y1)) == find(get_region(x2, y2));
+
+  return false;
+}
+
+/**
+ * Returns the solid tiles from 64 * @p word to 64 * @p word + 63 of the row
+ * @p y, lowest column in the lowest bit. Tiles outside of the mask count as
+ * solid.
+ */
+uint64_t
+NavGrid::get_row_word(long y, long word) const
+{
+  if (y < 0 || word < 0 || y >= static_cast<long>(m_mask.get_height())
+      || word >= static_cast<long>(m_row_words))
+    return ~0ull;
+
+  return m_rows[static_cast<size_t>(y) * m_row_words
+                + static_cast<size_t>(word)];
+}
+
+/** Same as get_row_word(), for the column @p x. */
+uint64_t
+NavGrid::get_column_word(long x, long word) const
+{
+  if (x < 0 || word < 0 || x >= static_cast<long>(m_mask.get_width())
+      || word >= static_cast<long>(m_column_words))
+    return ~0ull;
+
+  return m_columns[static_cast<size_t>(x) * m_column_words
+                   + static_cast<size_t>(word)];
+}
+
+/** Splits the free tiles of a chunk into regions, with flood fills. */
+void
+NavGrid::label_chunk(size_t chunk_x, size_t chunk_y)
+{
+  const size_t chunk_size = SolidMask::CHUNK_SIZE;
+
+  Chunk& chunk = m_chunks[chunk_y * m_chunks_x + chunk_x];
+  size_t x0 = chunk_x * chunk_size;
+  size_t y0 = chunk_y * chunk_size;
+  size_t width = std::min(chunk_size, m_mask.get_width() - x0);
+  size_t height = std::min(chunk_size, m_mask.get_height() - y0);
+
+  chunk.labels.assign(chunk_size * chunk_size, 0);
+  chunk.regions = 0;
+
+  auto is_free = [&] (size_t x, size_t y) {
+    return !m_mask.is_solid(static_cast<long>(x0 + x),
+                            static_cast<long>(y0 + y));
+  };
+
+  for (size_t y = 0; y < height; y++)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      if (chunk.labels[y * chunk_size + x] || !is_free(x, y))
+        continue;
+
+      auto label = static_cast<uint16_t>(++chunk.regions);
+      chunk.labels[y * chunk_size + x] = label;
+      m_stack.push_back(static_cast<uint16_t>(y * chunk_size + x));
+
+      while (!m_stack.empty())
+      {
+        size_t index = m_stack.back();
+        m_stack.pop_back();
+
+        size_t tx = index % chunk_size;
+        size_t ty = index / chunk_size;
+
+        // Unsigned wrap-around makes the first two checks reject -1 as well
+        const size_t sides[4][2] = {
+          { tx - 1, ty }, { tx + 1, ty }, { tx, ty - 1 }, { tx, ty + 1 }
+        };
+
+        for (const auto& side : sides)
+        {
+          if (side[0] >= width || side[1] >= height)
+            continue;
+
+          size_t side_index = side[1] * chunk_size + side[0];
+
+          if (!chunk.labels[side_index] && is_free(side[0], side[1]))
+          {
+            chunk.labels[side_index] = label;
+            m_stack.push_back(static_cast<uint16_t>(side_index));
+          }
+        }
+      }
+    }
+  }
+}
+
+/** Copies the solid tiles of a chunk into the row and column bitsets. */
+void
+NavGrid::copy_chunk(size_t chunk_x, size_t chunk_y)
+{
+  const size_t chunk_size = SolidMask::CHUNK_SIZE;
+
+  size_t x0 = chunk_x * chunk_size;
+  size_t y0 = chunk_y * chunk_size;
+  size_t width = std::min(chunk_size, m_mask.get_width() - x0);
+  size_t height = std::min(chunk_size, m_mask.get_height() - y0);
+
+  // A chunk is exactly one word of each of its rows and columns
+  for (size_t y = 0; y < height; y++)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      uint64_t& row = m_rows[(y0 + y) * m_row_words + chunk_x];
+      uint64_t& column = m_columns[(x0 + x) * m_column_words + chunk_y];
+
+      if (m_mask.is_solid(static_cast<long>(x0 + x),
+                          static_cast<long>(y0 + y)))
+      {
+        row |= 1ull << x;
+        column |= 1ull << y;
+      }
+      else
+      {
+        row &= ~(1ull << x);
+        column &= ~(1ull << y);
+      }
+    }
+  }
+}
+
+/**
+ * Finds which regions of a chunk touch those of the chunks on its right and
+ * below it. Both chunks must be labelled.
+ */
+void
+NavGrid::link_chunk(size_t chunk_x, size_t chunk_y)
+{
+  const size_t chunk_size = SolidMask::CHUNK_SIZE;
+
+  Chunk& chunk = m_chunks[chunk_y * m_chunks_x + chunk_x];
+  chunk.right_links.clear();
+  chunk.down_links.clear();
+
+  // Solid tiles and tiles past the end of the mask are labelled 0
+  auto add_link = [] (std::vector<Link>& links, Link link) {
+    if (link.first && link.second && (links.empty() || links.back() != link))
+      links.push_back(link);
+  };
+
+  // Regions usually touch along several tiles in a row
+  auto sort_links = [] (std::vector<Link>& links) {
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+  };
+
+  if (chunk_x + 1 < m_chunks_x)
+  {
+    const Chunk& right = m_chunks[chunk_y * m_chunks_x + chunk_x + 1];
+
+    for (size_t y = 0; y < chunk_size; y++)
+      add_link(chunk.right_links,
+               Link(chunk.labels[y * chunk_size + chunk_size - 1],
+                    right.labels[y * chunk_size]));
+
+    sort_links(chunk.right_links);
+  }
+
+  if (chunk_y + 1 < m_chunks_y)
+  {
+    const Chunk& below = m_chunks[(chunk_y + 1) * m_chunks_x + chunk_x];
+
+    for (size_t x = 0; x < chunk_size; x++)
+      add_link(chunk.down_links,
+               Link(chunk.labels[(chunk_size - 1) * chunk_size + x],
+                    below.labels[x]));
+
+    sort_links(chunk.down_links);
+  }
+}
+
+/** Numbers the regions of all chunks and merges those linked to each other. */
+void
+NavGrid::merge_regions()
+{
+  uint32_t regions = 0;
+
+  for (auto& chunk : m_chunks)
+  {
+    chunk.first_region = regions;
+    regions += chunk.regions;
+  }
+
+  m_parents.resize(regions);
+  std::iota(m_parents.begin(), m_parents.end(), 0);
+
+  for (size_t cy = 0; cy < m_chunks_y; cy++)
+  {
+    for (size_t cx = 0; cx < m_chunks_x; cx++)
+    {
+      const Chunk& chunk = m_chunks[cy * m_chunks_x + cx];
+
+      for (const auto& link : chunk.right_links)
+      {
+        const Chunk& right = m_chunks[cy * m_chunks_x + cx + 1];
+        unite(chunk.first_region + link.first - 1,
+              right.first_region + link.second - 1);
+      }
+
+      for (const auto& link : chunk.down_links)
+      {
+        const Chunk& below = m_chunks[(cy + 1) * m_chunks_x + cx];
+        unite(chunk.first_region + link.first - 1,
+              below.first_region + link.second - 1);
+      }
+    }
+  }
+}
+
+/** Returns the global region of the free tile (@p x, @p y). */
+uint32_t
+NavGrid::get_region(size_t x, size_t y) const
+{
+  const size_t chunk_size = SolidMask::CHUNK_SIZE;
+
+  const Chunk& chunk = m_chunks[y / chunk_size * m_chunks_x + x / chunk_size];
+  return chunk.first_region
+         + chunk.labels[y % chunk_size * chunk_size + x % chunk_size] - 1;
+}
+
+uint32_t
+NavGrid::find(uint32_t region)
+{
+  // Path halving keeps the trees flat
+  while (m_parents[region] != region)
+  {
+    m_parents[region] = m_parents[m_parents[region]];
+    region = m_parents[region];
+  }
+
+  return region;
+}
+
+void
+NavGrid::unite(uint32_t region1, uint32_t region2)
+{
+  region1 = find(region1);
+  region2 = find(region2);
+
+  if (region1 != region2)
+    m_parents[std::max(region1, region2)] = std::min(region1, region2);
+}
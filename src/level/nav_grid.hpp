@@ -0,0 +1,106 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_NAVGRID_HPP
+#define HEADER_STM_LEVEL_NAVGRID_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "level/solid_mask.hpp"
+
+/**
+ * Which free tiles of a SolidMask can reach each other, so that pathfinding
+ * can give up on unreachable goals without searching the whole level.
+ *
+ * The free tiles of each chunk of the mask are split into regions of connected
+ * tiles, then regions touching across chunk borders are merged. A chunk is
+ * only labelled again when its version in the mask changes, and only its
+ * borders are scanned again. Merging still goes over the links across every
+ * border, as a change may split regions far away, but there are only a few
+ * links per border.
+ *
+ * Tiles are connected through their sides only; diagonal moves between tiles
+ * are allowed only when both tiles beside the move are free, so they never
+ * connect anything more.
+ *
+ * The grid also keeps the solid tiles as bitsets both by row and by column,
+ * so that searches can scan 64 tiles at once in any straight direction.
+ */
+class NavGrid final
+{
+public:
+  NavGrid(const SolidMask& mask);
+
+  size_t update();
+  bool connected(size_t x1, size_t y1, size_t x2, size_t y2);
+  uint64_t get_row_word(long y, long word) const;
+  uint64_t get_column_word(long x, long word) const;
+
+private:
+  /** Labels of two regions touching across a chunk border */
+  typedef std::pair<uint16_t, uint16_t> Link;
+
+  class Chunk final
+  {
+  public:
+    Chunk();
+
+  public:
+    bool valid;
+    uint32_t version;
+    /** Global number of the first region of the chunk */
+    uint32_t first_region;
+    uint32_t regions;
+    /** Region of each tile, starting at 1; 0 for solid tiles */
+    std::vector<uint16_t> labels;
+    /** Regions touching those of the chunk on the right, and below */
+    std::vector<Link> right_links;
+    std::vector<Link> down_links;
+  };
+
+private:
+  void label_chunk(size_t chunk_x, size_t chunk_y);
+  void copy_chunk(size_t chunk_x, size_t chunk_y);
+  void link_chunk(size_t chunk_x, size_t chunk_y);
+  void merge_regions();
+  uint32_t get_region(size_t x, size_t y) const;
+  uint32_t find(uint32_t region);
+  void unite(uint32_t region1, uint32_t region2);
+
+private:
+  const SolidMask& m_mask;
+  uint32_t m_generation;
+  size_t m_chunks_x;
+  size_t m_chunks_y;
+  std::vector<Chunk> m_chunks;
+  /** Union-find forest of the regions of all chunks */
+  std::vector<uint32_t> m_parents;
+  std::vector<uint16_t> m_stack;
+  /** Words per row and per column */
+  size_t m_row_words;
+  size_t m_column_words;
+  std::vector<uint64_t> m_rows;
+  std::vector<uint64_t> m_columns;
+
+private:
+  NavGrid(const NavGrid&) = delete;
+  NavGrid& operator=(const NavGrid&) = delete;
+};
+
+#endif
@@ -0,0 +1,494 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/pathfinder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const float g_diagonal_cost = 1.41421356f;
+static const uint32_t g_none = std::numeric_limits<uint32_t>::max();
+
+/** Cost of the shortest path between two tiles if nothing was in the way. */
+static float
+octile_distance(long x1, long y1, long x2, long y2)
+{
+  auto dx = static_cast<float>(std::abs(x2 - x1));
+  auto dy = static_cast<float>(std::abs(y2 - y1));
+
+  return dx + dy + (g_diagonal_cost - 2.0f) * std::min(dx, dy);
+}
+
+static long
+sign(long value)
+{
+  return (value > 0) - (value < 0);
+}
+
+Pathfinder::Tile::Tile() :
+  x(0),
+  y(0)
+{
+}
+
+Pathfinder::Tile::Tile(long tile_x, long tile_y) :
+  x(tile_x),
+  y(tile_y)
+{
+}
+
+bool
+Pathfinder::Tile::operator==(const Tile& tile) const
+{
+  return x == tile.x && y == tile.y;
+}
+
+bool
+Pathfinder::Tile::operator!=(const Tile& tile) const
+{
+  return !(*this == tile);
+}
+
+/** Returns the cost of walking @p path, whose steps must be single tiles. */
+float
+Pathfinder::get_cost(const std::vector<Tile>& path)
+{
+  float cost = 0.0f;
+
+  for (size_t i = 1; i < path.size(); i++)
+    cost += (path[i].x != path[i - 1].x && path[i].y != path[i - 1].y)
+            ? g_diagonal_cost : 1.0f;
+
+  return cost;
+}
+
+/** Heap order: lowest f first, then the deepest tile among equals. */
+bool
+Pathfinder::is_less_promising(const OpenTile& tile1, const OpenTile& tile2)
+{
+  return tile1.f > tile2.f || (tile1.f == tile2.f && tile1.g < tile2.g);
+}
+
+/** @param mask Must outlive this object. */
+Pathfinder::Pathfinder(const SolidMask& mask) :
+  m_mask(mask),
+  m_nav(mask),
+  m_start(),
+  m_goal(),
+  m_search(0),
+  m_costs(),
+  m_parents(),
+  m_opened(),
+  m_closed(),
+  m_open()
+{
+}
+
+/**
+ * Finds a shortest path from @p start to @p goal. Both algorithms find paths
+ * of the same cost, but not always the same path.
+ *
+ * @param path Receives every tile of the path, from @p start to @p goal both
+ *             included. Reuse it between queries to avoid allocations.
+ * @returns Whether a path was found; @p path is empty otherwise.
+ */
+bool
+Pathfinder::find_path(const Tile& start, const Tile& goal,
+                      std::vector<Tile>& path, Algorithm algorithm)
+{
+  path.clear();
+
+  if (!is_free(start.x, start.y) || !is_free(goal.x, goal.y)
+      || !m_nav.connected(static_cast<size_t>(start.x),
+                          static_cast<size_t>(start.y),
+                          static_cast<size_t>(goal.x),
+                          static_cast<size_t>(goal.y)))
+    return false;
+
+  m_start = start;
+  m_goal = goal;
+  reset();
+
+  bool found = (algorithm == Algorithm::A_STAR) ? search_a_star()
+                                                : search_jump_point();
+
+  if (found)
+    build_path(path);
+
+  return found;
+}
+
+/** Tiles outside of the mask aren't free. */
+bool
+Pathfinder::is_free(long x, long y) const
+{
+  return x >= 0 && y >= 0 && x < static_cast<long>(m_mask.get_width())
+         && y < static_cast<long>(m_mask.get_height())
+         && !m_mask.is_solid(x, y);
+}
+
+/** Forgets the previous search, allocating only if the mask grew. */
+void
+Pathfinder::reset()
+{
+  size_t size = m_mask.get_width() * m_mask.get_height();
+
+  if (m_costs.size() < size)
+  {
+    m_costs.resize(size);
+    m_parents.resize(size);
+    m_opened.resize(size, 0);
+    m_closed.resize(size, 0);
+  }
+
+  // Tiles of previous searches would look current once the number wraps
+  if (++m_search == 0)
+  {
+    std::fill(m_opened.begin(), m_opened.end(), 0);
+    std::fill(m_closed.begin(), m_closed.end(), 0);
+    m_search = 1;
+  }
+
+  m_open.clear();
+
+  auto width = static_cast<long>(m_mask.get_width());
+  open(static_cast<uint32_t>(m_start.y * width + m_start.x), g_none, 0.0f);
+}
+
+/**
+ * Reaches the tile @p index from @p parent with the cost @p g, unless it was
+ * already reached for less.
+ */
+void
+Pathfinder::open(uint32_t index, uint32_t parent, float g)
+{
+  if (m_closed[index] == m_search
+      || (m_opened[index] == m_search && m_costs[index] <= g))
+    return;
+
+  m_opened[index] = m_search;
+  m_costs[index] = g;
+  m_parents[index] = parent;
+
+  long x = static_cast<long>(index % m_mask.get_width());
+  long y = static_cast<long>(index / m_mask.get_width());
+  OpenTile tile = { g + octile_distance(x, y, m_goal.x, m_goal.y), g, index };
+
+  // Outdated entries stay in the heap, and are skipped once the tile is closed
+  m_open.push_back(tile);
+  std::push_heap(m_open.begin(), m_open.end(), is_less_promising);
+}
+
+bool
+Pathfinder::search_a_star()
+{
+  auto width = static_cast<long>(m_mask.get_width());
+  while (!m_open.empty())
+  {
+    std::pop_heap(m_open.begin(), m_open.end(), is_less_promising);
+    uint32_t index = m_open.back().index;
+    m_open.pop_back();
+
+    if (m_closed[index] == m_search)
+      continue;
+
+    m_closed[index] = m_search;
+
+    long x = static_cast<long>(index) % width;
+    long y = static_cast<long>(index) / width;
+
+    if (Tile(x, y) == m_goal)
+      return true;
+
+    for (long dy = -1; dy <= 1; dy++)
+    {
+      for (long dx = -1; dx <= 1; dx++)
+      {
+        if ((!dx && !dy) || !is_free(x + dx, y + dy))
+          continue;
+
+        // No cutting corners
+        if (dx && dy && (!is_free(x + dx, y) || !is_free(x, y + dy)))
+          continue;
+
+        open(static_cast<uint32_t>((y + dy) * width + x + dx), index,
+             m_costs[index] + ((dx && dy) ? g_diagonal_cost : 1.0f));
+      }
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Jump point search: from each tile, only the directions which may lead
+ * somewhere new are followed, and only as far as the next tile where the
+ * path might have to turn.
+ */
+bool
+Pathfinder::search_jump_point()
+{
+  auto width = static_cast<long>(m_mask.get_width());
+  while (!m_open.empty())
+  {
+    std::pop_heap(m_open.begin(), m_open.end(), is_less_promising);
+    uint32_t index = m_open.back().index;
+    m_open.pop_back();
+
+    if (m_closed[index] == m_search)
+      continue;
+
+    m_closed[index] = m_search;
+
+    long x = static_cast<long>(index) % width;
+    long y = static_cast<long>(index) / width;
+
+    if (Tile(x, y) == m_goal)
+      return true;
+
+    // Directions worth following, given where the path came from
+    long dirs[8][2];
+    size_t count = 0;
+    uint32_t parent = m_parents[index];
+
+    if (parent == g_none)
+    {
+      for (long dy = -1; dy <= 1; dy++)
+        for (long dx = -1; dx <= 1; dx++)
+          if ((dx || dy) && is_free(x + dx, y + dy)
+              && (!dx || !dy || (is_free(x + dx, y) && is_free(x, y + dy))))
+          {
+            dirs[count][0] = dx;
+            dirs[count++][1] = dy;
+          }
+    }
+    else
+    {
+      long dx = sign(x - static_cast<long>(parent) % width);
+      long dy = sign(y - static_cast<long>(parent) / width);
+
+      auto add = [&] (long ddx, long ddy) {
+        dirs[count][0] = ddx;
+        dirs[count++][1] = ddy;
+      };
+
+      if (dx && dy)
+      {
+        bool free_x = is_free(x + dx, y);
+        bool free_y = is_free(x, y + dy);
+
+        if (free_x)
+          add(dx, 0);
+        if (free_y)
+          add(0, dy);
+        if (free_x && free_y)
+          add(dx, dy);
+      }
+      else if (dx)
+      {
+        bool free_up = is_free(x, y - 1);
+        bool free_down = is_free(x, y + 1);
+
+        if (is_free(x + dx, y))
+        {
+          add(dx, 0);
+          if (free_up)
+            add(dx, -1);
+          if (free_down)
+            add(dx, 1);
+        }
+        if (free_up)
+          add(0, -1);
+        if (free_down)
+          add(0, 1);
+      }
+      else
+      {
+        bool free_left = is_free(x - 1, y);
+        bool free_right = is_free(x + 1, y);
+
+        if (is_free(x, y + dy))
+        {
+          add(0, dy);
+          if (free_left)
+            add(-1, dy);
+          if (free_right)
+            add(1, dy);
+        }
+        if (free_left)
+          add(-1, 0);
+        if (free_right)
+          add(1, 0);
+      }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+      uint32_t next = jump(x, y, dirs[i][0], dirs[i][1]);
+
+      if (next == g_none)
+        continue;
+
+      long nx = static_cast<long>(next) % width;
+      long ny = static_cast<long>(next) / width;
+      open(next, index, m_costs[index] + octile_distance(x, y, nx, ny));
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Goes from (@p x, @p y) in the direction (@p dx, @p dy) until a tile where
+ * the path may need to turn: the goal, or a tile next to a corner which hid
+ * free tiles so far.
+ *
+ * @returns The index of that tile, or g_none if the way is blocked first.
+ */
+uint32_t
+Pathfinder::jump(long x, long y, long dx, long dy) const
+{
+  auto width = static_cast<long>(m_mask.get_width());
+
+  if (!dy)
+  {
+    long stop = scan(true, y, x + dx, dx, (m_goal.y == y) ? m_goal.x : -1);
+    return (stop < 0) ? g_none : static_cast<uint32_t>(y * width + stop);
+  }
+
+  if (!dx)
+  {
+    long stop = scan(false, x, y + dy, dy, (m_goal.x == x) ? m_goal.y : -1);
+    return (stop < 0) ? g_none : static_cast<uint32_t>(stop * width + x);
+  }
+
+  // Diagonal jumps go one tile at a time
+  while (true)
+  {
+    // No cutting corners
+    if (!is_free(x + dx, y) || !is_free(x, y + dy))
+      return g_none;
+
+    x += dx;
+    y += dy;
+
+    if (!is_free(x, y))
+      return g_none;
+
+    auto index = static_cast<uint32_t>(y * width + x);
+
+    if (Tile(x, y) == m_goal)
+      return index;
+
+    // Diagonal moves stop where a straight move would find something
+    if (jump(x, y, dx, 0) != g_none || jump(x, y, 0, dy) != g_none)
+      return index;
+  }
+}
+
+/**
+ * Straight jumps, 64 tiles at a time: goes along a row if @p horizontal, or a
+ * column, from the position @p from (included) in the direction @p dir until
+ * the goal or a tile with a free side tile next to a solid one behind it.
+ *
+ * @param line The row or column to go along.
+ * @param goal The position of the goal on the line, or -1 if it isn't on it.
+ * @returns The position where the jump stops, or -1 if it is blocked first.
+ */
+long
+Pathfinder::scan(bool horizontal, long line, long from, long dir,
+                 long goal) const
+{
+  auto get_word = [this, horizontal] (long l, long w) {
+    return horizontal ? m_nav.get_row_word(l, w)
+                      : m_nav.get_column_word(l, w);
+  };
+
+  // Arithmetic shifts keep negative positions in negative words
+  long word = from >> 6;
+  uint64_t range = (dir > 0) ? ~0ull << (from & 63)
+                             : ~0ull >> (63 - (from & 63));
+
+  while (true)
+  {
+    uint64_t solid = get_word(line, word);
+    uint64_t stops = 0;
+
+    for (long side = line - 1; side <= line + 1; side += 2)
+    {
+      uint64_t tiles = get_word(side, word);
+
+      // Each bit of behind tells whether the tile behind it is solid
+      uint64_t behind = (dir > 0)
+                        ? (tiles << 1) | (get_word(side, word - 1) >> 63)
+                        : (tiles >> 1) | (get_word(side, word + 1) << 63);
+      stops |= ~tiles & behind;
+    }
+
+    if (goal >= 0 && (goal >> 6) == word)
+      stops |= 1ull << (goal & 63);
+
+    uint64_t found = (solid | stops) & range;
+
+    // Solid tiles past the end of the line always stop the scan
+    if (found)
+    {
+      size_t bit = (dir > 0) ? SolidMask::lowest_bit(found)
+                             : SolidMask::highest_bit(found);
+
+      if (solid & (1ull << bit))
+        return -1;
+
+      return word * 64 + static_cast<long>(bit);
+    }
+
+    range = ~0ull;
+    word += dir;
+  }
+}
+
+/** Follows the parents from the goal, filling in the tiles jumped over. */
+void
+Pathfinder::build_path(std::vector<Tile>& path) const
+{
+  auto width = static_cast<long>(m_mask.get_width());
+  auto index = static_cast<uint32_t>(m_goal.y * width + m_goal.x);
+
+  path.push_back(m_goal);
+
+  while (m_parents[index] != g_none)
+  {
+    uint32_t parent = m_parents[index];
+    Tile from(static_cast<long>(parent) % width,
+              static_cast<long>(parent) / width);
+    Tile tile = path.back();
+    long dx = sign(from.x - tile.x);
+    long dy = sign(from.y - tile.y);
+
+    // Jumps are straight or exactly diagonal
+    while (tile != from)
+    {
+      tile.x += dx;
+      tile.y += dy;
+      path.push_back(tile);
+    }
+
+    index = parent;
+  }
+
+  std::reverse(path.begin(), path.end());
+}
@@ -0,0 +1,114 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_PATHFINDER_HPP
+#define HEADER_STM_LEVEL_PATHFINDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "level/nav_grid.hpp"
+#include "level/solid_mask.hpp"
+
+/**
+ * Finds shortest paths between free tiles of a SolidMask. Paths may go in
+ * eight directions, a diagonal step costing sqrt(2), but never cut the corner
+ * of a solid tile.
+ *
+ * The search state is kept between queries and reset by bumping a generation
+ * number, so that queries don't allocate once the pools are large enough.
+ * Goals which can't be reached are rejected by a NavGrid without searching.
+ */
+class Pathfinder final
+{
+public:
+  enum class Algorithm
+  {
+    /** Plain A*, kept as a reference */
+    A_STAR,
+    /** A* which skips over runs of free tiles, much faster in open areas */
+    JUMP_POINT
+  };
+
+  class Tile final
+  {
+  public:
+    Tile();
+    Tile(long tile_x, long tile_y);
+
+    bool operator==(const Tile& tile) const;
+    bool operator!=(const Tile& tile) const;
+
+  public:
+    long x;
+    long y;
+  };
+
+public:
+  static float get_cost(const std::vector<Tile>& path);
+
+public:
+  Pathfinder(const SolidMask& mask);
+
+  bool find_path(const Tile& start, const Tile& goal, std::vector<Tile>& path,
+                 Algorithm algorithm = Algorithm::JUMP_POINT);
+
+private:
+  class OpenTile final
+  {
+  public:
+    /** Cost from the start plus estimated cost to the goal */
+    float f;
+    /** Cost from the start */
+    float g;
+    uint32_t index;
+  };
+
+private:
+  static bool is_less_promising(const OpenTile& tile1, const OpenTile& tile2);
+
+private:
+  bool is_free(long x, long y) const;
+  void reset();
+  void open(uint32_t index, uint32_t parent, float g);
+  bool search_a_star();
+  bool search_jump_point();
+  uint32_t jump(long x, long y, long dx, long dy) const;
+  long scan(bool horizontal, long line, long from, long dir, long goal) const;
+  void build_path(std::vector<Tile>& path) const;
+
+private:
+  const SolidMask& m_mask;
+  NavGrid m_nav;
+  Tile m_start;
+  Tile m_goal;
+  uint32_t m_search;
+  /** Pools indexed by tile */
+  std::vector<float> m_costs;
+  std::vector<uint32_t> m_parents;
+  /** Search in which the tile was opened or closed, m_search if current */
+  std::vector<uint32_t> m_opened;
+  std::vector<uint32_t> m_closed;
+  /** Binary heap, the most promising tile first */
+  std::vector<OpenTile> m_open;
+
+private:
+  Pathfinder(const Pathfinder&) = delete;
+  Pathfinder& operator=(const Pathfinder&) = delete;
+};
+
+#endif
@@ -0,0 +1,334 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/solid_mask.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+const size_t SolidMask::NONE = std::numeric_limits<size_t>::max();
+
+static const size_t g_word_bits = 64;
+
+// A chunk is one word wide, so that writes find their chunk for free
+const size_t SolidMask::CHUNK_SIZE = g_word_bits;
+
+/** Mask of the bits from @p b1 to @p b2, both included, in a single word. */
+static uint64_t
+bit_range(size_t b1, size_t b2)
+{
+  return (~0ull << b1) & (~0ull >> (g_word_bits - 1 - b2));
+}
+
+/** Index of the lowest set bit of @p word, which must not be 0. */
+size_t
+SolidMask::lowest_bit(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<size_t>(__builtin_ctzll(word));
+#else
+  size_t bit = 0;
+  while (!(word & 1))
+  {
+    word >>= 1;
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+/** Index of the highest set bit of @p word, which must not be 0. */
+size_t
+SolidMask::highest_bit(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return g_word_bits - 1 - static_cast<size_t>(__builtin_clzll(word));
+#else
+  size_t bit = g_word_bits - 1;
+  while (!(word & (1ull << bit)))
+    bit--;
+  return bit;
+#endif
+}
+
+/** @param solid_ids For each tile ID, whether the tile is solid. */
+SolidMask::SolidMask(const std::vector<bool>& solid_ids) :
+  m_solid_ids(solid_ids),
+  m_width(0),
+  m_height(0),
+  m_stride(0),
+  m_words(),
+  m_generation(0),
+  m_chunks_x(0),
+  m_chunk_versions()
+{
+}
+
+size_t
+SolidMask::get_width() const
+{
+  return m_width;
+}
+
+size_t
+SolidMask::get_height() const
+{
+  return m_height;
+}
+
+/** IDs missing from the table aren't solid. */
+bool
+SolidMask::is_solid_id(uint32_t id) const
+{
+  return id < m_solid_ids.size() && m_solid_ids[id];
+}
+
+uint32_t
+SolidMask::get_generation() const
+{
+  return m_generation;
+}
+
+/** Chunks outside of the mask have the version 0. */
+uint32_t
+SolidMask::get_chunk_version(size_t chunk_x, size_t chunk_y) const
+{
+  size_t index = chunk_y * m_chunks_x + chunk_x;
+
+  if (chunk_x >= m_chunks_x || index >= m_chunk_versions.size())
+    return 0;
+
+  return m_chunk_versions[index];
+}
+
+/** Replaces the whole mask with the solid tiles of @p tilemap. */
+void
+SolidMask::build(const Tilemap& tilemap)
+{
+  m_width = tilemap.get_width();
+  m_height = tilemap.get_height();
+  m_stride = (m_width + g_word_bits - 1) / g_word_bits;
+  m_words.assign(m_stride * m_height, 0);
+  m_generation++;
+  m_chunks_x = m_stride;
+  m_chunk_versions.assign(m_chunks_x * ((m_height + CHUNK_SIZE - 1)
+                                        / CHUNK_SIZE), 0);
+
+  // Looking up a byte is faster than looking up a std::vector<bool>
+  std::vector<uint8_t> solid(m_solid_ids.begin(), m_solid_ids.end());
+
+  tilemap.visit([&] (const auto& grid) {
+    for (size_t y = 0; y < m_height; y++)
+    {
+      const auto* row = grid.get_row(y);
+      uint64_t* words = m_words.data() + y * m_stride;
+
+      for (size_t x = 0; x < m_width; x++)
+      {
+        if (row[x] < solid.size() && solid[row[x]])
+          words[x / g_word_bits] |= 1ull << (x % g_word_bits);
+      }
+    }
+  });
+}
+
+/** Applies a write of @p id at (@p x, @p y). */
+void
+SolidMask::set(size_t x, size_t y, uint32_t id)
+{
+  if (x >= m_width || y >= m_height)
+    throw std::out_of_range("Tile coordinates out of range");
+
+  set_bits(y, x, x + 1, is_solid_id(id));
+}
+
+/** Applies a write of @p id to the @p length tiles from (@p x, @p y). */
+void
+SolidMask::fill(size_t x, size_t y, size_t length, uint32_t id)
+{
+  if (x > m_width || length > m_width - x || y >= m_height)
+    throw std::out_of_range("Tile span out of range");
+
+  set_bits(y, x, x + length, is_solid_id(id));
+}
+
+/** Applies a Tilemap::resize() with the same arguments. */
+void
+SolidMask::resize(size_t width, size_t height, int off_x, int off_y,
+                  uint32_t fill)
+{
+  SolidMask mask(m_solid_ids);
+  mask.m_width = width;
+  mask.m_height = height;
+  mask.m_stride = (width + g_word_bits - 1) / g_word_bits;
+  mask.m_words.assign(mask.m_stride * height, 0);
+  mask.m_generation = m_generation + 1;
+  mask.m_chunks_x = mask.m_stride;
+  mask.m_chunk_versions.assign(mask.m_chunks_x * ((height + CHUNK_SIZE - 1)
+                                                  / CHUNK_SIZE), 0);
+
+  if (is_solid_id(fill))
+    for (size_t y = 0; y < height; y++)
+      mask.set_bits(y, 0, width, true);
+
+  // Range of source columns which land inside the new mask
+  long src_x1 = std::max(0L, -static_cast<long>(off_x));
+  long src_x2 = std::min(static_cast<long>(m_width),
+                         static_cast<long>(width) - off_x);
+
+  for (long y = 0; y < static_cast<long>(m_height) && src_x1 < src_x2; y++)
+  {
+    long dst_y = y + off_y;
+
+    if (dst_y < 0 || dst_y >= static_cast<long>(height))
+      continue;
+
+    for (long x = src_x1; x < src_x2; x++)
+    {
+      auto dst_x = static_cast<size_t>(x + off_x);
+      mask.set_bits(static_cast<size_t>(dst_y), dst_x, dst_x + 1,
+                    is_solid(x, y));
+    }
+  }
+
+  *this = std::move(mask);
+}
+
+/** Tiles outside of the mask aren't solid. */
+bool
+SolidMask::is_solid(long x, long y) const
+{
+  if (x < 0 || y < 0 || x >= static_cast<long>(m_width)
+      || y >= static_cast<long>(m_height))
+    return false;
+
+  auto ux = static_cast<size_t>(x);
+  auto uy = static_cast<size_t>(y);
+
+  return (m_words[uy * m_stride + ux / g_word_bits] >> (ux % g_word_bits)) & 1;
+}
+
+/**
+ * Finds the first solid tile of row @p y from @p x1 (included) to @p x2
+ * (excluded), 64 tiles at a time.
+ *
+ * @returns The column of the tile, or NONE if there is none.
+ */
+size_t
+SolidMask::first_solid(size_t y, size_t x1, size_t x2) const
+{
+  x2 = std::min(x2, m_width);
+
+  if (y >= m_height || x1 >= x2)
+    return NONE;
+
+  const uint64_t* words = m_words.data() + y * m_stride;
+  size_t last_word = (x2 - 1) / g_word_bits;
+  size_t w = x1 / g_word_bits;
+  uint64_t bits = words[w] & (~0ull << (x1 % g_word_bits));
+
+  while (!bits)
+  {
+    if (++w > last_word)
+      return NONE;
+
+    bits = words[w];
+  }
+
+  size_t x = w * g_word_bits + lowest_bit(bits);
+  return x < x2 ? x : NONE;
+}
+
+/**
+ * Finds the last solid tile of row @p y from @p x1 (included) to @p x2
+ * (excluded), 64 tiles at a time.
+ *
+ * @returns The column of the tile, or NONE if there is none.
+ */
+size_t
+SolidMask::last_solid(size_t y, size_t x1, size_t x2) const
+{
+  x2 = std::min(x2, m_width);
+
+  if (y >= m_height || x1 >= x2)
+    return NONE;
+
+  const uint64_t* words = m_words.data() + y * m_stride;
+  size_t first_word = x1 / g_word_bits;
+  size_t w = (x2 - 1) / g_word_bits;
+  uint64_t bits = words[w] & bit_range(0, (x2 - 1) % g_word_bits);
+
+  while (!bits)
+  {
+    if (w-- == first_word)
+      return NONE;
+
+    bits = words[w];
+  }
+
+  size_t x = w * g_word_bits + highest_bit(bits);
+  return x >= x1 ? x : NONE;
+}
+
+/**
+ * Whether any tile from (@p x1, @p y1) to (@p x2, @p y2), both included, is
+ * solid. The area may extend outside of the mask.
+ */
+bool
+SolidMask::overlaps(long x1, long y1, long x2, long y2) const
+{
+  x1 = std::max(x1, 0L);
+  y1 = std::max(y1, 0L);
+  x2 = std::min(x2, static_cast<long>(m_width) - 1);
+  y2 = std::min(y2, static_cast<long>(m_height) - 1);
+
+  for (long y = y1; y <= y2 && x1 <= x2; y++)
+  {
+    if (first_solid(static_cast<size_t>(y), static_cast<size_t>(x1),
+                    static_cast<size_t>(x2) + 1) != NONE)
+      return true;
+  }
+
+  return false;
+}
+
+/** Sets the bits of row @p y from @p x1 (included) to @p x2 (excluded). */
+void
+SolidMask::set_bits(size_t y, size_t x1, size_t x2, bool solid)
+{
+  if (x1 >= x2)
+    return;
+
+  uint64_t* words = m_words.data() + y * m_stride;
+  uint32_t* versions = m_chunk_versions.data() + y / CHUNK_SIZE * m_chunks_x;
+  size_t w1 = x1 / g_word_bits;
+  size_t w2 = (x2 - 1) / g_word_bits;
+
+  for (size_t w = w1; w <= w2; w++)
+  {
+    size_t b1 = (w == w1) ? x1 % g_word_bits : 0;
+    size_t b2 = (w == w2) ? (x2 - 1) % g_word_bits : g_word_bits - 1;
+    uint64_t bits = bit_range(b1, b2);
+
+    if (solid)
+      words[w] |= bits;
+    else
+      words[w] &= ~bits;
+
+    versions[w]++;
+  }
+}
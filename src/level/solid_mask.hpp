@@ -0,0 +1,98 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_SOLIDMASK_HPP
+#define HEADER_STM_LEVEL_SOLIDMASK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "level/tilemap.hpp"
+
+/**
+ * Which tiles of a tilemap are solid, as one bit per tile. Each row is a packed
+ * bitset, so that queries look at 64 tiles at once.
+ *
+ * The mask is derived from a tilemap and a table telling which tile IDs are
+ * solid. It doesn't follow the tilemap by itself: code that changes the
+ * tilemap must apply the same change to the mask, which costs O(1) per tile,
+ * or build() it again.
+ *
+ * Data derived from the mask can tell what changed since it was computed: each
+ * chunk of CHUNK_SIZE x CHUNK_SIZE tiles has a version, increased whenever one
+ * of its tiles is written, and the whole mask has a generation, increased when
+ * it is rebuilt or resized.
+ */
+class SolidMask final
+{
+public:
+  /** Returned by the queries when no solid tile is found. */
+  static const size_t NONE;
+  /** Width and height of the chunks which have a version */
+  static const size_t CHUNK_SIZE;
+
+public:
+  static size_t lowest_bit(uint64_t word);
+  static size_t highest_bit(uint64_t word);
+
+public:
+  SolidMask(const std::vector<bool>& solid_ids = {});
+
+  size_t get_width() const;
+  size_t get_height() const;
+  bool is_solid_id(uint32_t id) const;
+  uint32_t get_generation() const;
+  uint32_t get_chunk_version(size_t chunk_x, size_t chunk_y) const;
+
+  void build(const Tilemap& tilemap);
+  void set(size_t x, size_t y, uint32_t id);
+  void fill(size_t x, size_t y, size_t length, uint32_t id);
+  template<typename T>
+  void assign(size_t x, size_t y, const T* ids, size_t length);
+  void resize(size_t width, size_t height, int off_x, int off_y,
+              uint32_t fill);
+
+  bool is_solid(long x, long y) const;
+  size_t first_solid(size_t y, size_t x1, size_t x2) const;
+  size_t last_solid(size_t y, size_t x1, size_t x2) const;
+  bool overlaps(long x1, long y1, long x2, long y2) const;
+
+private:
+  void set_bits(size_t y, size_t x1, size_t x2, bool solid);
+
+private:
+  std::vector<bool> m_solid_ids;
+  size_t m_width;
+  size_t m_height;
+  /** Number of words per row */
+  size_t m_stride;
+  std::vector<uint64_t> m_words;
+  uint32_t m_generation;
+  size_t m_chunks_x;
+  std::vector<uint32_t> m_chunk_versions;
+};
+
+/** Applies a write of the @p length tiles @p ids from (@p x, @p y). */
+template<typename T>
+void
+SolidMask::assign(size_t x, size_t y, const T* ids, size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+    set_bits(y, x + i, x + i + 1, is_solid_id(static_cast<uint32_t>(ids[i])));
+}
+
+#endif
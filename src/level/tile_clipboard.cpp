@@ -0,0 +1,116 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/tile_clipboard.hpp"
+
+#include <algorithm>
+#include <utility>
+
+TileClipboard::TileClipboard() :
+  m_tiles(),
+  m_max_id(0)
+{
+}
+
+size_t
+TileClipboard::get_width() const
+{
+  return m_tiles.get_width();
+}
+
+size_t
+TileClipboard::get_height() const
+{
+  return m_tiles.get_height();
+}
+
+bool
+TileClipboard::empty() const
+{
+  return m_tiles.empty();
+}
+
+uint32_t
+TileClipboard::get(size_t x, size_t y) const
+{
+  return m_tiles.get(x, y);
+}
+
+/**
+ * Replaces the region with the @p width by @p height tiles of @p tilemap from
+ * (@p x, @p y). Tiles of the region outside of @p tilemap are set to @p fill,
+ * so that the region keeps its shape when copied across the edge of a level.
+ */
+void
+TileClipboard::copy(const Tilemap& tilemap, long x, long y, size_t width,
+                    size_t height, uint32_t fill)
+{
+  auto level_width = static_cast<long>(tilemap.get_width());
+  auto level_height = static_cast<long>(tilemap.get_height());
+  auto right = x + static_cast<long>(width);
+  auto bottom = y + static_cast<long>(height);
+
+  // Columns of the region inside of the tilemap, relative to the region
+  auto x1 = static_cast<size_t>(std::min(std::max(-x, 0l),
+                                         static_cast<long>(width)));
+  auto x2 = static_cast<size_t>(std::max(std::min(level_width, right) - x,
+                                         static_cast<long>(x1)));
+  auto src_x = static_cast<size_t>(x + static_cast<long>(x1));
+
+  // Rows of the tilemap covered by the region
+  long y1 = std::max(y, 0l);
+  long y2 = std::max(std::min(bottom, level_height), y1);
+
+  if (x1 == x2)
+    y2 = y1;
+
+  // Look for the largest ID first, to pick the smallest type able to hold it
+  bool partial = x1 > 0 || x2 < width || y1 > y || y2 < bottom;
+  uint32_t max_id = partial ? fill : 0;
+
+  tilemap.visit([&] (const auto& grid) {
+    for (long row = y1; row < y2; row++)
+    {
+      const auto* src = grid.get_row(static_cast<size_t>(row)) + src_x;
+      max_id = std::max(max_id, static_cast<uint32_t>(
+                                  *std::max_element(src, src + x2 - x1)));
+    }
+  });
+
+  Tilemap tiles(max_id);
+  tiles.resize(width, height, 0, 0, partial ? fill : 0);
+
+  tiles.visit([&] (auto& dest) {
+    tilemap.visit([&] (const auto& grid) {
+      for (long row = y1; row < y2; row++)
+      {
+        const auto* src = grid.get_row(static_cast<size_t>(row)) + src_x;
+        std::copy(src, src + x2 - x1,
+                  dest.get_row(static_cast<size_t>(row - y)) + x1);
+      }
+    });
+  });
+
+  m_tiles = std::move(tiles);
+  m_max_id = max_id;
+}
+
+void
+TileClipboard::clear()
+{
+  m_tiles.clear();
+  m_max_id = 0;
+}
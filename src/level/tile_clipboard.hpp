@@ -0,0 +1,90 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_TILECLIPBOARD_HPP
+#define HEADER_STM_LEVEL_TILECLIPBOARD_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "level/tilemap.hpp"
+
+/**
+ * Rectangular region of tiles copied out of a Tilemap. The region is stored in
+ * the smallest ID type able to hold the tiles it contains, regardless of the
+ * type of the level it was copied from.
+ *
+ * Tiles are transferred a row at a time, so copying or pasting a region costs
+ * about as much as copying its memory.
+ */
+class TileClipboard final
+{
+public:
+  TileClipboard();
+
+  size_t get_width() const;
+  size_t get_height() const;
+  bool empty() const;
+  uint32_t get(size_t x, size_t y) const;
+
+  void copy(const Tilemap& tilemap, long x, long y, size_t width,
+            size_t height, uint32_t fill);
+  template<typename F>
+  void paste(Tilemap& tilemap, size_t x, size_t y, F before_row) const;
+  void clear();
+
+private:
+  Tilemap m_tiles;
+  uint32_t m_max_id;
+};
+
+/**
+ * Overwrites the tiles of @p tilemap with the region, its top-left corner at
+ * (@p x, @p y). Parts of the region outside of the tilemap are ignored; grow
+ * the tilemap beforehand to paste the whole region.
+ *
+ * Before each row is overwritten, @p before_row is called as
+ * `before_row(x, y, old_ids, new_ids, length)`, where `old_ids` points to the
+ * current tiles of the row and `new_ids` to the tiles about to be written.
+ */
+template<typename F>
+void
+TileClipboard::paste(Tilemap& tilemap, size_t x, size_t y, F before_row) const
+{
+  if (x >= tilemap.get_width() || y >= tilemap.get_height())
+    return;
+
+  size_t width = std::min(get_width(), tilemap.get_width() - x);
+  size_t height = std::min(get_height(), tilemap.get_height() - y);
+
+  tilemap.reserve_id(m_max_id);
+  tilemap.visit([&] (auto& dest) {
+    m_tiles.visit([&] (const auto& src) {
+      for (size_t row = 0; row < height; row++)
+      {
+        auto* dest_row = dest.get_row(y + row) + x;
+        const auto* old_row = dest_row;
+        const auto* src_row = src.get_row(row);
+
+        before_row(x, y + row, old_row, src_row, width);
+        std::copy(src_row, src_row + width, dest_row);
+      }
+    });
+  });
+}
+
+#endif
@@ -0,0 +1,153 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_TILEFILL_HPP
+
+#include "level/tile_fill.hpp"
+
+#else
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * Fills the tiles from (@p x1, @p y1) to (@p x2, @p y2), both inclusive. The
+ * rectangle is clamped to the grid.
+ *
+ * @returns The number of tiles filled.
+ */
+template<typename T, typename F>
+size_t
+TileFill::rect(TileGrid<T>& grid, size_t x1, size_t y1, size_t x2, size_t y2,
+               uint32_t id, F before_span)
+{
+  if (grid.empty() || x1 >= grid.get_width() || y1 >= grid.get_height())
+    return 0;
+
+  x2 = std::min(x2, grid.get_width() - 1);
+  y2 = std::min(y2, grid.get_height() - 1);
+
+  if (x1 > x2 || y1 > y2)
+    return 0;
+
+  size_t length = x2 - x1 + 1;
+
+  for (size_t y = y1; y <= y2; y++)
+  {
+    T* row = grid.get_row(y);
+    before_span(x1, y, static_cast<const T*>(row + x1), length);
+    std::fill(row + x1, row + x1 + length, static_cast<T>(id));
+  }
+
+  return length * (y2 - y1 + 1);
+}
+
+/**
+ * Replaces the 4-connected area of identical tiles around (@p x, @p y) with
+ * @p id, using a span fill: each pending entry is a span of a row to fill from,
+ * along with the direction it was reached from, so that rows are only scanned
+ * again where the area may extend back. Pending spans are kept on the heap,
+ * so big areas can't overflow the stack.
+ *
+ * @returns The number of tiles filled.
+ */
+template<typename T, typename F>
+size_t
+TileFill::flood(TileGrid<T>& grid, size_t x, size_t y, uint32_t id,
+                F before_span)
+{
+  if (x >= grid.get_width() || y >= grid.get_height())
+    return 0;
+
+  const T target = grid.get(x, y);
+  const T value = static_cast<T>(id);
+
+  if (target == value)
+    return 0;
+
+  const size_t width = grid.get_width();
+  const long height = static_cast<long>(grid.get_height());
+  size_t filled = 0;
+
+  // Span from x1 to x2 (inclusive) in row y, reached from row y - dy
+  class Span final
+  {
+  public:
+    size_t x1;
+    size_t x2;
+    long y;
+    long dy;
+  };
+
+  std::vector<Span> spans;
+  spans.push_back({ x, x, static_cast<long>(y), 1 });
+  spans.push_back({ x, x, static_cast<long>(y) - 1, -1 });
+
+  while (!spans.empty())
+  {
+    Span span = spans.back();
+    spans.pop_back();
+
+    if (span.y < 0 || span.y >= height)
+      continue;
+
+    T* row = grid.get_row(static_cast<size_t>(span.y));
+    size_t x1 = span.x1;
+    size_t start = x1;
+
+    // Extend to the left; that part may leak back into the previous row
+    if (row[start] == target)
+    {
+      while (start > 0 && row[start - 1] == target)
+        start--;
+
+      if (start < x1)
+        spans.push_back({ start, x1 - 1, span.y - span.dy, -span.dy });
+    }
+
+    while (x1 <= span.x2)
+    {
+      while (x1 < width && row[x1] == target)
+        x1++;
+
+      if (x1 > start)
+      {
+        before_span(start, static_cast<size_t>(span.y),
+                    static_cast<const T*>(row + start), x1 - start);
+        std::fill(row + start, row + x1, value);
+        filled += x1 - start;
+
+        spans.push_back({ start, x1 - 1, span.y + span.dy, span.dy });
+
+        // Past the end of the span, the area may leak back too
+        if (x1 - 1 > span.x2)
+          spans.push_back({ span.x2 + 1, x1 - 1, span.y - span.dy,
+                            -span.dy });
+      }
+
+      // Skip to the next matching tile
+      x1++;
+      if (x1 < span.x2)
+        x1 = std::find(row + x1, row + span.x2, target) - row;
+
+      start = x1;
+    }
+  }
+
+  return filled;
+}
+
+#endif
@@ -0,0 +1,49 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_TILEFILL_HPP
+#define HEADER_STM_LEVEL_TILEFILL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "level/tile_grid.hpp"
+
+/**
+ * Area filling algorithms working directly on the rows of a TileGrid. Tiles are
+ * always written as horizontal spans.
+ *
+ * Before each span is overwritten, @p before_span is called as
+ * `before_span(x, y, old_ids, length)` where `old_ids` points to the current
+ * tiles of the span, e. g. to record them for undoing.
+ *
+ * @p id must fit in the grid's type; use Tilemap::reserve_id() beforehand.
+ */
+class TileFill final
+{
+public:
+  template<typename T, typename F>
+  static size_t rect(TileGrid<T>& grid, size_t x1, size_t y1, size_t x2,
+                     size_t y2, uint32_t id, F before_span);
+
+  template<typename T, typename F>
+  static size_t flood(TileGrid<T>& grid, size_t x, size_t y, uint32_t id,
+                      F before_span);
+};
+
+#include "level/tile_fill.cpp"
+
+#endif
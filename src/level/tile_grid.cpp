@@ -0,0 +1,352 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_TILEGRID_HPP
+
+#include "level/tile_grid.hpp"
+
+#else
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+template<typename T>
+constexpr size_t TileGrid<T>::BAND_ROWS;
+
+template<typename T>
+TileGrid<T>::Band::Band(size_t size, T fill) :
+  tiles(size, fill),
+  shared(false),
+  hash_valid(false),
+  hash(0)
+{
+}
+
+template<typename T>
+TileGrid<T>::Band::Band(const Band& other) :
+  tiles(other.tiles),
+  shared(false),
+  hash_valid(other.hash_valid.load(std::memory_order_acquire)),
+  hash(other.hash.load(std::memory_order_relaxed))
+{
+}
+
+template<typename T>
+TileGrid<T>::TileGrid() :
+  m_width(0),
+  m_height(0),
+  m_bands()
+{
+}
+
+template<typename T>
+TileGrid<T>::TileGrid(size_t width, size_t height, T fill) :
+  m_width(width),
+  m_height(height),
+  m_bands()
+{
+  for (size_t y = 0; y < height; y += BAND_ROWS)
+  {
+    size_t rows = std::min(BAND_ROWS, height - y);
+    m_bands.push_back(std::make_shared<Band>(rows * width, fill));
+  }
+}
+
+template<typename T>
+TileGrid<T>::TileGrid(const TileGrid& other) :
+  m_width(other.m_width),
+  m_height(other.m_height),
+  m_bands(other.m_bands)
+{
+  share_bands();
+}
+
+template<typename T>
+TileGrid<T>&
+TileGrid<T>::operator=(const TileGrid& other)
+{
+  if (this != &other)
+  {
+    m_width = other.m_width;
+    m_height = other.m_height;
+    m_bands = other.m_bands;
+    share_bands();
+  }
+
+  return *this;
+}
+
+template<typename T>
+size_t
+TileGrid<T>::get_width() const
+{
+  return m_width;
+}
+
+template<typename T>
+size_t
+TileGrid<T>::get_height() const
+{
+  return m_height;
+}
+
+template<typename T>
+bool
+TileGrid<T>::empty() const
+{
+  return m_width == 0 || m_height == 0;
+}
+
+template<typename T>
+T
+TileGrid<T>::get(size_t x, size_t y) const
+{
+  if (x >= m_width || y >= m_height)
+    throw std::out_of_range("Tile coordinates out of range");
+
+  return get_row(y)[x];
+}
+
+template<typename T>
+void
+TileGrid<T>::set(size_t x, size_t y, T id)
+{
+  if (x >= m_width || y >= m_height)
+    throw std::out_of_range("Tile coordinates out of range");
+
+  Band& band = get_band(y / BAND_ROWS);
+  size_t index = (y % BAND_ROWS) * m_width + x;
+
+  // Update the hash in place instead of hashing the whole band again
+  if (band.hash_valid.load(std::memory_order_relaxed))
+  {
+    uint64_t hash = band.hash.load(std::memory_order_relaxed);
+    hash += hash_tile(index, id) - hash_tile(index, band.tiles[index]);
+    band.hash.store(hash, std::memory_order_relaxed);
+  }
+
+  band.tiles[index] = id;
+}
+
+/** Sets the @p length tiles starting at (@p x, @p y) to @p id. */
+template<typename T>
+void
+TileGrid<T>::fill(size_t x, size_t y, size_t length, T id)
+{
+  if (x > m_width || length > m_width - x || y >= m_height)
+    throw std::out_of_range("Tile span out of range");
+
+  Band& band = get_band(y / BAND_ROWS);
+  size_t index = (y % BAND_ROWS) * m_width + x;
+  T* tiles = band.tiles.data() + index;
+
+  if (band.hash_valid.load(std::memory_order_relaxed))
+  {
+    uint64_t hash = band.hash.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < length; i++)
+      hash += hash_tile(index + i, id) - hash_tile(index + i, tiles[i]);
+
+    band.hash.store(hash, std::memory_order_relaxed);
+  }
+
+  std::fill(tiles, tiles + length, id);
+}
+
+template<typename T>
+const T*
+TileGrid<T>::get_row(size_t y) const
+{
+  return m_bands[y / BAND_ROWS]->tiles.data() + (y % BAND_ROWS) * m_width;
+}
+
+/**
+ * Returns a row for writing. If the band holding the row was ever shared with
+ * other copies of the grid, it is copied first. The hash of the band is
+ * recomputed the next time it is needed.
+ */
+template<typename T>
+T*
+TileGrid<T>::get_row(size_t y)
+{
+  Band& band = get_band(y / BAND_ROWS);
+  band.hash_valid.store(false, std::memory_order_relaxed);
+
+  return band.tiles.data() + (y % BAND_ROWS) * m_width;
+}
+
+/**
+ * Resizes the grid. The tile that was at (x, y) will be at
+ * (x + off_x, y + off_y) after the resize; tiles that end up outside the new
+ * bounds are dropped and new space is filled with @p fill.
+ */
+template<typename T>
+void
+TileGrid<T>::resize(size_t width, size_t height, int off_x, int off_y, T fill)
+{
+  TileGrid<T> grid(width, height, fill);
+
+  // Range of source columns which land inside the new grid
+  long src_x1 = std::max(0L, -static_cast<long>(off_x));
+  long src_x2 = std::min(static_cast<long>(m_width),
+                         static_cast<long>(width) - off_x);
+
+  for (long y = 0; y < static_cast<long>(m_height) && src_x1 < src_x2; y++)
+  {
+    long dst_y = y + off_y;
+
+    if (dst_y < 0 || dst_y >= static_cast<long>(height))
+      continue;
+
+    const T* src = static_cast<const TileGrid<T>&>(*this).get_row(y);
+    std::copy(src + src_x1, src + src_x2,
+              grid.get_row(dst_y) + src_x1 + off_x);
+  }
+
+  *this = std::move(grid);
+}
+
+template<typename T>
+void
+TileGrid<T>::clear()
+{
+  m_bands.clear();
+  m_bands.shrink_to_fit();
+  m_width = 0;
+  m_height = 0;
+}
+
+/** The caller must make sure all IDs in @p other fit in T. */
+template<typename T>
+template<typename U>
+void
+TileGrid<T>::assign(const TileGrid<U>& other)
+{
+  TileGrid<T> grid(other.get_width(), other.get_height(), 0);
+
+  for (size_t y = 0; y < other.get_height(); y++)
+  {
+    const U* row = other.get_row(y);
+    std::copy(row, row + other.get_width(), grid.get_row(y));
+  }
+
+  *this = std::move(grid);
+}
+
+/**
+ * Returns a hash of the width of the grid and of the bands holding the rows
+ * from @p y1 to @p y2 (exclusive). The whole bands are hashed, even if the rows
+ * only cover part of them. Only the bands changed since they were last hashed
+ * are hashed again, so this is cheap enough to call often.
+ */
+template<typename T>
+uint64_t
+TileGrid<T>::get_hash(size_t y1, size_t y2) const
+{
+  uint64_t hash = mix(m_width);
+
+  // Unlike the tiles of a band, the bands are combined in order
+  for (size_t y = y1 - y1 % BAND_ROWS; y < std::min(y2, m_height);
+       y += BAND_ROWS)
+    hash = mix(hash ^ get_band_hash(y / BAND_ROWS));
+
+  return hash;
+}
+
+template<typename T>
+uint32_t
+TileGrid<T>::max_id()
+{
+  return static_cast<uint32_t>(std::numeric_limits<T>::max());
+}
+
+/** Scrambles the bits of @p value (finalizer of SplitMix64). */
+template<typename T>
+uint64_t
+TileGrid<T>::mix(uint64_t value)
+{
+  value += 0x9e3779b97f4a7c15ull;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+  return value ^ (value >> 31);
+}
+
+/**
+ * Hash of a single tile, @p index being its position in its band. The hash of
+ * a band is the sum of the hashes of its tiles, which lets set() update it
+ * without looking at the rest of the band.
+ */
+template<typename T>
+uint64_t
+TileGrid<T>::hash_tile(size_t index, T id)
+{
+  return mix((static_cast<uint64_t>(index) << 32) + id);
+}
+
+/** Marks all bands as shared, once they are held by another grid. */
+template<typename T>
+void
+TileGrid<T>::share_bands() const
+{
+  for (const auto& band : m_bands)
+    band->shared.store(true, std::memory_order_release);
+}
+
+/**
+ * Returns @p band for writing, copying it first if it was ever shared with
+ * other copies of the grid.
+ */
+template<typename T>
+typename TileGrid<T>::Band&
+TileGrid<T>::get_band(size_t band)
+{
+  auto& ptr = m_bands[band];
+
+  // The reference count can't tell whether the other copies are done reading
+  // the band, as dropping them doesn't synchronize with this thread
+  if (ptr->shared.load(std::memory_order_acquire))
+    ptr = std::make_shared<Band>(*ptr);
+
+  return *ptr;
+}
+
+/**
+ * Returns the hash of @p band, computing it if needed. Bands are only shared
+ * once they can't be written anymore, so threads computing the hash of the
+ * same band at once all store the same value.
+ */
+template<typename T>
+uint64_t
+TileGrid<T>::get_band_hash(size_t band) const
+{
+  Band& tiles = *m_bands[band];
+
+  if (!tiles.hash_valid.load(std::memory_order_acquire))
+  {
+    uint64_t hash = 0;
+
+    for (size_t i = 0; i < tiles.tiles.size(); i++)
+      hash += hash_tile(i, tiles.tiles[i]);
+
+    tiles.hash.store(hash, std::memory_order_relaxed);
+    tiles.hash_valid.store(true, std::memory_order_release);
+  }
+
+  return tiles.hash.load(std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,114 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_TILEGRID_HPP
+#define HEADER_STM_LEVEL_TILEGRID_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Row-major storage for tile IDs, parameterized on the integer type used to
+ * store each ID. The type is usually picked at runtime by the Tilemap class
+ * according to the size of the tileset.
+ *
+ * Rows are stored in bands of BAND_ROWS rows, shared between copies of the
+ * grid until one of them is modified (copy-on-write). Copying a grid is thus
+ * cheap, which allows taking snapshots of a level to save it in the
+ * background. Once a band has been shared, it is never written in place again,
+ * even after the other copies are gone: they may have been read on another
+ * thread, and dropping a copy doesn't order those reads before later writes.
+ * Each row is contiguous, but consecutive rows may not be.
+ *
+ * Each band also has a content hash, kept up to date by set() and fill() and
+ * recomputed lazily after the band is written through get_row(). The hash is
+ * stored in the band, so copies sharing a band share its hash, and it may be
+ * computed by several threads at once. The hash only depends on the tile IDs,
+ * not on T, so grids of different types holding the same tiles hash the same.
+ *
+ * Copies may be read from other threads while the original is modified, but a
+ * given copy must only be used by one thread at a time.
+ */
+template<typename T>
+class TileGrid final
+{
+public:
+  static constexpr size_t BAND_ROWS = 64;
+
+public:
+  TileGrid();
+  TileGrid(size_t width, size_t height, T fill);
+  TileGrid(const TileGrid& other);
+  TileGrid(TileGrid&& other) = default;
+
+  TileGrid& operator=(const TileGrid& other);
+  TileGrid& operator=(TileGrid&& other) = default;
+
+  size_t get_width() const;
+  size_t get_height() const;
+  bool empty() const;
+
+  T get(size_t x, size_t y) const;
+  void set(size_t x, size_t y, T id);
+  void fill(size_t x, size_t y, size_t length, T id);
+
+  const T* get_row(size_t y) const;
+  T* get_row(size_t y);
+
+  void resize(size_t width, size_t height, int off_x, int off_y, T fill);
+  void clear();
+
+  template<typename U> void assign(const TileGrid<U>& other);
+
+  uint64_t get_hash(size_t y1, size_t y2) const;
+
+  static uint32_t max_id();
+
+private:
+  struct Band final
+  {
+    Band(size_t size, T fill);
+    Band(const Band& other);
+
+    std::vector<T> tiles;
+    /** Set once the band is held by more than one grid, never cleared */
+    std::atomic<bool> shared;
+    std::atomic<bool> hash_valid;
+    /** Sum of hash_tile() over the tiles, valid if hash_valid is set */
+    std::atomic<uint64_t> hash;
+  };
+
+private:
+  static uint64_t mix(uint64_t value);
+  static uint64_t hash_tile(size_t index, T id);
+
+  void share_bands() const;
+  Band& get_band(size_t band);
+
+  uint64_t get_band_hash(size_t band) const;
+
+private:
+  size_t m_width;
+  size_t m_height;
+  std::vector<std::shared_ptr<Band>> m_bands;
+};
+
+#include "level/tile_grid.cpp"
+
+#endif
@@ -0,0 +1,263 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/tile_physics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Index of the tile holding @p coord, in pixels. The edges of tile i are at
+ * i * tile_size, rounded the same way as here, so that a coordinate snapped to
+ * an edge maps back to that edge whatever rounding the division does.
+ */
+static long
+tile_floor(float coord, float tile_size)
+{
+  auto tile = static_cast<long>(std::floor(coord / tile_size));
+
+  if (static_cast<float>(tile + 1) * tile_size <= coord)
+    tile++;
+  else if (static_cast<float>(tile) * tile_size > coord)
+    tile--;
+
+  return tile;
+}
+
+/** Index of the first tile starting at or after @p coord, in pixels. */
+static long
+tile_ceil(float coord, float tile_size)
+{
+  auto tile = static_cast<long>(std::ceil(coord / tile_size));
+
+  if (static_cast<float>(tile - 1) * tile_size >= coord)
+    tile--;
+  else if (static_cast<float>(tile) * tile_size < coord)
+    tile++;
+
+  return tile;
+}
+
+/**
+ * Moves @p edge to @p coord and @p other by the same distance. The edge is set
+ * rather than moved, as adding the distance could leave it a rounding error
+ * inside the tile it was stopped against, making the next sweeps skip that
+ * tile.
+ *
+ * @returns The distance travelled.
+ */
+static float
+snap_edge(float& edge, float& other, float coord)
+{
+  float distance = coord - edge;
+  other += distance;
+  edge = coord;
+  return distance;
+}
+
+TilePhysics::Body::Body(const Rect& body_box) :
+  box(body_box),
+  last_box(body_box),
+  velocity(0.0f, 0.0f),
+  on_ground(false)
+{
+}
+
+/**
+ * Returns where to draw the body, @p alpha of the way between its position
+ * before the last step (0) and its current position (1).
+ */
+Rect
+TilePhysics::Body::get_drawn_box(float alpha) const
+{
+  return Rect(box).move(Vector(last_box.x1 - box.x1, last_box.y1 - box.y1)
+                        * (1.0f - alpha));
+}
+
+/**
+ * @param mask The solid tiles. Must outlive this object; tiles outside of it
+ *             aren't solid.
+ * @param tile_size The width and height of a tile, in pixels.
+ */
+TilePhysics::TilePhysics(const SolidMask& mask, float tile_size) :
+  m_mask(mask),
+  m_tile_size(tile_size),
+  m_gravity(1500.0f)
+{
+}
+
+/** @param gravity In pixels per second squared. */
+void
+TilePhysics::set_gravity(float gravity)
+{
+  m_gravity = gravity;
+}
+
+/**
+ * Applies gravity to @p bodies and moves them according to their velocity.
+ * Bodies stop along the axis on which they hit a tile, and don't collide with
+ * each other.
+ */
+void
+TilePhysics::step(std::vector<Body>& bodies, float dt_sec) const
+{
+  for (auto& body : bodies)
+  {
+    body.last_box = body.box;
+    body.velocity.y += m_gravity * dt_sec;
+
+    Vector motion = body.velocity * dt_sec;
+    Vector moved = move(body.box, motion);
+
+    if (moved.x != motion.x)
+      body.velocity.x = 0.0f;
+
+    body.on_ground = motion.y > 0.0f && moved.y != motion.y;
+
+    if (moved.y != motion.y)
+      body.velocity.y = 0.0f;
+  }
+}
+
+/**
+ * Moves @p box by @p motion, horizontally then vertically, stopping it against
+ * the first solid tile on each axis. @p box must not overlap solid tiles.
+ *
+ * @returns The distance actually travelled on each axis.
+ */
+Vector
+TilePhysics::move(Rect& box, const Vector& motion) const
+{
+  Vector moved(0.0f, 0.0f);
+  moved.x = sweep_x(box, motion.x);
+  moved.y = sweep_y(box, motion.y);
+  return moved;
+}
+
+/**
+ * Moves @p box horizontally by up to @p dx. A box stopped by a tile ends
+ * exactly on its edge.
+ *
+ * @returns The distance travelled.
+ */
+float
+TilePhysics::sweep_x(Rect& box, float dx) const
+{
+  if (dx == 0.0f)
+    return 0.0f;
+
+  // Rows touched by the box; a box ending on the edge of a row doesn't touch it
+  long row1 = std::max(tile_floor(box.y1, m_tile_size), 0L);
+  long row2 = std::min(tile_ceil(box.y2, m_tile_size),
+                       static_cast<long>(m_mask.get_height()));
+  auto width = static_cast<long>(m_mask.get_width());
+
+  if (dx > 0.0f)
+  {
+    // Columns entered by the right edge of the box
+    long col1 = std::max(tile_ceil(box.x2, m_tile_size), 0L);
+    long col2 = std::min(tile_ceil(box.x2 + dx, m_tile_size), width);
+    long hit = col2;
+
+    // Each row only needs to be searched up to the nearest hit so far
+    for (long row = row1; row < row2 && col1 < hit; row++)
+    {
+      size_t col = m_mask.first_solid(static_cast<size_t>(row),
+                                      static_cast<size_t>(col1),
+                                      static_cast<size_t>(hit));
+      if (col != SolidMask::NONE)
+        hit = static_cast<long>(col);
+    }
+
+    if (col1 < col2 && hit < col2)
+      return snap_edge(box.x2, box.x1, static_cast<float>(hit) * m_tile_size);
+  }
+  else
+  {
+    // Columns entered by the left edge of the box
+    long col1 = std::max(tile_floor(box.x1 + dx, m_tile_size), 0L);
+    long col2 = std::min(tile_floor(box.x1, m_tile_size), width);
+    long hit = col1 - 1;
+
+    for (long row = row1; row < row2 && hit + 1 < col2; row++)
+    {
+      size_t col = m_mask.last_solid(static_cast<size_t>(row),
+                                     static_cast<size_t>(hit + 1),
+                                     static_cast<size_t>(col2));
+      if (col != SolidMask::NONE)
+        hit = static_cast<long>(col);
+    }
+
+    if (col1 < col2 && hit >= col1)
+      return snap_edge(box.x1, box.x2,
+                       static_cast<float>(hit + 1) * m_tile_size);
+  }
+
+  box.move(Vector(dx, 0.0f));
+  return dx;
+}
+
+/** Same as sweep_x(), vertically. */
+float
+TilePhysics::sweep_y(Rect& box, float dy) const
+{
+  if (dy == 0.0f)
+    return 0.0f;
+
+  long col1 = std::max(tile_floor(box.x1, m_tile_size), 0L);
+  long col2 = std::min(tile_ceil(box.x2, m_tile_size),
+                       static_cast<long>(m_mask.get_width()));
+  auto height = static_cast<long>(m_mask.get_height());
+
+  if (col1 >= col2)
+  {
+    box.move(Vector(0.0f, dy));
+    return dy;
+  }
+
+  // Rows are searched from the nearest one, so the first hit is the one
+  if (dy > 0.0f)
+  {
+    long row1 = std::max(tile_ceil(box.y2, m_tile_size), 0L);
+    long row2 = std::min(tile_ceil(box.y2 + dy, m_tile_size), height);
+
+    for (long row = row1; row < row2; row++)
+    {
+      if (m_mask.first_solid(static_cast<size_t>(row),
+                             static_cast<size_t>(col1),
+                             static_cast<size_t>(col2)) != SolidMask::NONE)
+        return snap_edge(box.y2, box.y1,
+                         static_cast<float>(row) * m_tile_size);
+    }
+  }
+  else
+  {
+    long row1 = std::max(tile_floor(box.y1 + dy, m_tile_size), 0L);
+    long row2 = std::min(tile_floor(box.y1, m_tile_size), height);
+
+    for (long row = row2 - 1; row >= row1; row--)
+    {
+      if (m_mask.first_solid(static_cast<size_t>(row),
+                             static_cast<size_t>(col1),
+                             static_cast<size_t>(col2)) != SolidMask::NONE)
+        return snap_edge(box.y1, box.y2,
+                         static_cast<float>(row + 1) * m_tile_size);
+    }
+  }
+
+  box.move(Vector(0.0f, dy));
+  return dy;
+}
@@ -0,0 +1,77 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_TILEPHYSICS_HPP
+#define HEADER_STM_LEVEL_TILEPHYSICS_HPP
+
+#include <vector>
+
+#include "level/solid_mask.hpp"
+#include "util/rect.hpp"
+#include "util/vector.hpp"
+
+/**
+ * Moves axis-aligned boxes through the solid tiles of a level without letting
+ * them enter the tiles, however fast they go.
+ *
+ * Each move is swept along one axis, then the other: only the tiles between
+ * the box and its destination are looked at, so the cost of a move depends on
+ * the distance travelled and not on the size of the level.
+ */
+class TilePhysics final
+{
+public:
+  class Body final
+  {
+  public:
+    Body(const Rect& body_box);
+
+    Rect get_drawn_box(float alpha) const;
+
+  public:
+    /** Position of the body in the level, in pixels */
+    Rect box;
+    /** Position of the body before the last step */
+    Rect last_box;
+    /** In pixels per second */
+    Vector velocity;
+    /** Whether the body rests on a solid tile */
+    bool on_ground;
+  };
+
+public:
+  TilePhysics(const SolidMask& mask, float tile_size);
+
+  void set_gravity(float gravity);
+
+  void step(std::vector<Body>& bodies, float dt_sec) const;
+  Vector move(Rect& box, const Vector& motion) const;
+
+private:
+  float sweep_x(Rect& box, float dx) const;
+  float sweep_y(Rect& box, float dy) const;
+
+private:
+  const SolidMask& m_mask;
+  float m_tile_size;
+  float m_gravity;
+
+private:
+  TilePhysics(const TilePhysics&) = delete;
+  TilePhysics& operator=(const TilePhysics&) = delete;
+};
+
+#endif
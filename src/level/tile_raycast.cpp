@@ -0,0 +1,114 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/tile_raycast.hpp"
+
+#include <algorithm>
+
+#include "util/parallel.hpp"
+
+/** Number of segments a thread takes at once in batched queries */
+static const size_t g_batch_size = 256;
+
+TileRaycast::Hit::Hit() :
+  hit(false),
+  x(0),
+  y(0),
+  distance(0.0f),
+  face(Face::NONE)
+{
+}
+
+/**
+ * Casts a ray against the solid tiles of @p mask; tiles outside of it aren't
+ * solid, so the ray stops once it leaves the mask.
+ */
+TileRaycast::Hit
+TileRaycast::cast(const SolidMask& mask, const Vector& origin,
+                  const Vector& direction, float max_distance)
+{
+  // Distance at which the ray leaves the mask for good
+  float length = direction.length();
+  float exit = max_distance;
+
+  if (length > 0.0f)
+  {
+    Vector dir = direction / length;
+    float bounds[2][2] = {
+      { 0.0f, static_cast<float>(mask.get_width()) },
+      { 0.0f, static_cast<float>(mask.get_height()) }
+    };
+    float coords[2] = { origin.x, origin.y };
+    float dirs[2] = { dir.x, dir.y };
+
+    for (int i = 0; i < 2; i++)
+    {
+      if (dirs[i] > 0.0f)
+        exit = std::min(exit, (bounds[i][1] - coords[i]) / dirs[i]);
+      else if (dirs[i] < 0.0f)
+        exit = std::min(exit, (bounds[i][0] - coords[i]) / dirs[i]);
+      else if (coords[i] < bounds[i][0] || coords[i] >= bounds[i][1])
+        return Hit();
+    }
+
+    if (exit < 0.0f)
+      return Hit();
+  }
+
+  Hit hit = cast(origin, direction, exit, [&mask] (long x, long y) {
+    return mask.is_solid(x, y);
+  });
+
+  // The ray may have stopped at the edge of the mask instead of max_distance
+  if (!hit.hit || hit.distance > max_distance)
+    return Hit();
+
+  return hit;
+}
+
+/** Whether no solid tile of @p mask lies between @p from and @p to. */
+bool
+TileRaycast::line_of_sight(const SolidMask& mask, const Vector& from,
+                           const Vector& to)
+{
+  Vector direction = to - from;
+  return !cast(mask, from, direction, direction.length()).hit;
+}
+
+/**
+ * Checks the line of sight between the ends of each of @p lines, spread
+ * over @p threads threads.
+ *
+ * @returns 1 for the lines with a line of sight, 0 for the others, in the
+ *          same order. Bytes rather than bits, as threads write them at once.
+ */
+std::vector<uint8_t>
+TileRaycast::line_of_sight(const SolidMask& mask,
+                           const std::vector<Segment>& lines,
+                           size_t threads)
+{
+  std::vector<uint8_t> results(lines.size(), 0);
+
+  // Lines are handed out in batches, as a single one is quick to check
+  Parallel::run(lines.size(), g_batch_size, threads,
+                [&] (size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+      results[i] = line_of_sight(mask, lines[i].first,
+                                 lines[i].second) ? 1 : 0;
+  });
+
+  return results;
+}
@@ -0,0 +1,175 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_TILERAYCAST_HPP
+#define HEADER_STM_LEVEL_TILERAYCAST_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "level/solid_mask.hpp"
+#include "util/vector.hpp"
+
+/**
+ * Ray casting through a grid of tiles, with a digital differential analyzer:
+ * the ray goes from tile to tile, in order, visiting exactly the tiles it
+ * crosses. All coordinates and distances are in tiles; tile (x, y) covers
+ * [x, x + 1) x [y, y + 1).
+ *
+ * The queries only read the tiles, so they may run on several threads at once
+ * as long as nothing writes the tiles meanwhile.
+ */
+class TileRaycast final
+{
+public:
+  /** Side of a tile through which a ray entered it */
+  enum class Face
+  {
+    NONE,
+    LEFT,
+    RIGHT,
+    TOP,
+    BOTTOM
+  };
+
+  class Hit final
+  {
+  public:
+    Hit();
+
+  public:
+    bool hit;
+    long x;
+    long y;
+    /** From the origin of the ray to the point where it entered the tile */
+    float distance;
+    /** NONE if the ray started inside of the tile */
+    Face face;
+  };
+
+  typedef std::pair<Vector, Vector> Segment;
+
+public:
+  template<typename F>
+  static Hit cast(const Vector& origin, const Vector& direction,
+                  float max_distance, F is_hit);
+  template<typename F>
+  static void walk(const Vector& from, const Vector& to, F visit);
+
+  static Hit cast(const SolidMask& mask, const Vector& origin,
+                  const Vector& direction, float max_distance);
+  static bool line_of_sight(const SolidMask& mask, const Vector& from,
+                            const Vector& to);
+  static std::vector<uint8_t> line_of_sight(const SolidMask& mask,
+                                            const std::vector<Segment>& lines,
+                                            size_t threads);
+};
+
+/**
+ * Follows the ray from @p origin towards @p direction, which doesn't need to be
+ * normalized, and calls `is_hit(x, y)` for each tile it crosses until that
+ * returns true or the ray is longer than @p max_distance.
+ *
+ * @param max_distance Must be finite unless @p is_hit is sure to return true.
+ */
+template<typename F>
+TileRaycast::Hit
+TileRaycast::cast(const Vector& origin, const Vector& direction,
+                  float max_distance, F is_hit)
+{
+  const float inf = std::numeric_limits<float>::infinity();
+
+  Hit hit;
+  hit.x = static_cast<long>(std::floor(origin.x));
+  hit.y = static_cast<long>(std::floor(origin.y));
+  hit.distance = 0.0f;
+
+  float length = direction.length();
+
+  if (length == 0.0f)
+  {
+    hit.hit = is_hit(hit.x, hit.y);
+    return hit;
+  }
+
+  Vector dir = direction / length;
+
+  // Distance along the ray to the next vertical and horizontal tile edges, and
+  // between two consecutive edges of each kind
+  long step_x = (dir.x > 0.0f) ? 1 : (dir.x < 0.0f) ? -1 : 0;
+  long step_y = (dir.y > 0.0f) ? 1 : (dir.y < 0.0f) ? -1 : 0;
+  float delta_x = step_x ? std::abs(1.0f / dir.x) : inf;
+  float delta_y = step_y ? std::abs(1.0f / dir.y) : inf;
+  float next_x = (step_x > 0) ? (static_cast<float>(hit.x + 1) - origin.x)
+                                / dir.x
+               : (step_x < 0) ? (origin.x - static_cast<float>(hit.x))
+                                / -dir.x
+               : inf;
+  float next_y = (step_y > 0) ? (static_cast<float>(hit.y + 1) - origin.y)
+                                / dir.y
+               : (step_y < 0) ? (origin.y - static_cast<float>(hit.y))
+                                / -dir.y
+               : inf;
+
+  while (!is_hit(hit.x, hit.y))
+  {
+    if (next_x < next_y)
+    {
+      hit.distance = next_x;
+      hit.x += step_x;
+      hit.face = (step_x > 0) ? Face::LEFT : Face::RIGHT;
+      next_x += delta_x;
+    }
+    else
+    {
+      hit.distance = next_y;
+      hit.y += step_y;
+      hit.face = (step_y > 0) ? Face::TOP : Face::BOTTOM;
+      next_y += delta_y;
+    }
+
+    if (hit.distance > max_distance)
+    {
+      hit.face = Face::NONE;
+      return hit;
+    }
+  }
+
+  hit.hit = true;
+  return hit;
+}
+
+/**
+ * Calls `visit(x, y)` for each tile crossed by the segment from @p from to
+ * @p to, both included, in order.
+ */
+template<typename F>
+void
+TileRaycast::walk(const Vector& from, const Vector& to, F visit)
+{
+  Vector direction = to - from;
+
+  cast(from, direction, direction.length(), [&visit] (long x, long y) {
+    visit(x, y);
+    return false;
+  });
+}
+
+#endif
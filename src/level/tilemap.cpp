@@ -0,0 +1,191 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "level/tilemap.hpp"
+
+#include <atomic>
+
+/** Last revision given to a tilemap, shared by all tilemaps */
+static std::atomic<uint64_t> g_revision(0);
+
+Tilemap::IdWidth
+Tilemap::get_id_width_for(uint32_t id)
+{
+  if (id <= TileGrid<uint8_t>::max_id())
+    return IdWidth::BITS_8;
+
+  if (id <= TileGrid<uint16_t>::max_id())
+    return IdWidth::BITS_16;
+
+  return IdWidth::BITS_32;
+}
+
+Tilemap::Tilemap(uint32_t max_id) :
+  m_revision(++g_revision),
+  m_id_width(get_id_width_for(max_id)),
+  m_grid_8(),
+  m_grid_16(),
+  m_grid_32()
+{
+}
+
+size_t
+Tilemap::get_width() const
+{
+  size_t width = 0;
+  visit([&width] (const auto& grid) { width = grid.get_width(); });
+  return width;
+}
+
+size_t
+Tilemap::get_height() const
+{
+  size_t height = 0;
+  visit([&height] (const auto& grid) { height = grid.get_height(); });
+  return height;
+}
+
+bool
+Tilemap::empty() const
+{
+  bool empty = true;
+  visit([&empty] (const auto& grid) { empty = grid.empty(); });
+  return empty;
+}
+
+Tilemap::IdWidth
+Tilemap::get_id_width() const
+{
+  return m_id_width;
+}
+
+/**
+ * Returns a hash of the size and tiles of the tilemap, which is the same for
+ * tilemaps holding the same tiles whatever their ID width. Only the parts
+ * changed since the last call are hashed again.
+ */
+uint64_t
+Tilemap::get_hash() const
+{
+  uint64_t hash = 0;
+  visit([&hash] (const auto& grid) {
+    hash = grid.get_hash(0, grid.get_height()) ^ grid.get_height();
+  });
+  return hash;
+}
+
+/**
+ * Returns the revision of the tiles. Tilemaps with the same revision hold the
+ * same tiles, but tilemaps with different revisions may hold the same tiles
+ * too, for example after a change was undone.
+ */
+uint64_t
+Tilemap::get_revision() const
+{
+  return m_revision;
+}
+
+uint32_t
+Tilemap::get(size_t x, size_t y) const
+{
+  uint32_t id = 0;
+  visit([&] (const auto& grid) { id = grid.get(x, y); });
+  return id;
+}
+
+void
+Tilemap::set(size_t x, size_t y, uint32_t id)
+{
+  // Check bounds before widening, so that an invalid call doesn't leave the
+  // tilemap needlessly widened
+  if (x >= get_width() || y >= get_height())
+    throw std::out_of_range("Tile coordinates out of range");
+
+  reserve_id(id);
+  visit([&] (auto& grid) { grid.set(x, y, id); });
+}
+
+/** Sets the @p length tiles starting at (@p x, @p y) to @p id. */
+void
+Tilemap::fill(size_t x, size_t y, size_t length, uint32_t id)
+{
+  if (x > get_width() || length > get_width() - x || y >= get_height())
+    throw std::out_of_range("Tile span out of range");
+
+  reserve_id(id);
+  visit([&] (auto& grid) { grid.fill(x, y, length, id); });
+}
+
+void
+Tilemap::resize(size_t width, size_t height, int off_x, int off_y,
+                uint32_t fill)
+{
+  reserve_id(fill);
+  visit([&] (auto& grid) { grid.resize(width, height, off_x, off_y, fill); });
+}
+
+void
+Tilemap::clear()
+{
+  visit([] (auto& grid) { grid.clear(); });
+}
+
+/**
+ * Makes sure the storage is wide enough to hold @p id, widening it if needed.
+ * The storage is never narrowed.
+ */
+void
+Tilemap::reserve_id(uint32_t id)
+{
+  IdWidth id_width = get_id_width_for(id);
+
+  if (id_width <= m_id_width)
+    return;
+
+  switch (id_width)
+  {
+    case IdWidth::BITS_8:
+      // Unreachable: nothing is narrower than 8 bits
+      break;
+
+    case IdWidth::BITS_16:
+      m_grid_16.assign(m_grid_8);
+      break;
+
+    case IdWidth::BITS_32:
+      if (m_id_width == IdWidth::BITS_8)
+        m_grid_32.assign(m_grid_8);
+      else
+        m_grid_32.assign(m_grid_16);
+      break;
+  }
+
+  // Release the memory of the previous storage
+  if (m_id_width == IdWidth::BITS_8)
+    m_grid_8.clear();
+  else
+    m_grid_16.clear();
+
+  m_id_width = id_width;
+  touch();
+}
+
+/** Gives the tilemap a new revision, before its tiles may be written. */
+void
+Tilemap::touch()
+{
+  m_revision = ++g_revision;
+}
@@ -0,0 +1,130 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_LEVEL_TILEMAP_HPP
+#define HEADER_STM_LEVEL_TILEMAP_HPP
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "level/tile_grid.hpp"
+
+/**
+ * Grid of tile IDs which stores each tile in the smallest integer type able to
+ * hold the largest ID seen so far. Placing an ID that doesn't fit in the
+ * current type transparently widens the whole storage.
+ *
+ * Code that needs to iterate over many tiles should use visit() to work on the
+ * underlying TileGrid directly instead of calling get() and set() per tile.
+ *
+ * Each tilemap has a revision, which changes whenever its tiles may have been
+ * written, including through visit(). Revisions are unique across tilemaps, so
+ * two tilemaps with the same revision are copies holding the same tiles.
+ */
+class Tilemap final
+{
+public:
+  enum class IdWidth
+  {
+    BITS_8,
+    BITS_16,
+    BITS_32
+  };
+
+public:
+  static IdWidth get_id_width_for(uint32_t id);
+
+public:
+  Tilemap(uint32_t max_id = 0);
+
+  size_t get_width() const;
+  size_t get_height() const;
+  bool empty() const;
+  IdWidth get_id_width() const;
+  uint64_t get_hash() const;
+  uint64_t get_revision() const;
+
+  uint32_t get(size_t x, size_t y) const;
+  void set(size_t x, size_t y, uint32_t id);
+  void fill(size_t x, size_t y, size_t length, uint32_t id);
+
+  void resize(size_t width, size_t height, int off_x, int off_y,
+              uint32_t fill);
+  void clear();
+  void reserve_id(uint32_t id);
+
+  template<typename F> void visit(F func);
+  template<typename F> void visit(F func) const;
+
+private:
+  void touch();
+
+private:
+  uint64_t m_revision;
+  IdWidth m_id_width;
+  TileGrid<uint8_t> m_grid_8;
+  TileGrid<uint16_t> m_grid_16;
+  TileGrid<uint32_t> m_grid_32;
+};
+
+/**
+ * Calls @p func with the TileGrid currently holding the tiles. @p func must be
+ * callable with a TileGrid of any of the supported ID types; a generic lambda
+ * is the easiest way to achieve that.
+ */
+template<typename F>
+void
+Tilemap::visit(F func)
+{
+  touch();
+
+  switch (m_id_width)
+  {
+    case IdWidth::BITS_8:
+      func(m_grid_8);
+      break;
+
+    case IdWidth::BITS_16:
+      func(m_grid_16);
+      break;
+
+    case IdWidth::BITS_32:
+      func(m_grid_32);
+      break;
+  }
+}
+
+template<typename F>
+void
+Tilemap::visit(F func) const
+{
+  switch (m_id_width)
+  {
+    case IdWidth::BITS_8:
+      func(m_grid_8);
+      break;
+
+    case IdWidth::BITS_16:
+      func(m_grid_16);
+      break;
+
+    case IdWidth::BITS_32:
+      func(m_grid_32);
+      break;
+  }
+}
+
+#endif
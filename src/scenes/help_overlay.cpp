@@ -0,0 +1,67 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "scenes/help_overlay.hpp"
+
+#include "SDL2/SDL.h"
+
+#include "video/drawing_context.hpp"
+
+HelpOverlay::HelpOverlay(SceneController& scene_controller,
+                         const std::string& text) :
+  Scene(scene_controller),
+  m_text(text)
+{
+}
+
+void
+HelpOverlay::event(const SDL_Event& event)
+{
+  // Releasing the key which opened the overlay mustn't close it
+  if ((event.type == SDL_KEYDOWN && !event.key.repeat)
+      || event.type == SDL_MOUSEBUTTONDOWN)
+  {
+    // Destroys this scene, nothing may use it afterwards
+    m_scene_controller.pop_scene();
+  }
+}
+
+void
+HelpOverlay::update(float dt_sec)
+{
+}
+
+void
+HelpOverlay::draw(DrawingContext& context) const
+{
+  context.draw_filled_rect(context.target_size, Color(0.0f, 0.0f, 0.0f, 0.6f),
+                           Blend::BLEND);
+  context.draw_text(m_text, "fonts/SuperTux-Medium.ttf", true, 16,
+                    TextAlign::CENTER, Rect(context.target_size).grown(-32.0f),
+                    Color(1.0f, 1.0f, 1.0f), Blend::BLEND);
+}
+
+bool
+HelpOverlay::needs_redraw() const
+{
+  return false;
+}
+
+bool
+HelpOverlay::is_opaque() const
+{
+  return false;
+}
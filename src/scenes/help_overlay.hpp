@@ -0,0 +1,49 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_SCENES_HELPOVERLAY_HPP
+#define HEADER_STM_SCENES_HELPOVERLAY_HPP
+
+#include "scenes/scene.hpp"
+
+#include <string>
+
+/**
+ * Shows some text above the scene beneath, which is dimmed and paused, until
+ * a key or a mouse button is pressed.
+ */
+class HelpOverlay final :
+  public Scene
+{
+public:
+  HelpOverlay(SceneController& scene_controller, const std::string& text);
+  virtual ~HelpOverlay() override = default;
+
+  virtual void event(const SDL_Event& event) override;
+  virtual void update(float dt_sec) override;
+  virtual void draw(DrawingContext& context) const override;
+  virtual bool needs_redraw() const override;
+  virtual bool is_opaque() const override;
+
+private:
+  std::string m_text;
+
+private:
+  HelpOverlay(const HelpOverlay&) = delete;
+  HelpOverlay& operator=(const HelpOverlay&) = delete;
+};
+
+#endif
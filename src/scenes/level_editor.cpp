@@ -16,6 +16,9 @@
 
 #include "scenes/level_editor.hpp"
 
+#include <memory>
+
+#include "scenes/level_play.hpp"
 #include "util/log.hpp"
 
 LevelEditor::LevelEditor(SceneController& scene_controller) :
@@ -39,7 +42,9 @@ LevelEditor::event(const SDL_Event& event)
           case SDLK_s:
             try
             {
-              m_tilemap.save_tilemap("/levels/level.bmp");
+              m_tilemap.save_tilemap((event.key.keysym.mod & KMOD_SHIFT)
+                                     ? "/levels/level.bmp"
+                                     : "/levels/level.stml");
             }
             catch (const std::exception& e)
             {
@@ -50,7 +55,58 @@ LevelEditor::event(const SDL_Event& event)
           case SDLK_o:
             try
             {
-              m_tilemap.load_tilemap("/levels/level.bmp");
+              m_tilemap.load_tilemap((event.key.keysym.mod & KMOD_SHIFT)
+                                     ? "/levels/level.bmp"
+                                     : "/levels/level.stml");
+            }
+            catch (const std::exception& e)
+            {
+              log_error << e.what() << std::endl;
+            }
+            break;
+
+          case SDLK_z:
+            if (event.key.keysym.mod & KMOD_SHIFT)
+              m_tilemap.redo();
+            else
+              m_tilemap.undo();
+            break;
+
+          case SDLK_y:
+            m_tilemap.redo();
+            break;
+
+          case SDLK_c:
+            m_tilemap.copy_selection();
+            break;
+
+          case SDLK_x:
+            m_tilemap.cut_selection();
+            break;
+
+          case SDLK_v:
+            m_tilemap.paste();
+            break;
+
+          case SDLK_n:
+            m_tilemap.add_layer("layer");
+            break;
+
+          case SDLK_e:
+            try
+            {
+              m_tilemap.save_tilemap("/levels/level.raw.stml", false);
+            }
+            catch (const std::exception& e)
+            {
+              log_error << e.what() << std::endl;
+            }
+            break;
+
+          case SDLK_m:
+            try
+            {
+              m_tilemap.open_mapped("/levels/level.raw.stml");
             }
             catch (const std::exception& e)
             {
@@ -59,6 +115,72 @@ LevelEditor::event(const SDL_Event& event)
             break;
         }
       }
+      else
+      {
+        switch (event.key.keysym.sym)
+        {
+          case SDLK_b:
+            m_tilemap.set_tool(EditorTilemap::Tool::BRUSH);
+            break;
+
+          case SDLK_l:
+            m_tilemap.set_tool(EditorTilemap::Tool::LINE);
+            break;
+
+          case SDLK_r:
+            m_tilemap.set_tool(EditorTilemap::Tool::RECTANGLE);
+            break;
+
+          case SDLK_f:
+            m_tilemap.set_tool(EditorTilemap::Tool::FILL);
+            break;
+
+          case SDLK_s:
+            m_tilemap.set_tool(EditorTilemap::Tool::SELECT);
+            break;
+
+          case SDLK_p:
+          {
+            // Copied now, the editor may change its own level meanwhile; the
+            // rest of the setup happens on a worker thread
+            auto tilemap = std::make_shared<Tilemap>(
+                                        m_tilemap.get_interactive_tilemap());
+            Vector spawn = m_tilemap.get_mouse_tile();
+            SceneController& controller = m_scene_controller;
+
+            m_scene_controller.push_scene_async([tilemap, spawn, &controller] {
+              return std::make_unique<LevelPlay>(controller,
+                                                 std::move(*tilemap), spawn);
+            });
+            break;
+          }
+
+          case SDLK_h:
+            m_tilemap.toggle_layer_visibility();
+            break;
+
+          case SDLK_MINUS:
+            m_tilemap.change_layer_opacity(-0.25f);
+            break;
+
+          case SDLK_EQUALS:
+            m_tilemap.change_layer_opacity(0.25f);
+            break;
+
+          case SDLK_1:
+          case SDLK_2:
+          case SDLK_3:
+          case SDLK_4:
+          case SDLK_5:
+          case SDLK_6:
+          case SDLK_7:
+          case SDLK_8:
+          case SDLK_9:
+            m_tilemap.select_layer(static_cast<size_t>(event.key.keysym.sym
+                                                       - SDLK_1));
+            break;
+        }
+      }
       break;
 
     default:
@@ -77,3 +199,16 @@ LevelEditor::draw(DrawingContext& context) const
 {
   m_tilemap.draw(context);
 }
+
+bool
+LevelEditor::needs_redraw() const
+{
+  return m_tilemap.needs_redraw();
+}
+
+/** Levels keep being saved or loaded while playing them. */
+bool
+LevelEditor::updates_in_background() const
+{
+  return true;
+}
@@ -31,6 +31,8 @@ public:
   virtual void event(const SDL_Event& event) override;
   virtual void update(float dt_sec) override;
   virtual void draw(DrawingContext& context) const override;
+  virtual bool needs_redraw() const override;
+  virtual bool updates_in_background() const override;
 
   void load();
   void save() const;
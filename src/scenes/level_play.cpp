@@ -0,0 +1,242 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "scenes/level_play.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+
+#include "SDL2/SDL.h"
+
+#include "editor/editor_tilemap.hpp"
+#include "scenes/help_overlay.hpp"
+#include "util/math.hpp"
+#include "util/size.hpp"
+#include "video/drawing_context.hpp"
+
+static const float g_tile_size = 32.0f;
+static const Size g_player_size(24.0f, 30.0f);
+static const Size g_box_size(24.0f, 24.0f);
+static const float g_walk_speed = 250.0f;
+static const float g_jump_speed = 650.0f;
+
+/**
+ * @param tilemap The level to play, owned by the scene so that the editor can
+ *                keep changing its own.
+ * @param spawn_tile Where the player starts, in tiles. If the tile is solid,
+ *                   the player starts on the first free tile above.
+ */
+LevelPlay::LevelPlay(SceneController& scene_controller, Tilemap tilemap,
+                     const Vector& spawn_tile) :
+  Scene(scene_controller),
+  m_tilemap(std::move(tilemap)),
+  m_mask(EditorTilemap::get_solid_tiles()),
+  m_physics(m_mask, g_tile_size),
+  m_bodies(),
+  m_spawn(spawn_tile),
+  m_left(false),
+  m_right(false)
+{
+  m_mask.build(m_tilemap);
+
+  while (m_mask.is_solid(static_cast<long>(m_spawn.x),
+                         static_cast<long>(m_spawn.y)))
+    m_spawn.y -= 1.0f;
+
+  m_bodies.emplace_back(Rect());
+  respawn();
+}
+
+void
+LevelPlay::event(const SDL_Event& event)
+{
+  switch (event.type)
+  {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+    {
+      bool down = (event.type == SDL_KEYDOWN);
+
+      switch (event.key.keysym.sym)
+      {
+        case SDLK_LEFT:
+          m_left = down;
+          break;
+
+        case SDLK_RIGHT:
+          m_right = down;
+          break;
+
+        case SDLK_UP:
+        case SDLK_SPACE:
+          if (down && m_bodies.front().on_ground)
+            m_bodies.front().velocity.y = -g_jump_speed;
+          break;
+
+        case SDLK_b:
+          if (down && !event.key.repeat)
+            drop_box();
+          break;
+
+        case SDLK_F1:
+          if (down && !event.key.repeat)
+          {
+            // The overlay gets the key releases meanwhile
+            m_left = m_right = false;
+            m_scene_controller.push_scene(std::make_unique<HelpOverlay>(
+                                            m_scene_controller,
+                                            "Arrows: move\n"
+                                            "Up or Space: jump\n"
+                                            "B: drop a box\n"
+                                            "Escape: go back to the editor\n\n"
+                                            "Press any key to resume"));
+          }
+          break;
+
+        case SDLK_ESCAPE:
+          // Destroys this scene, nothing may use it afterwards
+          if (down)
+            m_scene_controller.pop_scene();
+          break;
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+void
+LevelPlay::update(float dt_sec)
+{
+  TilePhysics::Body& player = m_bodies.front();
+  player.velocity.x = ((m_right ? 1.0f : 0.0f) - (m_left ? 1.0f : 0.0f))
+                      * g_walk_speed;
+
+  m_physics.step(m_bodies, dt_sec);
+
+  // Nothing stops bodies from falling off the level
+  float bottom = static_cast<float>(m_mask.get_height() + 10) * g_tile_size;
+
+  if (player.box.y1 > bottom)
+    respawn();
+
+  m_bodies.erase(std::remove_if(m_bodies.begin() + 1, m_bodies.end(),
+                                [bottom] (const TilePhysics::Body& body) {
+                   return body.box.y1 > bottom;
+                 }), m_bodies.end());
+}
+
+void
+LevelPlay::draw(DrawingContext& context) const
+{
+  context.draw_filled_rect(context.target_size, Color(0.1f, 0.2f, 0.4f),
+                           Blend::NONE);
+
+  // Bodies are drawn between their two last positions, so that they move
+  // smoothly when there are more frames than updates
+  Rect player = m_bodies.front().get_drawn_box(context.alpha);
+
+  // The camera follows the player
+  Vector camera = player.mid()
+                  - Vector(context.target_size) / 2.0f;
+
+  context.push_transform();
+  context.get_transform().move(-camera);
+
+  // Only the tiles on screen are drawn
+  auto width = static_cast<long>(m_tilemap.get_width());
+  auto height = static_cast<long>(m_tilemap.get_height());
+  long x1 = Math::clamp(static_cast<long>(std::floor(camera.x / g_tile_size)),
+                        0L, width);
+  long y1 = Math::clamp(static_cast<long>(std::floor(camera.y / g_tile_size)),
+                        0L, height);
+  long x2 = Math::clamp(static_cast<long>(std::ceil((camera.x
+                                                     + context.target_size.w)
+                                                    / g_tile_size)),
+                        0L, width);
+  long y2 = Math::clamp(static_cast<long>(std::ceil((camera.y
+                                                     + context.target_size.h)
+                                                    / g_tile_size)),
+                        0L, height);
+
+  const auto& textures = EditorTilemap::get_tile_textures();
+
+  m_tilemap.visit([&] (const auto& grid) {
+    for (long y = y1; y < y2; y++)
+    {
+      const auto* row = grid.get_row(static_cast<size_t>(y));
+
+      for (long x = x1; x < x2; x++)
+      {
+        if (row[x] >= textures.size() || textures[row[x]].empty())
+          continue;
+
+        Rect tile_rect(Vector(x, y) * g_tile_size,
+                       Size(g_tile_size, g_tile_size));
+
+        context.draw_texture(textures[row[x]], true, {}, tile_rect,
+                             Color(1.0f, 1.0f, 1.0f), Blend::BLEND);
+      }
+    }
+  });
+
+  for (size_t i = 1; i < m_bodies.size(); i++)
+    context.draw_filled_rect(m_bodies[i].get_drawn_box(context.alpha),
+                             Color(0.6f, 0.4f, 0.2f), Blend::BLEND);
+
+  context.draw_filled_rect(player, Color(1.0f, 0.8f, 0.2f), Blend::BLEND);
+
+  context.pop_transform();
+
+  context.draw_text("Press F1 to see the controls",
+                    "fonts/SuperTux-Medium.ttf", true, 12, TextAlign::TOP_LEFT,
+                    Rect(context.target_size).grown(-8.0f),
+                    Color(1.0f, 1.0f, 1.0f), Blend::BLEND);
+}
+
+/** Brings the player back to the start of the level, standing still. */
+void
+LevelPlay::respawn()
+{
+  TilePhysics::Body& player = m_bodies.front();
+
+  // Centered on the bottom of the tile
+  Vector pos(m_spawn.x * g_tile_size + (g_tile_size - g_player_size.w) / 2.0f,
+             (m_spawn.y + 1.0f) * g_tile_size - g_player_size.h);
+  player = TilePhysics::Body(Rect(pos, g_player_size));
+}
+
+/** Drops a box above the player, if there is room for it. */
+void
+LevelPlay::drop_box()
+{
+  const Rect& player = m_bodies.front().box;
+  Vector pos(player.mid().x - g_box_size.w / 2.0f,
+             player.y1 - g_tile_size - g_box_size.h);
+  Rect box(pos, g_box_size);
+
+  if (m_mask.overlaps(static_cast<long>(std::floor(box.x1 / g_tile_size)),
+                      static_cast<long>(std::floor(box.y1 / g_tile_size)),
+                      static_cast<long>(std::ceil(box.x2 / g_tile_size)) - 1,
+                      static_cast<long>(std::ceil(box.y2 / g_tile_size)) - 1))
+    return;
+
+  m_bodies.emplace_back(box);
+}
@@ -0,0 +1,61 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_SCENES_LEVELPLAY_HPP
+#define HEADER_STM_SCENES_LEVELPLAY_HPP
+
+#include "scenes/scene.hpp"
+
+#include <vector>
+
+#include "level/solid_mask.hpp"
+#include "level/tile_physics.hpp"
+#include "level/tilemap.hpp"
+#include "util/vector.hpp"
+
+/** Lets the player run and jump through a level. */
+class LevelPlay final :
+  public Scene
+{
+public:
+  LevelPlay(SceneController& scene_controller, Tilemap tilemap,
+            const Vector& spawn_tile);
+  virtual ~LevelPlay() override = default;
+
+  virtual void event(const SDL_Event& event) override;
+  virtual void update(float dt_sec) override;
+  virtual void draw(DrawingContext& context) const override;
+
+private:
+  void respawn();
+  void drop_box();
+
+private:
+  Tilemap m_tilemap;
+  SolidMask m_mask;
+  TilePhysics m_physics;
+  /** The player comes first, then the boxes */
+  std::vector<TilePhysics::Body> m_bodies;
+  Vector m_spawn;
+  bool m_left;
+  bool m_right;
+
+private:
+  LevelPlay(const LevelPlay&) = delete;
+  LevelPlay& operator=(const LevelPlay&) = delete;
+};
+
+#endif
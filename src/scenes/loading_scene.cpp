@@ -0,0 +1,137 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "scenes/loading_scene.hpp"
+
+#include <chrono>
+#include <exception>
+#include <string>
+#include <utility>
+
+#include "util/log.hpp"
+#include "video/drawing_context.hpp"
+
+/** Time between two changes of the animation */
+static const float g_dot_sec = 0.25f;
+
+/**
+ * @param factory Makes the next scene, on a worker thread. It may load files
+ *                and build caches, but mustn't use the renderer or the scene
+ *                controller, which belong to the main thread.
+ */
+LoadingScene::LoadingScene(SceneController& scene_controller,
+                           SceneController::SceneFactory factory) :
+  Scene(scene_controller),
+  m_factory(std::move(factory)),
+  m_scene(),
+  m_time(0.0f),
+  m_drawn_dots(-1)
+{
+#ifndef EMSCRIPTEN
+  m_scene = std::async(std::launch::async, m_factory);
+#endif
+}
+
+LoadingScene::~LoadingScene()
+{
+#ifndef EMSCRIPTEN
+  if (m_scene.valid()
+      && m_scene.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+  {
+    log_info << "Waiting for the scene being loaded" << std::endl;
+    m_scene.wait();
+  }
+#endif
+}
+
+void
+LoadingScene::event(const SDL_Event& event)
+{
+  // Other input is ignored until the next scene is ready
+  if (event.type == SDL_QUIT && m_scene.valid())
+    log_info << "Quitting once the scene being loaded is ready" << std::endl;
+}
+
+void
+LoadingScene::update(float dt_sec)
+{
+  m_time += dt_sec;
+
+#ifdef EMSCRIPTEN
+  // No threads; the scene is made once this one was shown, blocking the frame
+  if (m_drawn_dots < 0)
+    return;
+
+  if (!m_scene.valid())
+    m_scene = std::async(std::launch::deferred, m_factory);
+#else
+  if (m_scene.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return;
+#endif
+
+  // Popping destroys this scene, nothing may use it afterwards
+  SceneController& scene_controller = m_scene_controller;
+
+  try
+  {
+    auto scene = m_scene.get();
+    scene_controller.pop_scene();
+    scene_controller.push_scene(std::move(scene));
+  }
+  catch (const std::exception& e)
+  {
+    log_error << "Could not load scene: " << e.what() << std::endl;
+    scene_controller.pop_scene();
+  }
+  catch (...)
+  {
+    log_error << "Could not load scene: unknown error" << std::endl;
+    scene_controller.pop_scene();
+  }
+}
+
+void
+LoadingScene::draw(DrawingContext& context) const
+{
+  m_drawn_dots = get_dots();
+  std::string dots(static_cast<size_t>(m_drawn_dots), '.');
+
+  context.draw_filled_rect(context.target_size, Color(0.0f, 0.0f, 0.0f, 0.6f),
+                           Blend::BLEND);
+  context.draw_text("Loading" + dots,
+                    "fonts/SuperTux-Medium.ttf", true, 16, TextAlign::BOT_LEFT,
+                    Rect(context.target_size).grown(-16.0f),
+                    Color(1.0f, 1.0f, 1.0f), Blend::BLEND);
+}
+
+bool
+LoadingScene::needs_redraw() const
+{
+  return m_drawn_dots != get_dots();
+}
+
+bool
+LoadingScene::is_opaque() const
+{
+  return false;
+}
+
+/** Returns how many dots to show after "Loading", from 0 to 3. */
+int
+LoadingScene::get_dots() const
+{
+  return static_cast<int>(m_time / g_dot_sec) % 4;
+}
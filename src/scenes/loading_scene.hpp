@@ -0,0 +1,62 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_SCENES_LOADINGSCENE_HPP
+#define HEADER_STM_SCENES_LOADINGSCENE_HPP
+
+#include "scenes/scene.hpp"
+
+#include <future>
+#include <memory>
+
+/**
+ * Shown above the previous scene while the next one is made on a worker
+ * thread, then replaced by it between two frames.
+ *
+ * Destroying this scene waits until the next one is made, as the factory can't
+ * be interrupted and may use objects which outlive this scene. Quitting while
+ * loading thus only closes the game once the factory is done.
+ */
+class LoadingScene final :
+  public Scene
+{
+public:
+  LoadingScene(SceneController& scene_controller,
+               SceneController::SceneFactory factory);
+  virtual ~LoadingScene() override;
+
+  virtual void event(const SDL_Event& event) override;
+  virtual void update(float dt_sec) override;
+  virtual void draw(DrawingContext& context) const override;
+  virtual bool needs_redraw() const override;
+  virtual bool is_opaque() const override;
+
+private:
+  int get_dots() const;
+
+private:
+  SceneController::SceneFactory m_factory;
+  std::future<std::unique_ptr<Scene>> m_scene;
+  float m_time;
+  /** Dots shown after "Loading" when last drawn, or -1 if never drawn */
+  mutable int m_drawn_dots;
+
+private:
+  LoadingScene(const LoadingScene&) = delete;
+  LoadingScene& operator=(const LoadingScene&) = delete;
+};
+
+#endif
@@ -51,3 +51,9 @@ MainMenu::draw(DrawingContext& context) const
                     TextAlign::BOT_RIGHT, dst, Color(1.0f, 1.0f, 1.0f),
                     Blend::BLEND);
 }
+
+bool
+MainMenu::needs_redraw() const
+{
+  return false;
+}
@@ -31,6 +31,7 @@ public:
   virtual void event(const SDL_Event& event) override;
   virtual void update(float dt_sec) override;
   virtual void draw(DrawingContext& context) const override;
+  virtual bool needs_redraw() const override;
 
 private:
   MainMenu(const MainMenu&) = delete;
@@ -20,3 +20,35 @@ Scene::Scene(SceneController& scene_controller) :
   m_scene_controller(scene_controller)
 {
 }
+
+/**
+ * Returns whether the scene would look different if it was drawn now. Input
+ * events always cause a redraw; this is for changes which happen on their own,
+ * like animations. When it returns false, the game sleeps until the next event.
+ */
+bool
+Scene::needs_redraw() const
+{
+  return true;
+}
+
+/**
+ * Returns whether the scene covers the whole target when drawn. The scenes
+ * beneath an opaque scene aren't drawn; those beneath a translucent one are,
+ * so that dialogs and menus can show what they are above.
+ */
+bool
+Scene::is_opaque() const
+{
+  return true;
+}
+
+/**
+ * Returns whether the scene keeps being updated while other scenes are above
+ * it. Only the scene on top receives events either way.
+ */
+bool
+Scene::updates_in_background() const
+{
+  return false;
+}
@@ -33,6 +33,9 @@ public:
   virtual void event(const SDL_Event& event) = 0;
   virtual void update(float dt_sec) = 0;
   virtual void draw(DrawingContext& context) const = 0;
+  virtual bool needs_redraw() const;
+  virtual bool is_opaque() const;
+  virtual bool updates_in_background() const;
 
 protected:
   SceneController& m_scene_controller;
@@ -134,3 +134,20 @@ TEST(API__cli_options__incorrect_arg)
   EXPECT(!log.get_err().str().empty());
   EXPECT(log.get_err().str().find("--this-is-not-an-arg") != std::string::npos);
 }
+
+TEST(API__cli_options__validate_levels_missing_dir)
+{
+  LogScanner log;
+
+  const char* const args[] = {
+    arg0,
+    "--validate-levels",
+    nullptr
+  };
+
+  int code = GameManager().run(sizeof(args) / sizeof(const char*) - 1, args);
+
+  EXPECT_NEQ(code, 0);
+  EXPECT(log.get_out().str().empty());
+  EXPECT(log.get_err().str().find("--validate-levels") != std::string::npos);
+}
@@ -56,6 +56,36 @@ public:
   {
     m_mock_calls_draw++;
   }
+
+private:
+  bool m_mock_needs_redraw = false;
+public:
+  void mock_set_needs_redraw(bool redraw) { m_mock_needs_redraw = redraw; }
+  virtual bool needs_redraw() const override
+  {
+    return m_mock_needs_redraw;
+  }
+
+private:
+  bool m_mock_is_opaque = true;
+public:
+  void mock_set_is_opaque(bool opaque) { m_mock_is_opaque = opaque; }
+  virtual bool is_opaque() const override
+  {
+    return m_mock_is_opaque;
+  }
+
+private:
+  bool m_mock_updates_in_background = false;
+public:
+  void mock_set_updates_in_background(bool updates)
+  {
+    m_mock_updates_in_background = updates;
+  }
+  virtual bool updates_in_background() const override
+  {
+    return m_mock_updates_in_background;
+  }
 };
 
 #endif
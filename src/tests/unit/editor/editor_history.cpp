@@ -0,0 +1,277 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "editor/editor_history.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "level/solid_mask.hpp"
+
+TEST(UNIT__EditorHistory__undo_redo)
+{
+  Tilemap tilemap(3);
+  tilemap.resize(4, 4, 0, 0, 0);
+  Vector offset(0.0f, 0.0f);
+  EditorHistory history;
+
+  EXPECT(!history.undo(tilemap, offset));
+
+  // A stroke which paints the same tile twice
+  history.begin_action();
+  tilemap.set(1, 1, 2);
+  history.record_tile(1, 1, 0, 2);
+  tilemap.set(1, 1, 3);
+  history.record_tile(1, 1, 2, 3);
+  tilemap.set(2, 1, 1);
+  history.record_tile(2, 1, 0, 1);
+  history.end_action();
+
+  history.begin_action();
+  tilemap.set(0, 0, 1);
+  history.record_tile(0, 0, 0, 1);
+  history.end_action();
+
+  EXPECT(history.undo(tilemap, offset));
+  EXPECT_EQ(tilemap.get(0, 0), 0u);
+  EXPECT_EQ(tilemap.get(1, 1), 3u);
+
+  EXPECT(history.undo(tilemap, offset));
+  EXPECT_EQ(tilemap.get(1, 1), 0u);
+  EXPECT_EQ(tilemap.get(2, 1), 0u);
+  EXPECT(!history.can_undo());
+
+  EXPECT(history.redo(tilemap, offset));
+  EXPECT_EQ(tilemap.get(1, 1), 3u);
+  EXPECT_EQ(tilemap.get(2, 1), 1u);
+  EXPECT_EQ(tilemap.get(0, 0), 0u);
+
+  // A new action drops the actions that could be redone
+  history.begin_action();
+  tilemap.set(3, 3, 2);
+  history.record_tile(3, 3, 0, 2);
+  history.end_action();
+
+  EXPECT(!history.can_redo());
+
+  // Actions that change nothing aren't recorded
+  history.begin_action();
+  history.record_tile(3, 2, 0, 0);
+  history.end_action();
+
+  EXPECT(history.undo(tilemap, offset));
+  EXPECT_EQ(tilemap.get(3, 3), 0u);
+}
+
+TEST(UNIT__EditorHistory__record_span)
+{
+  Tilemap tilemap(3);
+  tilemap.resize(6, 2, 0, 0, 0);
+  tilemap.set(1, 0, 1);
+  tilemap.set(2, 0, 1);
+  tilemap.set(4, 0, 2);
+  Vector offset(0.0f, 0.0f);
+  EditorHistory history;
+
+  history.begin_action();
+  tilemap.visit([&] (auto& grid) {
+    history.record_span(0, 0, grid.get_row(0), 6, 3);
+  });
+  tilemap.fill(0, 0, 6, 3);
+  history.end_action();
+
+  EXPECT(history.undo(tilemap, offset));
+  EXPECT_EQ(tilemap.get(0, 0), 0u);
+  EXPECT_EQ(tilemap.get(1, 0), 1u);
+  EXPECT_EQ(tilemap.get(2, 0), 1u);
+  EXPECT_EQ(tilemap.get(3, 0), 0u);
+  EXPECT_EQ(tilemap.get(4, 0), 2u);
+  EXPECT_EQ(tilemap.get(5, 0), 0u);
+
+  EXPECT(history.redo(tilemap, offset));
+
+  for (size_t x = 0; x < 6; x++)
+    EXPECT_EQ(tilemap.get(x, 0), 3u);
+
+  EXPECT_EQ(tilemap.get(0, 1), 0u);
+}
+
+TEST(UNIT__EditorHistory__record_row)
+{
+  Tilemap tilemap(3);
+  tilemap.resize(5, 1, 0, 0, 1);
+  Vector offset(0.0f, 0.0f);
+  EditorHistory history;
+
+  const uint8_t row[] = { 2, 2, 3, 1, 3 };
+
+  history.begin_action();
+  tilemap.visit([&] (auto& grid) {
+    history.record_row(0, 0, grid.get_row(0), row, 5);
+    std::copy(row, row + 5, grid.get_row(0));
+  });
+  history.end_action();
+
+  EXPECT(history.undo(tilemap, offset));
+
+  for (size_t x = 0; x < 5; x++)
+    EXPECT_EQ(tilemap.get(x, 0), 1u);
+
+  EXPECT(history.redo(tilemap, offset));
+
+  for (size_t x = 0; x < 5; x++)
+    EXPECT_EQ(tilemap.get(x, 0), row[x]);
+}
+
+TEST(UNIT__EditorHistory__resize)
+{
+  Tilemap tilemap(3);
+  tilemap.resize(2, 2, 0, 0, 0);
+  tilemap.set(0, 0, 1);
+  Vector offset(0.0f, 0.0f);
+  EditorHistory history;
+
+  // Painting above and to the left of the level grows it
+  history.begin_action();
+  tilemap.resize(3, 4, 1, 2, 0);
+  offset += Vector(1.0f, 2.0f);
+  history.record_resize(2, 2, 3, 4, 1, 2, 0);
+  tilemap.set(0, 0, 2);
+  history.record_tile(0, 0, 0, 2);
+  history.end_action();
+
+  EXPECT(history.undo(tilemap, offset));
+  EXPECT_EQ(tilemap.get_width(), 2u);
+  EXPECT_EQ(tilemap.get_height(), 2u);
+  EXPECT_EQ(tilemap.get(0, 0), 1u);
+  EXPECT_EQ(offset.x, 0.0f);
+  EXPECT_EQ(offset.y, 0.0f);
+
+  EXPECT(history.redo(tilemap, offset));
+  EXPECT_EQ(tilemap.get_width(), 3u);
+  EXPECT_EQ(tilemap.get_height(), 4u);
+  EXPECT_EQ(tilemap.get(0, 0), 2u);
+  EXPECT_EQ(tilemap.get(1, 2), 1u);
+  EXPECT_EQ(offset.x, 1.0f);
+  EXPECT_EQ(offset.y, 2.0f);
+}
+
+TEST(UNIT__EditorHistory__undo_redo__callbacks)
+{
+  const size_t size = 2048;
+  const size_t chunks = size / SolidMask::CHUNK_SIZE;
+
+  Tilemap tilemap(3);
+  tilemap.resize(size, size, 0, 0, 0);
+  Vector offset(0.0f, 0.0f);
+  EditorHistory history;
+
+  SolidMask mask({ false, true, false, true });
+  mask.build(tilemap);
+
+  auto on_fill = [&mask] (size_t x, size_t y, size_t length, uint32_t id) {
+    mask.fill(x, y, length, id);
+  };
+  auto on_resize = [&mask] (size_t width, size_t height, int off_x,
+                            int off_y, uint32_t fill) {
+    mask.resize(width, height, off_x, off_y, fill);
+  };
+
+  history.begin_action();
+  history.record_tile(1000, 1500, 0, 1);
+  tilemap.set(1000, 1500, 1);
+  mask.set(1000, 1500, 1);
+  history.end_action();
+
+  std::vector<uint32_t> versions;
+  for (size_t y = 0; y < chunks; y++)
+    for (size_t x = 0; x < chunks; x++)
+      versions.push_back(mask.get_chunk_version(x, y));
+
+  uint32_t generation = mask.get_generation();
+
+  // Only the chunk of the tile is touched, the mask isn't rebuilt
+  EXPECT(history.undo(tilemap, offset, on_fill, on_resize));
+  EXPECT(!mask.is_solid(1000, 1500));
+  EXPECT_EQ(mask.get_generation(), generation);
+
+  size_t tile_chunk_x = 1000 / SolidMask::CHUNK_SIZE;
+  size_t tile_chunk_y = 1500 / SolidMask::CHUNK_SIZE;
+
+  for (size_t y = 0; y < chunks; y++)
+  {
+    for (size_t x = 0; x < chunks; x++)
+    {
+      bool changed = mask.get_chunk_version(x, y) != versions[y * chunks + x];
+      EXPECT_EQ(changed, x == tile_chunk_x && y == tile_chunk_y);
+    }
+  }
+
+  EXPECT(history.redo(tilemap, offset, on_fill, on_resize));
+  EXPECT(mask.is_solid(1000, 1500));
+  EXPECT_EQ(mask.get_generation(), generation);
+
+  // Resizes are reported too
+  history.begin_action();
+  tilemap.resize(size + 1, size, 1, 0, 1);
+  mask.resize(size + 1, size, 1, 0, 1);
+  history.record_resize(size, size, size + 1, size, 1, 0, 1);
+  history.end_action();
+
+  EXPECT(history.undo(tilemap, offset, on_fill, on_resize));
+  EXPECT_EQ(mask.get_width(), size);
+  EXPECT(mask.is_solid(1000, 1500));
+  EXPECT(!mask.is_solid(0, 0));
+
+  EXPECT(history.redo(tilemap, offset, on_fill, on_resize));
+  EXPECT_EQ(mask.get_width(), size + 1);
+  EXPECT(mask.is_solid(0, 0));
+  EXPECT(mask.is_solid(1001, 1500));
+}
+
+TEST(UNIT__EditorHistory__memory_cap)
+{
+  Tilemap tilemap(1);
+  tilemap.resize(100, 100, 0, 0, 0);
+  Vector offset(0.0f, 0.0f);
+  EditorHistory history(4096);
+
+  for (size_t y = 0; y < 100; y++)
+  {
+    history.begin_action();
+    for (size_t x = 0; x < 10; x++)
+    {
+      tilemap.set(x, y, 1);
+      history.record_tile(x, y, 0, 1);
+    }
+    history.end_action();
+  }
+
+  EXPECT(history.get_memory_usage() <= 4096);
+
+  // Only the most recent actions can still be undone
+  size_t undone = 0;
+  while (history.undo(tilemap, offset))
+    undone++;
+
+  EXPECT(undone > 0);
+  EXPECT(undone < 100);
+  EXPECT_EQ(tilemap.get(0, 99), 0u);
+  EXPECT_EQ(tilemap.get(0, 0), 1u);
+}
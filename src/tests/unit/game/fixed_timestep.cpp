@@ -0,0 +1,63 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "game/fixed_timestep.hpp"
+
+#include <cmath>
+
+TEST(UNIT__FixedTimestep__advance)
+{
+  FixedTimestep timestep(100.0f, 5);
+
+  EXPECT_EQ(timestep.get_tick_duration(), 0.01f);
+  EXPECT_EQ(timestep.advance(0.005f), 0);
+  EXPECT(std::abs(timestep.get_alpha() - 0.5f) < 0.001f);
+
+  // The remainder of a frame carries over to the next one
+  EXPECT_EQ(timestep.advance(0.0251f), 3);
+  EXPECT(std::abs(timestep.get_alpha() - 0.01f) < 0.001f);
+
+  // Clock going backwards
+  EXPECT_EQ(timestep.advance(-1.0f), 0);
+
+  // Long pauses don't make the game fast-forward afterwards, but the part of
+  // a tick left over is kept
+  EXPECT_EQ(timestep.advance(10.005f), 5);
+  EXPECT(std::abs(timestep.get_alpha() - 0.51f) < 0.01f);
+  EXPECT_EQ(timestep.advance(0.0f), 0);
+
+  timestep.set_tick_rate(50.0f);
+  EXPECT_EQ(timestep.advance(0.05f), 2);
+
+  EXPECT_THROW(timestep.set_tick_rate(0.0f));
+}
+
+TEST(UNIT__FixedTimestep__frame_rate)
+{
+  // Whatever the frame rate, a second of real time makes 100 ticks
+  for (float fps : { 30.0f, 60.0f, 144.0f, 1000.0f })
+  {
+    FixedTimestep timestep(100.0f, 5);
+    int ticks = 0;
+
+    for (int i = 0; i < static_cast<int>(fps); i++)
+      ticks += timestep.advance(1.0f / fps);
+
+    EXPECT(std::abs(ticks - 100) <= 1);
+  }
+}
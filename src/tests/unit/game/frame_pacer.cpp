@@ -0,0 +1,57 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "game/frame_pacer.hpp"
+
+#include <limits>
+#include <thread>
+
+TEST(UNIT__FramePacer__wait)
+{
+  FramePacer pacer(0.005f);
+
+  EXPECT_EQ(pacer.get_period(), 0.005f);
+
+  // Frames are a period apart, not a period plus the time they took
+  auto start = FramePacer::Clock::now();
+  pacer.reset();
+
+  for (int i = 0; i < 10; i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    pacer.wait();
+  }
+
+  auto end = FramePacer::Clock::now();
+
+  EXPECT(end - start >= std::chrono::milliseconds(50));
+  EXPECT(end - start < std::chrono::milliseconds(75));
+
+  // Slow frames are counted, and the next ones get their whole period again
+  unsigned long missed = pacer.get_missed();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT(!pacer.wait());
+  EXPECT_EQ(pacer.get_missed(), missed + 1);
+
+  pacer.set_period(0.0f);
+  EXPECT(pacer.wait());
+
+  EXPECT_THROW(pacer.set_period(-1.0f));
+  EXPECT_THROW(pacer.set_period(FramePacer::MAX_PERIOD * 2.0f));
+  EXPECT_THROW(pacer.set_period(std::numeric_limits<float>::infinity()));
+}
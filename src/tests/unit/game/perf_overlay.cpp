@@ -0,0 +1,65 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "game/perf_overlay.hpp"
+
+#include <vector>
+
+TEST(UNIT__PerfOverlay__get_percentile)
+{
+  std::vector<float> samples;
+  for (int i = 100; i > 0; i--)
+    samples.push_back(static_cast<float>(i));
+
+  EXPECT_FLT_EQ(PerfOverlay::get_percentile(samples, 0.0f), 1.0f);
+  EXPECT_FLT_EQ(PerfOverlay::get_percentile(samples, 0.5f), 51.0f);
+  EXPECT_FLT_EQ(PerfOverlay::get_percentile(samples, 0.99f), 99.0f);
+  EXPECT_FLT_EQ(PerfOverlay::get_percentile(samples, 1.0f), 100.0f);
+
+  EXPECT_FLT_EQ(PerfOverlay::get_percentile({ 4.0f }, 0.99f), 4.0f);
+  EXPECT_THROW(PerfOverlay::get_percentile({}, 0.5f));
+}
+
+TEST(UNIT__PerfOverlay__needs_redraw)
+{
+  PerfOverlay overlay;
+  DrawingContext context;
+  DrawingContext::RenderStats stats;
+
+  EXPECT(!overlay.is_visible());
+  EXPECT(!overlay.needs_redraw());
+
+  // Hidden, nothing is recorded
+  overlay.record(0.01f, 0.001f, 0.002f, stats);
+  EXPECT(!overlay.needs_redraw());
+
+  overlay.toggle();
+  EXPECT(overlay.is_visible());
+  EXPECT(overlay.needs_redraw());
+
+  overlay.draw(context);
+  EXPECT(!overlay.needs_redraw());
+
+  // Frames in between refreshes don't change what is shown
+  overlay.record(0.01f, 0.001f, 0.002f, stats);
+  EXPECT(!overlay.needs_redraw());
+
+  overlay.toggle();
+  EXPECT(!overlay.is_visible());
+  EXPECT(!overlay.needs_redraw());
+}
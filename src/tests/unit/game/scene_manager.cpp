@@ -108,3 +108,132 @@ TEST(UNIT__SceneManager__scene_calls)
   EXPECT_EQ(s2.mock_get_calls_update(), 1);
   EXPECT_EQ(s2.mock_get_calls_draw(), 1);
 }
+
+TEST(UNIT__SceneManager__needs_redraw)
+{
+  SceneManager sm(nullptr);
+  DrawingContext dc;
+
+  EXPECT(!sm.needs_redraw());
+
+  auto scene = std::make_unique<MockScene>(sm.get_controller());
+  auto& s = *scene;
+
+  // A new scene must be shown, even if it doesn't change afterwards
+  sm.push_scene(std::move(scene));
+  EXPECT(sm.needs_redraw());
+  sm.draw(dc);
+  EXPECT(!sm.needs_redraw());
+
+  s.mock_set_needs_redraw(true);
+  EXPECT(sm.needs_redraw());
+  s.mock_set_needs_redraw(false);
+
+  sm.push_scene(std::make_unique<MockScene>(sm.get_controller()));
+  sm.draw(dc);
+  sm.pop_scene();
+  EXPECT(sm.needs_redraw());
+}
+
+TEST(UNIT__SceneManager__translucent_scenes)
+{
+  SceneManager sm(nullptr);
+  DrawingContext dc;
+
+  auto bottom = std::make_unique<MockScene>(sm.get_controller());
+  auto middle = std::make_unique<MockScene>(sm.get_controller());
+  auto top = std::make_unique<MockScene>(sm.get_controller());
+  auto& s1 = *bottom;
+  auto& s2 = *middle;
+  auto& s3 = *top;
+
+  s2.mock_set_updates_in_background(true);
+  s3.mock_set_is_opaque(false);
+
+  sm.push_scene(std::move(bottom));
+  sm.push_scene(std::move(middle));
+  sm.push_scene(std::move(top));
+
+  SDL_Event e;
+  SDL_zero(e);
+  e.type = SDL_FIRSTEVENT;
+
+  sm.event(e);
+  sm.update(0.0f);
+  sm.draw(dc);
+
+  // Drawn from the topmost opaque scene up, events only go to the top
+  EXPECT_EQ(s1.mock_get_calls_draw(), 0);
+  EXPECT_EQ(s2.mock_get_calls_draw(), 1);
+  EXPECT_EQ(s3.mock_get_calls_draw(), 1);
+  EXPECT_EQ(s1.mock_get_calls_update(), 0);
+  EXPECT_EQ(s2.mock_get_calls_update(), 1);
+  EXPECT_EQ(s3.mock_get_calls_update(), 1);
+  EXPECT_EQ(s1.mock_get_calls_event(), 0);
+  EXPECT_EQ(s2.mock_get_calls_event(), 0);
+  EXPECT_EQ(s3.mock_get_calls_event(), 1);
+
+  // Scenes beneath a translucent scene can cause redraws
+  EXPECT(!sm.needs_redraw());
+  s1.mock_set_needs_redraw(true);
+  EXPECT(!sm.needs_redraw());
+  s2.mock_set_needs_redraw(true);
+  EXPECT(sm.needs_redraw());
+
+  // Without any opaque scene, all of them are drawn
+  s2.mock_set_is_opaque(false);
+  s1.mock_set_is_opaque(false);
+  sm.draw(dc);
+
+  EXPECT_EQ(s1.mock_get_calls_draw(), 1);
+  EXPECT_EQ(s2.mock_get_calls_draw(), 2);
+  EXPECT_EQ(s3.mock_get_calls_draw(), 2);
+}
+
+TEST(UNIT__SceneManager__frozen_scenes)
+{
+  SceneManager sm(nullptr);
+  DrawingContext dc;
+  dc.target_size = Size(640.0f, 480.0f);
+
+  auto bottom = std::make_unique<MockScene>(sm.get_controller());
+  auto top = std::make_unique<MockScene>(sm.get_controller());
+  auto& s1 = *bottom;
+  auto& s2 = *top;
+
+  s1.mock_set_needs_redraw(true);
+  s2.mock_set_is_opaque(false);
+
+  sm.push_scene(std::move(bottom));
+  sm.push_scene(std::move(top));
+
+  // The scene beneath is only drawn once, and can't cause redraws afterwards
+  sm.draw(dc);
+  sm.draw(dc);
+  EXPECT_EQ(s1.mock_get_calls_draw(), 1);
+  EXPECT_EQ(s2.mock_get_calls_draw(), 2);
+  EXPECT(!sm.needs_redraw());
+
+  // Until the target is resized
+  dc.target_size = Size(800.0f, 600.0f);
+  sm.draw(dc);
+  EXPECT_EQ(s1.mock_get_calls_draw(), 2);
+
+  // Scenes updated in the background are drawn as long as they change
+  s1.mock_set_updates_in_background(true);
+  EXPECT(sm.needs_redraw());
+  sm.draw(dc);
+  sm.draw(dc);
+  EXPECT_EQ(s1.mock_get_calls_draw(), 4);
+
+  s1.mock_set_needs_redraw(false);
+  sm.draw(dc);
+  sm.draw(dc);
+  EXPECT_EQ(s1.mock_get_calls_draw(), 5);
+
+  // Back on top, the scene is drawn again every time
+  sm.pop_scene();
+  sm.draw(dc);
+  sm.draw(dc);
+  EXPECT_EQ(s1.mock_get_calls_draw(), 7);
+}
@@ -0,0 +1,147 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/level_bmp.hpp"
+
+#include <vector>
+
+#include "SDL2/SDL.h"
+
+static Tilemap
+load_from_memory(const std::vector<Uint8>& buffer, uint32_t max_id)
+{
+  SDL_RWops* ops = SDL_RWFromConstMem(buffer.data(),
+                                      static_cast<int>(buffer.size()));
+
+  try
+  {
+    Tilemap tilemap = LevelBmp::load(ops, max_id);
+    SDL_RWclose(ops);
+    return tilemap;
+  }
+  catch (...)
+  {
+    SDL_RWclose(ops);
+    throw;
+  }
+}
+
+static void
+push_u32(std::vector<Uint8>& buffer, uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+    buffer.push_back(static_cast<Uint8>(value >> (i * 8)));
+}
+
+/** Builds a 24 bits top-down BMP with a BITMAPINFOHEADER. */
+static std::vector<Uint8>
+make_bmp_24(int32_t width, int32_t height, const std::vector<uint32_t>& rgb)
+{
+  uint32_t stride = ((24 * width + 31) / 32) * 4;
+  std::vector<Uint8> buffer = { 'B', 'M' };
+
+  push_u32(buffer, 54 + stride * height);
+  push_u32(buffer, 0);
+  push_u32(buffer, 54);
+  push_u32(buffer, 40);
+  push_u32(buffer, width);
+  push_u32(buffer, static_cast<uint32_t>(-height));
+  push_u32(buffer, 1 | 24 << 16);
+  for (int i = 0; i < 6; i++)
+    push_u32(buffer, 0);
+
+  for (int32_t y = 0; y < height; y++)
+  {
+    for (int32_t x = 0; x < width; x++)
+    {
+      uint32_t color = rgb[y * width + x];
+      buffer.push_back(static_cast<Uint8>(color));
+      buffer.push_back(static_cast<Uint8>(color >> 8));
+      buffer.push_back(static_cast<Uint8>(color >> 16));
+    }
+
+    for (uint32_t i = width * 3; i < stride; i++)
+      buffer.push_back(0);
+  }
+
+  return buffer;
+}
+
+TEST(UNIT__LevelBmp__round_trip)
+{
+  Tilemap tilemap(300);
+  tilemap.resize(7, 5, 0, 0, 0);
+
+  for (size_t y = 0; y < tilemap.get_height(); y++)
+    for (size_t x = 0; x < tilemap.get_width(); x++)
+      tilemap.set(x, y, static_cast<uint32_t>((x * 37 + y * 61) % 301));
+
+  std::vector<Uint8> buffer(1 << 16);
+  SDL_RWops* ops = SDL_RWFromMem(buffer.data(),
+                                 static_cast<int>(buffer.size()));
+  LevelBmp::save(tilemap, ops);
+  buffer.resize(static_cast<size_t>(SDL_RWtell(ops)));
+  SDL_RWclose(ops);
+
+  EXPECT_EQ(buffer.size(), 14u + 108u + 7u * 5u * 4u);
+
+  Tilemap loaded = load_from_memory(buffer, 300);
+
+  EXPECT_EQ(loaded.get_width(), 7u);
+  EXPECT_EQ(loaded.get_height(), 5u);
+
+  for (size_t y = 0; y < tilemap.get_height(); y++)
+    for (size_t x = 0; x < tilemap.get_width(); x++)
+      EXPECT_EQ(loaded.get(x, y), tilemap.get(x, y));
+}
+
+TEST(UNIT__LevelBmp__load_24_bits)
+{
+  // Odd width, so that rows are padded
+  auto buffer = make_bmp_24(3, 2, { 0, 1, 2, 2, 1, 0 });
+  Tilemap tilemap = load_from_memory(buffer, 2);
+
+  EXPECT_EQ(tilemap.get_width(), 3u);
+  EXPECT_EQ(tilemap.get_height(), 2u);
+  EXPECT_EQ(tilemap.get(0, 0), 0u);
+  EXPECT_EQ(tilemap.get(1, 0), 1u);
+  EXPECT_EQ(tilemap.get(2, 0), 2u);
+  EXPECT_EQ(tilemap.get(0, 1), 2u);
+  EXPECT_EQ(tilemap.get(2, 1), 0u);
+}
+
+TEST(UNIT__LevelBmp__invalid)
+{
+  auto buffer = make_bmp_24(2, 2, { 0, 1, 3, 0 });
+  EXPECT_THROW(load_from_memory(buffer, 2));
+
+  buffer = make_bmp_24(2, 2, { 0, 1, 2, 0 });
+  buffer.resize(buffer.size() - 1);
+  EXPECT_THROW(load_from_memory(buffer, 2));
+
+  buffer[0] = 'X';
+  EXPECT_THROW(load_from_memory(buffer, 2));
+
+  // A top-down height of -2^31 can't be negated; it is at offset 22
+  buffer = make_bmp_24(2, 2, { 0, 1, 2, 0 });
+  buffer[22] = 0x00;
+  buffer[23] = 0x00;
+  buffer[24] = 0x00;
+  buffer[25] = 0x80;
+  EXPECT_THROW(load_from_memory(buffer, 2));
+}
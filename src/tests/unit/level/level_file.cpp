@@ -0,0 +1,272 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/level_file.hpp"
+
+#include <vector>
+
+#include "SDL2/SDL.h"
+
+static std::vector<Uint8>
+save_to_memory(const Tilemap& tilemap, bool compress = true,
+               LevelFile::SaveCache* cache = nullptr)
+{
+  std::vector<Uint8> buffer(1 << 20);
+  SDL_RWops* ops = SDL_RWFromMem(buffer.data(),
+                                 static_cast<int>(buffer.size()));
+
+  LevelFile::save(tilemap, ops, compress, nullptr, cache);
+  buffer.resize(static_cast<size_t>(SDL_RWtell(ops)));
+  SDL_RWclose(ops);
+
+  return buffer;
+}
+
+static Tilemap
+load_from_memory(const std::vector<Uint8>& buffer, uint32_t max_id,
+                 bool* compressed = nullptr)
+{
+  SDL_RWops* ops = SDL_RWFromConstMem(buffer.data(),
+                                      static_cast<int>(buffer.size()));
+
+  try
+  {
+    Tilemap tilemap = LevelFile::load(ops, max_id, nullptr, compressed);
+    SDL_RWclose(ops);
+    return tilemap;
+  }
+  catch (...)
+  {
+    SDL_RWclose(ops);
+    throw;
+  }
+}
+
+static void
+expect_same(const Tilemap& a, const Tilemap& b)
+{
+  EXPECT_EQ(a.get_width(), b.get_width());
+  EXPECT_EQ(a.get_height(), b.get_height());
+
+  for (size_t y = 0; y < a.get_height(); y++)
+    for (size_t x = 0; x < a.get_width(); x++)
+      EXPECT_EQ(a.get(x, y), b.get(x, y));
+}
+
+TEST(UNIT__LevelFile__round_trip)
+{
+  // Several chunks, with the last one incomplete
+  Tilemap tilemap(2);
+  tilemap.resize(37, LevelFile::CHUNK_ROWS * 2 + 5, 0, 0, 0);
+
+  for (size_t y = 0; y < tilemap.get_height(); y++)
+    for (size_t x = 0; x < tilemap.get_width(); x++)
+      if ((x * 7 + y * 3) % 11 < 4)
+        tilemap.set(x, y, 1 + (x + y) % 2);
+
+  auto buffer = save_to_memory(tilemap);
+  expect_same(load_from_memory(buffer, 2), tilemap);
+
+  // Empty levels are valid
+  auto empty_buffer = save_to_memory(Tilemap());
+  EXPECT(load_from_memory(empty_buffer, 2).empty());
+}
+
+TEST(UNIT__LevelFile__compression)
+{
+  Tilemap tilemap(2);
+  tilemap.resize(1000, 1000, 0, 0, 0);
+  tilemap.set(500, 500, 1);
+
+  auto buffer = save_to_memory(tilemap);
+
+  // A mostly empty level must be much smaller than its raw size
+  EXPECT(buffer.size() < 1000);
+  expect_same(load_from_memory(buffer, 2), tilemap);
+}
+
+TEST(UNIT__LevelFile__wide_ids)
+{
+  // Noise defeats RLE, which forces raw chunks with 32-bit IDs
+  Tilemap tilemap;
+  tilemap.resize(50, 70, 0, 0, 0);
+
+  for (size_t y = 0; y < tilemap.get_height(); y++)
+    for (size_t x = 0; x < tilemap.get_width(); x++)
+      tilemap.set(x, y, static_cast<uint32_t>((x * 2654435761u) ^ (y << 17))
+                        & 0xffffff);
+
+  EXPECT(tilemap.get_id_width() == Tilemap::IdWidth::BITS_32);
+
+  auto buffer = save_to_memory(tilemap);
+  expect_same(load_from_memory(buffer, 0xffffff), tilemap);
+}
+
+TEST(UNIT__LevelFile__invalid)
+{
+  Tilemap tilemap(5);
+  tilemap.resize(10, 10, 0, 0, 0);
+  tilemap.set(3, 4, 5);
+
+  auto buffer = save_to_memory(tilemap);
+
+  // Tile IDs beyond the tileset
+  EXPECT_THROW(load_from_memory(buffer, 4));
+
+  // Truncated file
+  auto truncated = buffer;
+  truncated.resize(truncated.size() - 3);
+  EXPECT_THROW(load_from_memory(truncated, 5));
+
+  // Bad magic
+  auto bad_magic = buffer;
+  bad_magic[0] = 'X';
+  EXPECT_THROW(load_from_memory(bad_magic, 5));
+
+  // Future version
+  auto future = buffer;
+  future[4] = 0xff;
+  EXPECT_THROW(load_from_memory(future, 5));
+
+  // Sizes too big to load, with the width at offset 8 and the height at 12
+  auto wide = buffer;
+  wide[8] = 0xff;
+  wide[9] = 0xff;
+  wide[10] = 0xff;
+  wide[11] = 0xff;
+  EXPECT_THROW(load_from_memory(wide, 5));
+
+  auto huge = buffer;
+  huge[8] = 0x00;
+  huge[9] = 0x40;
+  huge[12] = 0x00;
+  huge[13] = 0x80;
+  EXPECT_THROW(load_from_memory(huge, 5));
+
+  // More chunks than the height needs
+  auto chunks = buffer;
+  chunks[chunks.size() - 8] = 2;
+  EXPECT_THROW(load_from_memory(chunks, 5));
+
+  // Table of contents past the end of the file
+  auto toc = buffer;
+  toc[toc.size() - 10] = 0x01;
+  EXPECT_THROW(load_from_memory(toc, 5));
+
+  // Levels too big to be loaded can't be saved either
+  Tilemap too_wide(1);
+  too_wide.resize(LevelFile::MAX_SIZE + 1, 1, 0, 0, 0);
+  EXPECT_THROW(save_to_memory(too_wide));
+}
+
+TEST(UNIT__LevelFile__raw_layout)
+{
+  Tilemap tilemap(300);
+  tilemap.resize(5, LevelFile::CHUNK_ROWS + 3, 0, 0, 0);
+  tilemap.set(2, LevelFile::CHUNK_ROWS + 1, 300);
+
+  bool was_compressed = true;
+  auto buffer = save_to_memory(tilemap, false);
+  expect_same(load_from_memory(buffer, 300, &was_compressed), tilemap);
+  EXPECT(!was_compressed);
+
+  uint32_t width, height, id_bytes;
+  SDL_RWops* ops = SDL_RWFromConstMem(buffer.data(),
+                                      static_cast<int>(buffer.size()));
+  auto offset = LevelFile::get_raw_offset(ops, width, height, id_bytes);
+  SDL_RWclose(ops);
+
+  EXPECT_EQ(width, 5u);
+  EXPECT_EQ(height, LevelFile::CHUNK_ROWS + 3);
+  EXPECT_EQ(id_bytes, 2u);
+
+  // Rows are stored back to back, little-endian
+  size_t tile = offset + ((LevelFile::CHUNK_ROWS + 1) * 5 + 2) * 2;
+  EXPECT_EQ(buffer[tile] | buffer[tile + 1] << 8, 300);
+
+  // Compressed levels can't be accessed in place
+  auto compressed = save_to_memory(tilemap);
+  ops = SDL_RWFromConstMem(compressed.data(),
+                           static_cast<int>(compressed.size()));
+  EXPECT_THROW(LevelFile::get_raw_offset(ops, width, height, id_bytes));
+  SDL_RWclose(ops);
+
+  load_from_memory(compressed, 300, &was_compressed);
+  EXPECT(was_compressed);
+}
+
+TEST(UNIT__LevelFile__progress)
+{
+  Tilemap tilemap(1);
+  tilemap.resize(4, LevelFile::CHUNK_ROWS * 3, 0, 0, 1);
+
+  std::vector<float> steps;
+  auto progress = [&steps] (float done) { steps.push_back(done); };
+
+  std::vector<Uint8> buffer(1 << 16);
+  SDL_RWops* ops = SDL_RWFromMem(buffer.data(),
+                                 static_cast<int>(buffer.size()));
+  LevelFile::save(tilemap, ops, true, progress);
+  buffer.resize(static_cast<size_t>(SDL_RWtell(ops)));
+  SDL_RWclose(ops);
+
+  ops = SDL_RWFromConstMem(buffer.data(), static_cast<int>(buffer.size()));
+  LevelFile::load(ops, 1, progress);
+  SDL_RWclose(ops);
+
+  // One step per chunk, for both saving and loading
+  EXPECT_EQ(steps.size(), 6u);
+  EXPECT_EQ(steps[0], 1.0f / 3.0f);
+  EXPECT_EQ(steps[2], 1.0f);
+  EXPECT_EQ(steps[5], 1.0f);
+}
+
+TEST(UNIT__LevelFile__save_cache)
+{
+  Tilemap tilemap(300);
+  tilemap.resize(16, LevelFile::CHUNK_ROWS * 3, 0, 0, 0);
+  tilemap.fill(0, 0, 16, 2);
+  tilemap.set(5, LevelFile::CHUNK_ROWS * 2, 1);
+
+  LevelFile::SaveCache cache;
+  EXPECT(save_to_memory(tilemap, true, &cache) == save_to_memory(tilemap));
+  EXPECT_EQ(cache.size(), 3u);
+
+  // Saving again is served from the cache
+  const Uint8* cached_data = cache[0].data.data();
+  uint64_t hash_1 = cache[1].hash;
+  EXPECT(save_to_memory(tilemap, true, &cache) == save_to_memory(tilemap));
+  EXPECT(cache[0].data.data() == cached_data);
+
+  // Only the chunk that changed is encoded again
+  tilemap.set(0, LevelFile::CHUNK_ROWS, 3);
+  EXPECT(save_to_memory(tilemap, true, &cache) == save_to_memory(tilemap));
+  EXPECT(cache[0].data.data() == cached_data);
+  EXPECT(cache[1].hash != hash_1);
+
+  // Chunks cached with another ID width aren't reused
+  tilemap.set(0, 0, 300);
+  EXPECT(save_to_memory(tilemap, true, &cache) == save_to_memory(tilemap));
+  EXPECT_EQ(cache[2].id_bytes, 2u);
+
+  // Uncompressed saves don't use the cache
+  LevelFile::SaveCache raw_cache;
+  EXPECT(save_to_memory(tilemap, false, &raw_cache)
+         == save_to_memory(tilemap, false));
+  EXPECT(raw_cache.empty());
+}
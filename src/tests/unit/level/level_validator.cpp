@@ -0,0 +1,107 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/level_validator.hpp"
+
+#include <sstream>
+
+TEST(UNIT__LevelValidator__gather_stats)
+{
+  Tilemap tilemap(3);
+  tilemap.resize(4, 2, 0, 0, 0);
+  tilemap.set(0, 0, 1);
+  tilemap.set(1, 0, 1);
+  tilemap.set(3, 1, 3);
+
+  LevelValidator::Report report("level.stml");
+  LevelValidator::gather_stats(tilemap, 3, report);
+
+  EXPECT_EQ(report.width, 4u);
+  EXPECT_EQ(report.height, 2u);
+  EXPECT_EQ(report.non_empty, 3u);
+  EXPECT_EQ(report.histogram.size(), 4u);
+  EXPECT_EQ(report.histogram[0], 5u);
+  EXPECT_EQ(report.histogram[1], 2u);
+  EXPECT_EQ(report.histogram[2], 0u);
+  EXPECT_EQ(report.histogram[3], 1u);
+}
+
+TEST(UNIT__LevelValidator__validate)
+{
+  EXPECT(LevelValidator::is_level("/levels/a.stml"));
+  EXPECT(LevelValidator::is_level("/levels/a.bmp"));
+  EXPECT(!LevelValidator::is_level("/levels/a.stml.tmp"));
+
+  // Levels that can't be loaded are reported, in the order they were given
+  std::vector<std::string> files = {
+    "/does/not/exist/1.stml",
+    "/does/not/exist/2.bmp",
+    "/does/not/exist/3.stml"
+  };
+
+  auto reports = LevelValidator::validate(files, 2, 4);
+
+  EXPECT_EQ(reports.size(), 3u);
+
+  for (size_t i = 0; i < reports.size(); i++)
+  {
+    EXPECT_EQ(reports[i].file, files[i]);
+    EXPECT(!reports[i].error.empty());
+  }
+}
+
+TEST(UNIT__LevelValidator__write_json)
+{
+  Tilemap tilemap(1);
+  tilemap.resize(2, 1, 0, 0, 1);
+
+  std::vector<LevelValidator::Report> reports;
+  reports.emplace_back("good.stml");
+  LevelValidator::gather_stats(tilemap, 1, reports.back());
+  reports.emplace_back("bad \"level\".stml");
+  reports.back().error = "tile overflow";
+
+  std::stringstream out;
+  LevelValidator::write_json(out, reports);
+
+  EXPECT_EQ(out.str(), "{\n"
+                       "  \"valid\": 1,\n"
+                       "  \"invalid\": 1,\n"
+                       "  \"levels\": [\n"
+                       "    {\n"
+                       "      \"file\": \"good.stml\",\n"
+                       "      \"valid\": true,\n"
+                       "      \"width\": 2,\n"
+                       "      \"height\": 1,\n"
+                       "      \"non_empty\": 2,\n"
+                       "      \"non_empty_ratio\": 1,\n"
+                       "      \"histogram\": [0, 2]\n"
+                       "    },\n"
+                       "    {\n"
+                       "      \"file\": \"bad \\\"level\\\".stml\",\n"
+                       "      \"valid\": false,\n"
+                       "      \"error\": \"tile overflow\"\n"
+                       "    }\n"
+                       "  ]\n"
+                       "}\n");
+
+  std::stringstream empty;
+  LevelValidator::write_json(empty, {});
+  EXPECT_EQ(empty.str(), "{\n  \"valid\": 0,\n  \"invalid\": 0,\n"
+                         "  \"levels\": []\n}\n");
+}
@@ -0,0 +1,103 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/mapped_tilemap.hpp"
+
+#include <cstdio>
+#include <string>
+
+#include "SDL2/SDL.h"
+
+#include "level/level_file.hpp"
+
+static const std::string g_test_file = "stm_test_mapped_tilemap.stml";
+
+static void
+save_raw(const Tilemap& tilemap)
+{
+  SDL_RWops* ops = SDL_RWFromFile(g_test_file.c_str(), "wb");
+  LevelFile::save(tilemap, ops, false);
+  SDL_RWclose(ops);
+}
+
+TEST(UNIT__MappedTilemap__get_set)
+{
+  if (!MappedTilemap::is_supported())
+    return;
+
+  Tilemap tilemap(1000);
+  tilemap.resize(7, 130, 0, 0, 0);
+
+  for (size_t y = 0; y < tilemap.get_height(); y++)
+    tilemap.set(y % 7, y, static_cast<uint32_t>(y * 7));
+
+  save_raw(tilemap);
+
+  {
+    MappedTilemap mapped(g_test_file);
+
+    EXPECT_EQ(mapped.get_width(), 7u);
+    EXPECT_EQ(mapped.get_height(), 130u);
+    EXPECT(mapped.get_id_width() == Tilemap::IdWidth::BITS_16);
+
+    for (size_t y = 0; y < tilemap.get_height(); y++)
+      for (size_t x = 0; x < tilemap.get_width(); x++)
+        EXPECT_EQ(mapped.get(x, y), tilemap.get(x, y));
+
+    // Changes only copy the rows they touch
+    mapped.set(3, 100, 999);
+    mapped.set(4, 100, 998);
+    EXPECT_EQ(mapped.get(3, 100), 999u);
+    EXPECT_EQ(mapped.get(4, 100), 998u);
+    EXPECT_EQ(mapped.get(2, 100), tilemap.get(2, 100));
+    EXPECT_EQ(mapped.get_overlay_rows(), 1u);
+
+    EXPECT_THROW(mapped.set(0, 0, 0x10000));
+    EXPECT_THROW(mapped.get(7, 0));
+
+    size_t rows = 0;
+    mapped.visit_rows(99, 200, [&] (size_t y, const auto* row) {
+      EXPECT_EQ(row[y % 7], y * 7);
+      rows++;
+    });
+    EXPECT_EQ(rows, 31u);
+  }
+
+  // The file is never modified
+  MappedTilemap reopened(g_test_file);
+  EXPECT_EQ(reopened.get(3, 100), tilemap.get(3, 100));
+
+  std::remove(g_test_file.c_str());
+}
+
+TEST(UNIT__MappedTilemap__compressed)
+{
+  if (!MappedTilemap::is_supported())
+    return;
+
+  Tilemap tilemap(2);
+  tilemap.resize(10, 10, 0, 0, 1);
+
+  SDL_RWops* ops = SDL_RWFromFile(g_test_file.c_str(), "wb");
+  LevelFile::save(tilemap, ops);
+  SDL_RWclose(ops);
+
+  EXPECT_THROW(MappedTilemap mapped(g_test_file));
+
+  std::remove(g_test_file.c_str());
+}
@@ -0,0 +1,137 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/nav_grid.hpp"
+
+#include <chrono>
+
+#include "level/tilemap.hpp"
+
+static const std::vector<bool> g_solid = { false, true };
+
+TEST(UNIT__NavGrid__connected)
+{
+  // A wall splitting the level in two, across several chunks
+  Tilemap tilemap(1);
+  tilemap.resize(200, 150, 0, 0, 0);
+
+  for (size_t y = 0; y < 150; y++)
+    tilemap.set(100, y, 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+  NavGrid nav(mask);
+
+  EXPECT_EQ(nav.update(), 12u);
+  EXPECT_EQ(nav.update(), 0u);
+  EXPECT(nav.connected(0, 0, 99, 149));
+  EXPECT(nav.connected(101, 0, 199, 149));
+  EXPECT(!nav.connected(0, 0, 199, 0));
+  EXPECT(!nav.connected(0, 0, 100, 0));
+  EXPECT(!nav.connected(0, 0, 200, 0));
+
+  // Opening a door only labels its chunk again
+  mask.set(100, 70, 0);
+  EXPECT_EQ(nav.update(), 1u);
+  EXPECT(nav.connected(0, 0, 199, 0));
+
+  mask.set(100, 70, 1);
+  EXPECT(!nav.connected(0, 0, 199, 0));
+
+  // Diagonal gaps don't connect anything
+  mask.set(101, 70, 1);
+  mask.set(100, 70, 0);
+  EXPECT(!nav.connected(0, 0, 199, 0));
+
+  // Rebuilding the mask labels everything again
+  mask.build(tilemap);
+  EXPECT_EQ(nav.update(), 12u);
+}
+
+TEST(UNIT__NavGrid__chunk_borders)
+{
+  // Walls along the borders of the first chunk, on both sides of them
+  const size_t size = SolidMask::CHUNK_SIZE;
+  Tilemap tilemap(1);
+  tilemap.resize(size * 3, size * 3, 0, 0, 0);
+
+  for (size_t i = 0; i < size * 3; i++)
+  {
+    tilemap.set(size - 1, i, 1);
+    tilemap.set(i, size, 1);
+  }
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+  NavGrid nav(mask);
+
+  EXPECT(!nav.connected(0, 0, size, 0));
+  EXPECT(!nav.connected(0, size + 1, size, size + 1));
+  EXPECT(!nav.connected(size, 0, size, size + 1));
+
+  // A door on the left side of a border links the chunk on its right
+  mask.set(size - 1, 10, 0);
+  EXPECT_EQ(nav.update(), 1u);
+  EXPECT(nav.connected(0, 0, size, 0));
+
+  // A door on the lower side of a border links the chunk above it
+  mask.set(size + 5, size, 0);
+  EXPECT_EQ(nav.update(), 1u);
+  EXPECT(nav.connected(0, 0, size, size + 1));
+  EXPECT(nav.connected(0, 0, size * 3 - 1, size * 3 - 1));
+  EXPECT(!nav.connected(0, 0, 0, size * 3 - 1));
+
+  // Closing the first door splits regions of chunks which didn't change
+  mask.set(size - 1, 10, 1);
+  EXPECT_EQ(nav.update(), 1u);
+  EXPECT(!nav.connected(0, 0, size, 0));
+  EXPECT(nav.connected(size, 0, size * 3 - 1, size * 3 - 1));
+}
+
+TEST(BENCH__NavGrid__update)
+{
+  // Pillars every few tiles make many regions and links per border
+  Tilemap tilemap(1);
+  tilemap.resize(2048, 2048, 0, 0, 0);
+
+  for (size_t y = 0; y < 2048; y += 3)
+    for (size_t x = 0; x < 2048; x += 5)
+      tilemap.set(x, y, 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+  NavGrid nav(mask);
+  nav.update();
+
+  // A door opening and closing, as when the level is edited while playing
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < 100; i++)
+  {
+    mask.set(1000, 999, i % 2);
+    EXPECT_EQ(nav.update(), 1u);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  EXPECT(nav.connected(1, 1, 2046, 2046));
+
+#ifdef NDEBUG
+  EXPECT(end - start < std::chrono::milliseconds(50));
+#else
+  (void) (end - start);
+#endif
+}
@@ -0,0 +1,214 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/pathfinder.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#include "level/tilemap.hpp"
+
+static const std::vector<bool> g_solid = { false, true };
+
+/** A @p size x @p size level with about 1 in @p odds tiles solid. */
+static Tilemap
+make_level(size_t size, uint32_t odds, uint32_t seed)
+{
+  Tilemap tilemap(1);
+  tilemap.resize(size, size, 0, 0, 0);
+
+  for (size_t y = 0; y < size; y++)
+  {
+    for (size_t x = 0; x < size; x++)
+    {
+      seed = seed * 1103515245u + 12345u;
+
+      if ((seed >> 16) % odds == 0)
+        tilemap.set(x, y, 1);
+    }
+  }
+
+  return tilemap;
+}
+
+/**
+ * A @p size x @p size level with 16 tiles wide platforms every 32 rows, and a
+ * few blocks scattered around.
+ */
+static Tilemap
+make_platforms(size_t size)
+{
+  Tilemap tilemap = make_level(size, 200, 42);
+
+  for (size_t y = 16; y < size; y += 32)
+    for (size_t x = (y / 32 % 2) * 32; x < size; x += 64)
+      tilemap.fill(x, y, std::min<size_t>(16, size - x), 1);
+
+  return tilemap;
+}
+
+TEST(UNIT__Pathfinder__find_path)
+{
+  Tilemap tilemap(1);
+  tilemap.resize(10, 10, 0, 0, 0);
+
+  // A wall with a gap at the bottom, and a diagonal gap which can't be used
+  for (size_t y = 0; y < 8; y++)
+    tilemap.set(5, y, 1);
+  tilemap.set(6, 8, 1);
+  tilemap.set(6, 9, 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+  Pathfinder pathfinder(mask);
+  std::vector<Pathfinder::Tile> path;
+
+  for (auto algorithm : { Pathfinder::Algorithm::A_STAR,
+                          Pathfinder::Algorithm::JUMP_POINT })
+  {
+    EXPECT(pathfinder.find_path({ 0, 0 }, { 3, 0 }, path, algorithm));
+    EXPECT_EQ(path.size(), 4u);
+    EXPECT_EQ(Pathfinder::get_cost(path), 3.0f);
+
+    EXPECT(pathfinder.find_path({ 2, 2 }, { 2, 2 }, path, algorithm));
+    EXPECT_EQ(path.size(), 1u);
+
+    // Solid, outside or unreachable
+    EXPECT(!pathfinder.find_path({ 0, 0 }, { 5, 0 }, path, algorithm));
+    EXPECT(!pathfinder.find_path({ 0, 0 }, { -1, 0 }, path, algorithm));
+    EXPECT(!pathfinder.find_path({ 0, 0 }, { 9, 0 }, path, algorithm));
+    EXPECT(path.empty());
+
+    mask.set(6, 9, 0);
+    EXPECT(pathfinder.find_path({ 0, 0 }, { 9, 0 }, path, algorithm));
+    EXPECT(path.front() == Pathfinder::Tile(0, 0));
+    EXPECT(path.back() == Pathfinder::Tile(9, 0));
+
+    // Every step goes to a free neighbour without cutting corners
+    for (size_t i = 1; i < path.size(); i++)
+    {
+      long dx = path[i].x - path[i - 1].x;
+      long dy = path[i].y - path[i - 1].y;
+      EXPECT(std::abs(dx) <= 1 && std::abs(dy) <= 1 && (dx || dy));
+      EXPECT(!mask.is_solid(path[i].x, path[i].y));
+      EXPECT(!mask.is_solid(path[i - 1].x + dx, path[i - 1].y));
+      EXPECT(!mask.is_solid(path[i - 1].x, path[i - 1].y + dy));
+    }
+
+    mask.set(6, 9, 1);
+  }
+}
+
+TEST(UNIT__Pathfinder__jump_point)
+{
+  // Jump point search finds paths as short as A*
+  for (uint32_t seed = 0; seed < 20; seed++)
+  {
+    Tilemap tilemap = make_level(40, 3 + seed % 4, seed);
+    SolidMask mask(g_solid);
+    mask.build(tilemap);
+    Pathfinder pathfinder(mask);
+    std::vector<Pathfinder::Tile> path;
+
+    for (long i = 0; i < 20; i++)
+    {
+      Pathfinder::Tile start((i * 7) % 40, (i * 13) % 40);
+      Pathfinder::Tile goal((i * 29 + 5) % 40, (i * 17 + 11) % 40);
+
+      bool found = pathfinder.find_path(start, goal, path,
+                                        Pathfinder::Algorithm::A_STAR);
+      float cost = Pathfinder::get_cost(path);
+
+      EXPECT_EQ(pathfinder.find_path(start, goal, path,
+                                     Pathfinder::Algorithm::JUMP_POINT),
+                found);
+      EXPECT(std::abs(Pathfinder::get_cost(path) - cost) < 0.001f);
+    }
+  }
+}
+
+TEST(BENCH__Pathfinder__find_path)
+{
+  Tilemap tilemap = make_platforms(1024);
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+  Pathfinder pathfinder(mask);
+  std::vector<Pathfinder::Tile> path;
+
+  // Builds the navigation data and grows the pools, once for all queries
+  pathfinder.find_path({ 0, 0 }, { 0, 0 }, path);
+
+  size_t found = 0;
+
+  // Enemies chasing the player from a few screens away
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < 100; i++)
+  {
+    Pathfinder::Tile from((i * 97) % 1024, (i * 389) % 1024);
+    Pathfinder::Tile to = from;
+    to.x = std::min(to.x + 100, 1023L);
+    to.y = std::min(to.y + 60, 1023L);
+
+    found += pathfinder.find_path(from, to, path) ? 1 : 0;
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  EXPECT(found > 50);
+
+#ifdef NDEBUG
+  EXPECT(end - start < std::chrono::milliseconds(50));
+#else
+  (void) (end - start);
+#endif
+}
+
+TEST(BENCH__Pathfinder__a_star)
+{
+  // Same as above, as a reference for jump point search
+  Tilemap tilemap = make_platforms(1024);
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+  Pathfinder pathfinder(mask);
+  std::vector<Pathfinder::Tile> path;
+
+  pathfinder.find_path({ 0, 0 }, { 0, 0 }, path);
+
+  size_t found = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < 100; i++)
+  {
+    Pathfinder::Tile from((i * 97) % 1024, (i * 389) % 1024);
+    Pathfinder::Tile to = from;
+    to.x = std::min(to.x + 100, 1023L);
+    to.y = std::min(to.y + 60, 1023L);
+
+    found += pathfinder.find_path(from, to, path,
+                                  Pathfinder::Algorithm::A_STAR) ? 1 : 0;
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  EXPECT(found > 50);
+
+#ifdef NDEBUG
+  EXPECT(end - start < std::chrono::milliseconds(500));
+#else
+  (void) (end - start);
+#endif
+}
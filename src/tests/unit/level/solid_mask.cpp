@@ -0,0 +1,204 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/solid_mask.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+static const std::vector<bool> g_solid = { false, true, false, true };
+
+TEST(UNIT__SolidMask__build)
+{
+  Tilemap tilemap(3);
+  tilemap.resize(130, 2, 0, 0, 0);
+  tilemap.set(0, 0, 1);
+  tilemap.set(64, 0, 2);
+  tilemap.set(129, 1, 3);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+
+  EXPECT_EQ(mask.get_width(), 130u);
+  EXPECT_EQ(mask.get_height(), 2u);
+  EXPECT(mask.is_solid(0, 0));
+  EXPECT(!mask.is_solid(64, 0));
+  EXPECT(mask.is_solid(129, 1));
+  EXPECT(!mask.is_solid(130, 1));
+  EXPECT(!mask.is_solid(-1, 0));
+}
+
+TEST(UNIT__SolidMask__first_solid)
+{
+  Tilemap tilemap(1);
+  tilemap.resize(200, 1, 0, 0, 0);
+  tilemap.set(5, 0, 1);
+  tilemap.set(70, 0, 1);
+  tilemap.set(190, 0, 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+
+  EXPECT_EQ(mask.first_solid(0, 0, 200), 5u);
+  EXPECT_EQ(mask.first_solid(0, 6, 200), 70u);
+  EXPECT_EQ(mask.first_solid(0, 71, 190), SolidMask::NONE);
+  EXPECT_EQ(mask.first_solid(0, 71, 500), 190u);
+  EXPECT_EQ(mask.first_solid(1, 0, 200), SolidMask::NONE);
+
+  EXPECT_EQ(mask.last_solid(0, 0, 200), 190u);
+  EXPECT_EQ(mask.last_solid(0, 0, 190), 70u);
+  EXPECT_EQ(mask.last_solid(0, 6, 70), SolidMask::NONE);
+  EXPECT_EQ(mask.last_solid(0, 0, 6), 5u);
+}
+
+TEST(UNIT__SolidMask__overlaps)
+{
+  Tilemap tilemap(1);
+  tilemap.resize(100, 100, 0, 0, 0);
+  tilemap.set(50, 60, 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+
+  EXPECT(mask.overlaps(50, 60, 50, 60));
+  EXPECT(mask.overlaps(-10, -10, 200, 200));
+  EXPECT(!mask.overlaps(51, 0, 99, 99));
+  EXPECT(!mask.overlaps(0, 61, 99, 99));
+  EXPECT(!mask.overlaps(-5, -5, -1, -1));
+}
+
+TEST(UNIT__SolidMask__edit)
+{
+  Tilemap tilemap(3);
+  tilemap.resize(100, 3, 0, 0, 0);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+
+  mask.set(3, 0, 1);
+  EXPECT(mask.is_solid(3, 0));
+  mask.set(3, 0, 2);
+  EXPECT(!mask.is_solid(3, 0));
+
+  mask.fill(10, 1, 80, 3);
+  EXPECT_EQ(mask.first_solid(1, 0, 100), 10u);
+  EXPECT_EQ(mask.last_solid(1, 0, 100), 89u);
+  mask.fill(20, 1, 60, 0);
+  EXPECT_EQ(mask.first_solid(1, 20, 100), 80u);
+
+  uint8_t ids[] = { 0, 1, 2, 3 };
+  mask.assign(62, 2, ids, 4);
+  EXPECT(!mask.is_solid(62, 2));
+  EXPECT(mask.is_solid(63, 2));
+  EXPECT(!mask.is_solid(64, 2));
+  EXPECT(mask.is_solid(65, 2));
+
+  EXPECT_THROW(mask.set(100, 0, 1));
+  EXPECT_THROW(mask.fill(90, 0, 11, 1));
+}
+
+TEST(UNIT__SolidMask__resize)
+{
+  Tilemap tilemap(1);
+  tilemap.resize(2, 2, 0, 0, 0);
+  tilemap.set(1, 1, 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+
+  // Same arguments as Tilemap::resize()
+  mask.resize(70, 3, 66, 1, 0);
+  EXPECT_EQ(mask.get_width(), 70u);
+  EXPECT_EQ(mask.get_height(), 3u);
+  EXPECT(mask.is_solid(67, 2));
+  EXPECT(!mask.overlaps(0, 0, 66, 2));
+
+  mask.resize(2, 2, -66, -1, 1);
+  EXPECT(mask.is_solid(1, 1));
+  EXPECT(!mask.is_solid(0, 0));
+
+  mask.resize(3, 2, 0, 0, 1);
+  EXPECT(mask.is_solid(2, 0));
+}
+
+TEST(UNIT__SolidMask__versions)
+{
+  Tilemap tilemap(1);
+  tilemap.resize(130, 70, 0, 0, 0);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+  uint32_t generation = mask.get_generation();
+
+  mask.set(65, 1, 1);
+  EXPECT_EQ(mask.get_chunk_version(1, 0), 1u);
+  EXPECT_EQ(mask.get_chunk_version(0, 0), 0u);
+
+  // Spans count once per chunk they touch
+  mask.fill(60, 66, 10, 1);
+  EXPECT_EQ(mask.get_chunk_version(0, 1), 1u);
+  EXPECT_EQ(mask.get_chunk_version(1, 1), 1u);
+  EXPECT_EQ(mask.get_chunk_version(3, 0), 0u);
+  EXPECT_EQ(mask.get_generation(), generation);
+
+  mask.resize(10, 10, 0, 0, 0);
+  EXPECT(mask.get_generation() != generation);
+}
+
+TEST(BENCH__SolidMask__overlaps)
+{
+  // 4 million tiles of sky, with 16 tiles wide platforms scattered in it
+  Tilemap tilemap(1);
+  tilemap.resize(2000, 2000, 0, 0, 0);
+
+  for (size_t y = 16; y < 2000; y += 32)
+    for (size_t x = (y / 32 % 2) * 32; x < 2000; x += 64)
+      for (size_t i = 0; i < 16 && x + i < 2000; i++)
+        tilemap.set(x + i, y, 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+
+  size_t hits = 0;
+
+  // Boxes as wide as half a screen, sliding over the whole level
+  auto start = std::chrono::steady_clock::now();
+  for (long y = 0; y < 2000; y += 4)
+    for (long x = 0; x < 2000; x += 4)
+      hits += mask.overlaps(x, y, x + 30, y + 3) ? 1 : 0;
+  auto end = std::chrono::steady_clock::now();
+
+  // Only boxes on the rows of the platforms can hit them
+  size_t expected = 0;
+  for (long y = 16; y < 2000; y += 32)
+    for (long x = 0; x < 2000; x += 4)
+      for (long i = x; i <= x + 30 && i < 2000; i++)
+        if (tilemap.get(static_cast<size_t>(i), static_cast<size_t>(y)) == 1)
+        {
+          expected++;
+          break;
+        }
+
+  EXPECT_EQ(hits, expected);
+
+#ifdef NDEBUG
+  EXPECT(end - start < std::chrono::milliseconds(8));
+#else
+  (void) (end - start);
+#endif
+}
@@ -0,0 +1,120 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/tile_clipboard.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+static size_t g_row_tiles;
+
+TEST(UNIT__TileClipboard__copy)
+{
+  Tilemap tilemap(3);
+  tilemap.resize(4, 3, 0, 0, 0);
+  tilemap.set(0, 0, 1);
+  tilemap.set(1, 1, 2);
+  tilemap.set(3, 2, 3);
+
+  TileClipboard clipboard;
+  EXPECT(clipboard.empty());
+
+  clipboard.copy(tilemap, 1, 1, 3, 2, 0);
+  EXPECT_EQ(clipboard.get_width(), 3u);
+  EXPECT_EQ(clipboard.get_height(), 2u);
+  EXPECT_EQ(clipboard.get(0, 0), 2u);
+  EXPECT_EQ(clipboard.get(2, 1), 3u);
+  EXPECT_EQ(clipboard.get(1, 1), 0u);
+
+  // Tiles outside of the tilemap are filled, keeping the shape of the region
+  clipboard.copy(tilemap, -1, -1, 3, 3, 7);
+  EXPECT_EQ(clipboard.get(0, 0), 7u);
+  EXPECT_EQ(clipboard.get(2, 0), 7u);
+  EXPECT_EQ(clipboard.get(0, 2), 7u);
+  EXPECT_EQ(clipboard.get(1, 1), 1u);
+  EXPECT_EQ(clipboard.get(2, 2), 2u);
+
+  clipboard.copy(tilemap, 10, 10, 2, 2, 5);
+  EXPECT_EQ(clipboard.get(1, 1), 5u);
+
+  clipboard.clear();
+  EXPECT(clipboard.empty());
+}
+
+TEST(UNIT__TileClipboard__paste)
+{
+  Tilemap source(1000);
+  source.resize(2, 2, 0, 0, 0);
+  source.set(0, 0, 1);
+  source.set(1, 1, 1000);
+
+  TileClipboard clipboard;
+  clipboard.copy(source, 0, 0, 2, 2, 0);
+
+  // Pasting widens the tilemap if needed, and is clipped to it
+  Tilemap tilemap(3);
+  tilemap.resize(3, 3, 0, 0, 2);
+  EXPECT(tilemap.get_id_width() == Tilemap::IdWidth::BITS_8);
+
+  g_row_tiles = 0;
+  clipboard.paste(tilemap, 2, 1, [] (size_t x, size_t y, const auto* old_ids,
+                                     const auto* new_ids, size_t length) {
+    EXPECT_EQ(x, 2u);
+    EXPECT_EQ(old_ids[0], 2u);
+    EXPECT_EQ(new_ids[0], y == 1 ? 1u : 0u);
+    g_row_tiles += length;
+  });
+
+  EXPECT_EQ(g_row_tiles, 2u);
+  EXPECT(tilemap.get_id_width() == Tilemap::IdWidth::BITS_16);
+  EXPECT_EQ(tilemap.get(2, 1), 1u);
+  EXPECT_EQ(tilemap.get(2, 2), 0u);
+  EXPECT_EQ(tilemap.get(1, 1), 2u);
+}
+
+TEST(BENCH__TileClipboard__copy_paste)
+{
+  Tilemap tilemap(3);
+  tilemap.resize(2000, 2000, 0, 0, 0);
+
+  for (size_t y = 0; y < 2000; y += 7)
+    tilemap.fill(0, y, 2000, 1 + y % 3);
+
+  // Duplicate a 1000x500 region (half a million tiles) next to itself
+  TileClipboard clipboard;
+  g_row_tiles = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  clipboard.copy(tilemap, 0, 0, 1000, 500, 0);
+  clipboard.paste(tilemap, 1000, 1000, [] (size_t, size_t, const auto*,
+                                           const auto*, size_t length) {
+    g_row_tiles += length;
+  });
+  auto end = std::chrono::steady_clock::now();
+
+  EXPECT_EQ(g_row_tiles, 1000u * 500u);
+  EXPECT_EQ(tilemap.get(1999, 1497), tilemap.get(999, 497));
+  EXPECT_EQ(tilemap.get(1500, 1007), 1 + 7 % 3);
+
+#ifdef NDEBUG
+  // Well under the budget of a frame at 60 FPS
+  EXPECT(end - start < std::chrono::milliseconds(8));
+#else
+  (void) (end - start);
+#endif
+}
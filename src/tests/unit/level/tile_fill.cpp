@@ -0,0 +1,115 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/tile_fill.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+static size_t g_span_tiles;
+
+static void
+count_span(size_t, size_t, const uint8_t*, size_t length)
+{
+  g_span_tiles += length;
+}
+
+TEST(UNIT__TileFill__rect)
+{
+  TileGrid<uint8_t> grid(5, 4, 0);
+  grid.set(2, 1, 3);
+  g_span_tiles = 0;
+
+  // Clamped to the grid
+  EXPECT_EQ(TileFill::rect(grid, 1, 1, 9, 2, 1, count_span), 8u);
+  EXPECT_EQ(g_span_tiles, 8u);
+  EXPECT_EQ(grid.get(0, 1), 0);
+  EXPECT_EQ(grid.get(2, 1), 1);
+  EXPECT_EQ(grid.get(4, 2), 1);
+  EXPECT_EQ(grid.get(1, 3), 0);
+
+  EXPECT_EQ(TileFill::rect(grid, 5, 0, 9, 9, 1, count_span), 0u);
+}
+
+TEST(UNIT__TileFill__flood)
+{
+  // A ring of walls with a gap, around a closed room
+  //   01234
+  // 0 .....
+  // 1 .###.
+  // 2 .#.#.
+  // 3 .###.
+  // 4 ..#..
+  TileGrid<uint8_t> grid(5, 5, 0);
+  for (size_t i = 1; i <= 3; i++)
+  {
+    grid.set(i, 1, 1);
+    grid.set(i, 3, 1);
+    grid.set(1, i, 1);
+    grid.set(3, i, 1);
+  }
+  grid.set(2, 4, 1);
+  g_span_tiles = 0;
+
+  EXPECT_EQ(TileFill::flood(grid, 0, 4, 2, count_span), 15u);
+  EXPECT_EQ(g_span_tiles, 15u);
+  EXPECT_EQ(grid.get(4, 4), 2);
+  EXPECT_EQ(grid.get(4, 0), 2);
+  EXPECT_EQ(grid.get(2, 2), 0);
+  EXPECT_EQ(grid.get(2, 4), 1);
+
+  // Filling with the same ID does nothing
+  EXPECT_EQ(TileFill::flood(grid, 0, 0, 2, count_span), 0u);
+  EXPECT_EQ(TileFill::flood(grid, 9, 0, 1, count_span), 0u);
+}
+
+TEST(BENCH__TileFill__flood)
+{
+  // 4 million tiles of sky, with 16 tiles wide platforms scattered in it
+  TileGrid<uint8_t> grid(2000, 2000, 0);
+  size_t platforms = 0;
+
+  for (size_t y = 16; y < 2000; y += 32)
+  {
+    for (size_t x = (y / 32 % 2) * 32; x < 2000; x += 64)
+    {
+      for (size_t i = 0; i < 16 && x + i < 2000; i++)
+      {
+        grid.set(x + i, y, 1);
+        platforms++;
+      }
+    }
+  }
+
+  g_span_tiles = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  size_t filled = TileFill::flood(grid, 0, 0, 2, count_span);
+  auto end = std::chrono::steady_clock::now();
+
+  EXPECT_EQ(filled, g_span_tiles);
+  EXPECT_EQ(filled, 2000u * 2000u - platforms);
+  EXPECT_EQ(grid.get(1999, 1999), 2);
+
+#ifdef NDEBUG
+  // Well under the budget of a frame at 60 FPS
+  EXPECT(end - start < std::chrono::milliseconds(8));
+#else
+  (void) (end - start);
+#endif
+}
@@ -0,0 +1,190 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/tile_grid.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+TEST(UNIT__TileGrid__get_set)
+{
+  TileGrid<uint8_t> grid(4, 3, 1);
+
+  EXPECT_EQ(grid.get_width(), 4);
+  EXPECT_EQ(grid.get_height(), 3);
+  EXPECT(!grid.empty());
+  EXPECT_EQ(grid.get(3, 2), 1);
+
+  grid.set(3, 2, 7);
+  grid.set(0, 1, 255);
+
+  EXPECT_EQ(grid.get(3, 2), 7);
+  EXPECT_EQ(grid.get(0, 1), 255);
+  EXPECT_EQ(grid.get_row(1)[0], 255);
+  EXPECT_EQ(grid.get_row(2)[3], 7);
+
+  EXPECT_THROW(grid.get(4, 0));
+  EXPECT_THROW(grid.set(0, 3, 0));
+
+  EXPECT(TileGrid<uint8_t>().empty());
+  EXPECT(TileGrid<uint8_t>(0, 5, 0).empty());
+}
+
+TEST(UNIT__TileGrid__resize)
+{
+  TileGrid<uint16_t> grid(3, 2, 0);
+  grid.set(0, 0, 1);
+  grid.set(2, 1, 2);
+
+  // Grow on every side
+  grid.resize(5, 4, 1, 1, 9);
+
+  EXPECT_EQ(grid.get_width(), 5);
+  EXPECT_EQ(grid.get_height(), 4);
+  EXPECT_EQ(grid.get(0, 0), 9);
+  EXPECT_EQ(grid.get(4, 3), 9);
+  EXPECT_EQ(grid.get(1, 1), 1);
+  EXPECT_EQ(grid.get(3, 2), 2);
+  EXPECT_EQ(grid.get(2, 1), 0);
+
+  // Crop back to the original area
+  grid.resize(3, 2, -1, -1, 9);
+
+  EXPECT_EQ(grid.get_width(), 3);
+  EXPECT_EQ(grid.get_height(), 2);
+  EXPECT_EQ(grid.get(0, 0), 1);
+  EXPECT_EQ(grid.get(2, 1), 2);
+  EXPECT_EQ(grid.get(1, 0), 0);
+
+  // Move everything out of the grid
+  grid.resize(3, 2, 5, 0, 4);
+
+  EXPECT_EQ(grid.get(0, 0), 4);
+  EXPECT_EQ(grid.get(2, 1), 4);
+}
+
+TEST(UNIT__TileGrid__assign)
+{
+  TileGrid<uint8_t> small(2, 2, 3);
+  small.set(1, 0, 200);
+
+  TileGrid<uint32_t> big;
+  big.assign(small);
+
+  EXPECT_EQ(big.get_width(), 2);
+  EXPECT_EQ(big.get_height(), 2);
+  EXPECT_EQ(big.get(1, 0), 200);
+  EXPECT_EQ(big.get(0, 1), 3);
+
+  EXPECT_EQ(TileGrid<uint8_t>::max_id(), 255);
+  EXPECT_EQ(TileGrid<uint16_t>::max_id(), 65535);
+}
+
+TEST(UNIT__TileGrid__copy_on_write)
+{
+  size_t height = TileGrid<uint8_t>::BAND_ROWS * 2 + 1;
+  TileGrid<uint8_t> grid(3, height, 0);
+  grid.set(1, height - 1, 5);
+
+  const TileGrid<uint8_t> snapshot = grid;
+  const uint8_t* shared_row = snapshot.get_row(0);
+
+  EXPECT_EQ(static_cast<const TileGrid<uint8_t>&>(grid).get_row(0),
+            shared_row);
+
+  grid.set(2, 0, 7);
+  grid.set(1, height - 1, 6);
+
+  // The snapshot keeps the old tiles, and its rows didn't move
+  EXPECT_EQ(snapshot.get(2, 0), 0);
+  EXPECT_EQ(snapshot.get(1, height - 1), 5);
+  EXPECT_EQ(snapshot.get_row(0), shared_row);
+  EXPECT_EQ(grid.get(2, 0), 7);
+  EXPECT_EQ(grid.get(1, height - 1), 6);
+
+  // Bands that were shared are copied on write even once the other copy is
+  // gone, as it may have been read from another thread
+  TileGrid<uint8_t> other(3, height, 0);
+  const uint8_t* row = static_cast<const TileGrid<uint8_t>&>(other).get_row(0);
+  TileGrid<uint8_t>(other).set(0, 0, 1);
+
+  other.set(0, 0, 2);
+  const uint8_t* copied =
+    static_cast<const TileGrid<uint8_t>&>(other).get_row(0);
+  EXPECT_NEQ(copied, row);
+
+  // The copy isn't shared, so it is written in place
+  other.set(1, 0, 3);
+  EXPECT_EQ(static_cast<const TileGrid<uint8_t>&>(other).get_row(0), copied);
+  EXPECT_EQ(other.get(0, 0), 2);
+  EXPECT_EQ(other.get(1, 0), 3);
+}
+
+TEST(UNIT__TileGrid__hash)
+{
+  TileGrid<uint8_t> a(10, 200, 0);
+  TileGrid<uint16_t> b(10, 200, 0);
+  TileGrid<uint8_t> c(10, 200, 0);
+
+  // The hash doesn't depend on the type of the IDs
+  uint64_t empty = a.get_hash(0, 200);
+  EXPECT_EQ(b.get_hash(0, 200), empty);
+  EXPECT(TileGrid<uint8_t>(11, 200, 0).get_hash(0, 200) != empty);
+
+  // Updated in place by set() and fill(), or after writes through get_row()
+  a.set(3, 100, 5);
+  a.fill(0, 150, 10, 2);
+  b.set(3, 100, 5);
+  b.fill(0, 150, 10, 2);
+  c.get_row(100)[3] = 5;
+  std::fill(c.get_row(150), c.get_row(150) + 10, 2);
+
+  EXPECT(a.get_hash(0, 200) != empty);
+  EXPECT_EQ(b.get_hash(0, 200), a.get_hash(0, 200));
+  EXPECT_EQ(c.get_hash(0, 200), a.get_hash(0, 200));
+
+  // Bands that didn't change keep their hash
+  EXPECT_EQ(a.get_hash(0, 64), TileGrid<uint8_t>(10, 200, 0).get_hash(0, 64));
+  EXPECT(a.get_hash(64, 128) != empty);
+
+  // Same tiles, same hash
+  a.set(3, 100, 0);
+  a.fill(0, 150, 10, 0);
+  EXPECT_EQ(a.get_hash(0, 200), empty);
+
+  // Copies keep the hashes, and don't share later changes
+  TileGrid<uint8_t> copy = a;
+  copy.set(0, 0, 1);
+  EXPECT_EQ(a.get_hash(0, 200), empty);
+  EXPECT(copy.get_hash(0, 200) != empty);
+
+  // Copies sharing bands whose hash isn't known yet can be hashed on other
+  // threads while the original is hashed and changed
+  c.get_row(0)[0] = 1;
+  const TileGrid<uint8_t> snapshot = c;
+  uint64_t snapshot_hash = 0;
+  std::thread thread([&] { snapshot_hash = snapshot.get_hash(0, 200); });
+  uint64_t hash = c.get_hash(0, 200);
+  c.set(0, 0, 2);
+  thread.join();
+
+  EXPECT_EQ(snapshot_hash, hash);
+  EXPECT_EQ(snapshot.get_hash(0, 200), hash);
+  EXPECT(c.get_hash(0, 200) != hash);
+}
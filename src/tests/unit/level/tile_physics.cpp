@@ -0,0 +1,215 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/tile_physics.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+#include "level/tilemap.hpp"
+#include "util/size.hpp"
+
+static const std::vector<bool> g_solid = { false, true };
+
+/** A 10x10 level with a floor on the last row and a wall on column 6. */
+static SolidMask
+make_room()
+{
+  Tilemap tilemap(1);
+  tilemap.resize(10, 10, 0, 0, 0);
+  tilemap.fill(0, 9, 10, 1);
+
+  for (size_t y = 0; y < 9; y++)
+    tilemap.set(6, y, 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+  return mask;
+}
+
+TEST(UNIT__TilePhysics__move)
+{
+  SolidMask mask = make_room();
+  TilePhysics physics(mask, 32.0f);
+
+  // Stops against the wall, then against the floor
+  Rect box(32.0f, 32.0f, 48.0f, 64.0f);
+  Vector moved = physics.move(box, Vector(1000.0f, 1000.0f));
+  EXPECT_EQ(moved, Vector(144.0f, 224.0f));
+  EXPECT_EQ(box, Rect(176.0f, 256.0f, 192.0f, 288.0f));
+
+  // Touching a tile doesn't block moving along it
+  moved = physics.move(box, Vector(-100.0f, 0.0f));
+  EXPECT_EQ(moved, Vector(-100.0f, 0.0f));
+
+  // Nothing blocks upwards, not even the edge of the level
+  moved = physics.move(box, Vector(-1000.0f, -1000.0f));
+  EXPECT_EQ(moved, Vector(-1000.0f, -1000.0f));
+}
+
+TEST(UNIT__TilePhysics__step)
+{
+  SolidMask mask = make_room();
+  TilePhysics physics(mask, 32.0f);
+
+  std::vector<TilePhysics::Body> bodies;
+  bodies.emplace_back(Rect(0.0f, 0.0f, 32.0f, 32.0f));
+  bodies.emplace_back(Rect(224.0f, 0.0f, 256.0f, 32.0f));
+  bodies[1].velocity = Vector(-500.0f, 0.0f);
+
+  for (int i = 0; i < 100; i++)
+    physics.step(bodies, 0.01f);
+
+  // Both bodies rest on the floor, the second one against the wall
+  EXPECT(bodies[0].on_ground);
+  EXPECT_EQ(bodies[0].box.y2, 288.0f);
+  EXPECT_EQ(bodies[0].velocity, Vector(0.0f, 0.0f));
+  EXPECT(bodies[1].on_ground);
+  EXPECT_EQ(bodies[1].box.x1, 224.0f);
+
+  // Jumping leaves the ground
+  bodies[0].velocity.y = -300.0f;
+  physics.step(bodies, 0.01f);
+  EXPECT(!bodies[0].on_ground);
+  EXPECT(bodies[0].box.y2 < 288.0f);
+
+  // Drawing goes from the previous position to the current one
+  EXPECT_EQ(bodies[0].last_box.y2, 288.0f);
+  EXPECT_EQ(bodies[0].get_drawn_box(0.0f), bodies[0].last_box);
+  EXPECT_EQ(bodies[0].get_drawn_box(1.0f), bodies[0].box);
+}
+
+TEST(UNIT__TilePhysics__step__thin_wall)
+{
+  // A floor, and a wall one tile thick on column 1
+  Tilemap tilemap(1);
+  tilemap.resize(20, 10, 0, 0, 0);
+  tilemap.fill(0, 9, 20, 1);
+  tilemap.set(1, 8, 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+
+  // Tile sizes which are and aren't powers of two
+  for (float tile : { 32.0f, 21.3f, 13.7f, 0.3f })
+  {
+    TilePhysics physics(mask, tile);
+    float wall = 2.0f * tile;
+    float floor = 9.0f * tile;
+
+    // Positions which don't fall on whole pixels, slightly above the floor
+    std::vector<TilePhysics::Body> bodies;
+    for (int i = 0; i < 100; i++)
+    {
+      float x = tile * (4.0f + static_cast<float>(i) * 0.043f);
+      float y = floor - tile * static_cast<float>(i) * 0.0004f;
+      bodies.emplace_back(Rect(x, y - tile * 0.93f, x + tile * 0.77f, y));
+    }
+
+    for (int frame = 0; frame < 10; frame++)
+    {
+      // Fast enough to hit the wall from afar on the first frame
+      for (auto& body : bodies)
+        body.velocity.x = -tile * 600.0f;
+
+      physics.step(bodies, 1.0f / 60.0f);
+
+      // Pushed against the wall every frame, but never into it
+      for (const auto& body : bodies)
+        EXPECT_EQ(body.box.x1, wall);
+    }
+
+    for (const auto& body : bodies)
+    {
+      EXPECT_EQ(body.box.y2, floor);
+      EXPECT(body.on_ground);
+    }
+
+    // Walking on the floor isn't blocked by the floor itself
+    for (int frame = 0; frame < 10; frame++)
+    {
+      for (auto& body : bodies)
+        body.velocity.x = tile * 2.3f;
+
+      physics.step(bodies, 1.0f / 60.0f);
+    }
+
+    for (const auto& body : bodies)
+    {
+      EXPECT(body.box.x1 > wall + tile * 0.3f);
+      EXPECT(body.on_ground);
+    }
+  }
+}
+
+TEST(BENCH__TilePhysics__step)
+{
+  // 4 million tiles of sky, with 16 tiles wide platforms scattered in it
+  Tilemap tilemap(1);
+  tilemap.resize(2000, 2000, 0, 0, 0);
+
+  for (size_t y = 16; y < 2000; y += 32)
+    for (size_t x = (y / 32 % 2) * 32; x < 2000; x += 64)
+      tilemap.fill(x, y, std::min<size_t>(16, 2000 - x), 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+  TilePhysics physics(mask, 32.0f);
+
+  // Two bodies walking on each of the ~2000 platforms, starting on their row
+  std::vector<TilePhysics::Body> bodies;
+  for (size_t y = 16; y < 2000; y += 32)
+  {
+    for (size_t x = (y / 32 % 2) * 32; x + 16 <= 2000; x += 64)
+    {
+      for (size_t i : { x + 4, x + 10 })
+      {
+        Vector pos(static_cast<float>(i) * 32.0f,
+                   static_cast<float>(y) * 32.0f - 30.0f);
+        bodies.emplace_back(Rect(pos, Size(24.0f, 30.0f)));
+        bodies.back().velocity.x = (i == x + 4) ? -80.0f : 80.0f;
+      }
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 60; i++)
+    physics.step(bodies, 1.0f / 60.0f);
+  auto end = std::chrono::steady_clock::now();
+
+  size_t grounded = 0;
+  for (const auto& body : bodies)
+  {
+    EXPECT(!mask.overlaps(static_cast<long>(body.box.x1 / 32.0f),
+                          static_cast<long>(body.box.y1 / 32.0f),
+                          static_cast<long>((body.box.x2 - 1.0f) / 32.0f),
+                          static_cast<long>((body.box.y2 - 1.0f) / 32.0f)));
+    grounded += body.on_ground ? 1 : 0;
+  }
+
+  // No body walked off its platform
+  EXPECT(bodies.size() > 1000);
+  EXPECT_EQ(grounded, bodies.size());
+
+#ifdef NDEBUG
+  // Each tick takes well under the budget of a frame at 60 FPS
+  EXPECT(end - start < std::chrono::milliseconds(60));
+#else
+  (void) (end - start);
+#endif
+}
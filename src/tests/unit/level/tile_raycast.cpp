@@ -0,0 +1,170 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/tile_raycast.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+#include "level/tilemap.hpp"
+
+static const std::vector<bool> g_solid = { false, true };
+
+/** A 10x10 level with a wall on column 6 and a floor on the last row. */
+static SolidMask
+make_room()
+{
+  Tilemap tilemap(1);
+  tilemap.resize(10, 10, 0, 0, 0);
+  tilemap.fill(0, 9, 10, 1);
+
+  for (size_t y = 0; y < 9; y++)
+    tilemap.set(6, y, 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+  return mask;
+}
+
+TEST(UNIT__TileRaycast__cast)
+{
+  SolidMask mask = make_room();
+
+  auto hit = TileRaycast::cast(mask, Vector(1.5f, 2.5f), Vector(2.0f, 0.0f),
+                               100.0f);
+  EXPECT(hit.hit);
+  EXPECT_EQ(hit.x, 6);
+  EXPECT_EQ(hit.y, 2);
+  EXPECT_EQ(hit.distance, 4.5f);
+  EXPECT(hit.face == TileRaycast::Face::LEFT);
+
+  hit = TileRaycast::cast(mask, Vector(1.5f, 2.5f), Vector(0.0f, 1.0f),
+                          100.0f);
+  EXPECT(hit.hit);
+  EXPECT_EQ(hit.y, 9);
+  EXPECT_EQ(hit.distance, 6.5f);
+  EXPECT(hit.face == TileRaycast::Face::TOP);
+
+  hit = TileRaycast::cast(mask, Vector(8.5f, 2.5f), Vector(-1.0f, 0.0f),
+                          100.0f);
+  EXPECT(hit.face == TileRaycast::Face::RIGHT);
+
+  // Too short, going away from the tiles or starting inside of one
+  EXPECT(!TileRaycast::cast(mask, Vector(1.5f, 2.5f), Vector(1.0f, 0.0f),
+                            4.0f).hit);
+  EXPECT(!TileRaycast::cast(mask, Vector(1.5f, 2.5f), Vector(-1.0f, -1.0f),
+                            1000.0f).hit);
+  hit = TileRaycast::cast(mask, Vector(6.5f, 2.5f), Vector(1.0f, 0.0f),
+                          1.0f);
+  EXPECT(hit.hit);
+  EXPECT_EQ(hit.distance, 0.0f);
+  EXPECT(hit.face == TileRaycast::Face::NONE);
+
+  // From outside of the level
+  hit = TileRaycast::cast(mask, Vector(-10.5f, 3.5f), Vector(1.0f, 0.0f),
+                          100.0f);
+  EXPECT(hit.hit);
+  EXPECT_EQ(hit.x, 6);
+}
+
+TEST(UNIT__TileRaycast__walk)
+{
+  std::vector<std::pair<long, long>> tiles;
+
+  TileRaycast::walk(Vector(0.5f, 0.5f), Vector(3.5f, 1.5f),
+                    [&tiles] (long x, long y) {
+    tiles.emplace_back(x, y);
+  });
+
+  // Each tile touches the previous one by a side
+  EXPECT_EQ(tiles.size(), 5u);
+  EXPECT(tiles.front() == std::make_pair(0L, 0L));
+  EXPECT(tiles.back() == std::make_pair(3L, 1L));
+
+  for (size_t i = 1; i < tiles.size(); i++)
+    EXPECT_EQ(std::abs(tiles[i].first - tiles[i - 1].first)
+              + std::abs(tiles[i].second - tiles[i - 1].second), 1);
+
+  tiles.clear();
+  TileRaycast::walk(Vector(2.5f, 2.5f), Vector(2.5f, 2.5f),
+                    [&tiles] (long x, long y) {
+    tiles.emplace_back(x, y);
+  });
+  EXPECT_EQ(tiles.size(), 1u);
+}
+
+TEST(UNIT__TileRaycast__line_of_sight)
+{
+  SolidMask mask = make_room();
+
+  EXPECT(TileRaycast::line_of_sight(mask, Vector(0.5f, 0.5f),
+                                    Vector(5.5f, 8.5f)));
+  EXPECT(!TileRaycast::line_of_sight(mask, Vector(0.5f, 0.5f),
+                                     Vector(7.5f, 0.5f)));
+
+  std::vector<TileRaycast::Segment> segments;
+  for (int i = 0; i < 1000; i++)
+    segments.emplace_back(Vector(0.5f, 0.5f),
+                          Vector(static_cast<float>(i % 10) + 0.5f, 0.5f));
+
+  auto results = TileRaycast::line_of_sight(mask, segments, 4);
+  EXPECT_EQ(results.size(), 1000u);
+
+  for (int i = 0; i < 1000; i++)
+    EXPECT_EQ(results[i], (i % 10 < 6) ? 1 : 0);
+}
+
+TEST(BENCH__TileRaycast__line_of_sight)
+{
+  // 4 million tiles of sky, with 16 tiles wide platforms scattered in it
+  Tilemap tilemap(1);
+  tilemap.resize(2000, 2000, 0, 0, 0);
+
+  for (size_t y = 16; y < 2000; y += 32)
+    for (size_t x = (y / 32 % 2) * 32; x < 2000; x += 64)
+      tilemap.fill(x, y, std::min<size_t>(16, 2000 - x), 1);
+
+  SolidMask mask(g_solid);
+  mask.build(tilemap);
+
+  // 10000 enemies each looking for the player, a screen away at most
+  std::vector<TileRaycast::Segment> segments;
+  for (size_t i = 0; i < 10000; i++)
+  {
+    Vector from(static_cast<float>(i * 7 % 1960) + 20.5f,
+                static_cast<float>(i * 13 % 1960) + 20.5f);
+    Vector to = from + Vector(static_cast<float>(i % 41) - 20.0f,
+                              static_cast<float>(i % 23) - 11.0f);
+    segments.emplace_back(from, to);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto results = TileRaycast::line_of_sight(mask, segments, 4);
+  auto end = std::chrono::steady_clock::now();
+
+  // Same results as without threads
+  auto expected = TileRaycast::line_of_sight(mask, segments, 1);
+  EXPECT(results == expected);
+
+#ifdef NDEBUG
+  // Well under the budget of a frame at 60 FPS, even on a single core
+  EXPECT(end - start < std::chrono::milliseconds(8));
+#else
+  (void) (end - start);
+#endif
+}
@@ -0,0 +1,142 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "level/tilemap.hpp"
+
+TEST(UNIT__Tilemap__id_width)
+{
+  EXPECT(Tilemap::get_id_width_for(0) == Tilemap::IdWidth::BITS_8);
+  EXPECT(Tilemap::get_id_width_for(255) == Tilemap::IdWidth::BITS_8);
+  EXPECT(Tilemap::get_id_width_for(256) == Tilemap::IdWidth::BITS_16);
+  EXPECT(Tilemap::get_id_width_for(65535) == Tilemap::IdWidth::BITS_16);
+  EXPECT(Tilemap::get_id_width_for(65536) == Tilemap::IdWidth::BITS_32);
+
+  EXPECT(Tilemap().get_id_width() == Tilemap::IdWidth::BITS_8);
+  EXPECT(Tilemap(3).get_id_width() == Tilemap::IdWidth::BITS_8);
+  EXPECT(Tilemap(1000).get_id_width() == Tilemap::IdWidth::BITS_16);
+}
+
+TEST(UNIT__Tilemap__widening)
+{
+  Tilemap tilemap(2);
+  tilemap.resize(4, 4, 0, 0, 0);
+  tilemap.set(1, 1, 2);
+
+  EXPECT(tilemap.get_id_width() == Tilemap::IdWidth::BITS_8);
+
+  tilemap.set(2, 2, 300);
+
+  EXPECT(tilemap.get_id_width() == Tilemap::IdWidth::BITS_16);
+  EXPECT_EQ(tilemap.get(1, 1), 2);
+  EXPECT_EQ(tilemap.get(2, 2), 300);
+
+  tilemap.set(3, 3, 0xffffff);
+
+  EXPECT(tilemap.get_id_width() == Tilemap::IdWidth::BITS_32);
+  EXPECT_EQ(tilemap.get(1, 1), 2);
+  EXPECT_EQ(tilemap.get(2, 2), 300);
+  EXPECT_EQ(tilemap.get(3, 3), 0xffffff);
+  EXPECT_EQ(tilemap.get_width(), 4);
+  EXPECT_EQ(tilemap.get_height(), 4);
+
+  // Never narrows back
+  tilemap.set(3, 3, 0);
+  EXPECT(tilemap.get_id_width() == Tilemap::IdWidth::BITS_32);
+
+  // Out of bounds writes must not widen
+  Tilemap other(2);
+  other.resize(1, 1, 0, 0, 0);
+  EXPECT_THROW(other.set(1, 0, 70000));
+  EXPECT(other.get_id_width() == Tilemap::IdWidth::BITS_8);
+}
+
+TEST(UNIT__Tilemap__visit)
+{
+  Tilemap tilemap(2);
+  tilemap.resize(3, 2, 0, 0, 1);
+
+  size_t count = 0;
+  tilemap.visit([&count] (const auto& grid) {
+    for (size_t y = 0; y < grid.get_height(); y++)
+      for (size_t x = 0; x < grid.get_width(); x++)
+        count += grid.get_row(y)[x];
+  });
+
+  EXPECT_EQ(count, 6);
+
+  tilemap.resize(4, 2, 1, 0, 70000);
+
+  EXPECT(tilemap.get_id_width() == Tilemap::IdWidth::BITS_32);
+  EXPECT_EQ(tilemap.get(0, 0), 70000);
+  EXPECT_EQ(tilemap.get(1, 0), 1);
+
+  tilemap.clear();
+
+  EXPECT(tilemap.empty());
+  EXPECT_EQ(tilemap.get_width(), 0);
+}
+
+TEST(UNIT__Tilemap__hash)
+{
+  Tilemap a(2);
+  a.resize(8, 8, 0, 0, 1);
+  Tilemap b(70000);
+  b.resize(8, 8, 0, 0, 1);
+
+  EXPECT_EQ(a.get_hash(), b.get_hash());
+
+  // Widening keeps the hash
+  uint64_t hash = a.get_hash();
+  a.reserve_id(70000);
+  EXPECT_EQ(a.get_hash(), hash);
+
+  a.set(7, 7, 2);
+  EXPECT(a.get_hash() != b.get_hash());
+  b.set(7, 7, 2);
+  EXPECT_EQ(a.get_hash(), b.get_hash());
+
+  b.resize(8, 9, 0, 0, 1);
+  EXPECT(a.get_hash() != b.get_hash());
+}
+
+TEST(UNIT__Tilemap__revision)
+{
+  Tilemap a(1);
+  Tilemap b(1);
+  EXPECT_NEQ(a.get_revision(), b.get_revision());
+
+  // Copies keep the revision until either of them changes
+  a.resize(10, 10, 0, 0, 0);
+  Tilemap copy = a;
+  EXPECT_EQ(copy.get_revision(), a.get_revision());
+
+  uint64_t revision = a.get_revision();
+  a.set(0, 0, 1);
+  EXPECT_NEQ(a.get_revision(), revision);
+  EXPECT_EQ(copy.get_revision(), revision);
+
+  // Writing through visit() changes the revision, reading doesn't
+  revision = copy.get_revision();
+  static_cast<const Tilemap&>(copy).visit([] (const auto&) {});
+  EXPECT_EQ(copy.get_revision(), revision);
+  copy.visit([] (auto& grid) { grid.get_row(0)[0] = 1; });
+  EXPECT_NEQ(copy.get_revision(), revision);
+
+  // Even if both hold the same tiles, they don't share a revision anymore
+  EXPECT_NEQ(copy.get_revision(), a.get_revision());
+}
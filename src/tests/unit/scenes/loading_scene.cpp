@@ -0,0 +1,129 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "scenes/loading_scene.hpp"
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "game/scene_manager.hpp"
+#include "tests/mock/scenes/mock_scene.hpp"
+
+/** Updates @p sm until the scene on top isn't a LoadingScene anymore. */
+static void
+wait_loaded(SceneManager& sm)
+{
+  for (int i = 0; i < 1000 && !sm.empty(); i++)
+  {
+    if (!dynamic_cast<LoadingScene*>(sm.get_scene_stack().back().get()))
+      return;
+
+    sm.update(0.01f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+TEST(UNIT__LoadingScene__push_scene_async)
+{
+  SceneManager sm(nullptr);
+  auto& controller = sm.get_controller();
+
+  auto scene = std::make_unique<MockScene>(controller);
+  auto& s = *scene;
+  sm.push_scene(std::move(scene));
+
+  MockScene* loaded = nullptr;
+  auto main_thread = std::this_thread::get_id();
+  std::thread::id factory_thread;
+
+  controller.push_scene_async([&] {
+    factory_thread = std::this_thread::get_id();
+    auto next = std::make_unique<MockScene>(controller);
+    loaded = next.get();
+    return next;
+  });
+
+  // The loading screen is shown above the current scene meanwhile
+  EXPECT_EQ(sm.get_scene_stack().size(), 2u);
+  EXPECT(!sm.get_scene_stack().back()->is_opaque());
+
+  wait_loaded(sm);
+
+  EXPECT_EQ(sm.get_scene_stack().size(), 2u);
+  EXPECT_EQ(sm.get_scene_stack().front().get(), &s);
+  EXPECT_EQ(sm.get_scene_stack().back().get(), loaded);
+#ifndef EMSCRIPTEN
+  EXPECT(factory_thread != main_thread);
+#endif
+}
+
+TEST(UNIT__LoadingScene__push_scene_async__error)
+{
+  SceneManager sm(nullptr);
+  auto& controller = sm.get_controller();
+
+  auto scene = std::make_unique<MockScene>(controller);
+  auto& s = *scene;
+  sm.push_scene(std::move(scene));
+
+  controller.push_scene_async([] () -> std::unique_ptr<Scene> {
+    throw std::runtime_error("UNIT__LoadingScene__push_scene_async__error");
+  });
+
+  wait_loaded(sm);
+
+  // Back to the scene the loading screen was above
+  EXPECT_EQ(sm.get_scene_stack().size(), 1u);
+  EXPECT_EQ(sm.get_scene_stack().back().get(), &s);
+
+  // Whatever was thrown
+  controller.push_scene_async([] () -> std::unique_ptr<Scene> { throw 42; });
+
+  wait_loaded(sm);
+
+  EXPECT_EQ(sm.get_scene_stack().size(), 1u);
+  EXPECT_EQ(sm.get_scene_stack().back().get(), &s);
+}
+
+TEST(UNIT__LoadingScene__quit)
+{
+  bool made = false;
+
+  {
+    SceneManager sm(nullptr);
+    auto& controller = sm.get_controller();
+
+    controller.push_scene_async([&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      made = true;
+      return std::make_unique<MockScene>(controller);
+    });
+
+    SDL_Event event;
+    event.type = SDL_QUIT;
+    sm.event(event);
+    sm.quit();
+
+    // Quitting waits for the factory, which may still use what it captured
+    EXPECT(made);
+  }
+
+  EXPECT(made);
+}
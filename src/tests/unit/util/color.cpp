@@ -146,6 +146,21 @@ TEST(UNIT__Color__operator_divide_equals)
   EXPECT_FLT_EQ(c1.a, 1e6f / -1e5f);
 }
 
+TEST(UNIT__Color__operator_equals)
+{
+  EXPECT(Color() == Color());
+  EXPECT(Color(0.1f, 0.2f, 0.3f) == Color(0.1f, 0.2f, 0.3f, 1.0f));
+  EXPECT(!(Color(0.1f, 0.2f, 0.3f) == Color(0.1f, 0.2f, 0.3f, 0.5f)));
+  EXPECT(!(Color(0.1f, 0.2f, 0.3f) == Color(0.3f, 0.2f, 0.1f)));
+}
+
+TEST(UNIT__Color__operator_not_equals)
+{
+  EXPECT(!(Color() != Color()));
+  EXPECT(Color(0.1f, 0.2f, 0.3f) != Color(0.1f, 0.2f, 0.3f, 0.5f));
+  EXPECT(Color(0.1f, 0.2f, 0.3f) != Color(0.3f, 0.2f, 0.1f));
+}
+
 TEST(UNIT__Color__operator_printstream)
 {
   // There is no guarantee regarding what it will print, only that it won't
@@ -0,0 +1,45 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "util/json.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+static std::string
+to_json(const std::string& str)
+{
+  std::ostringstream out;
+  Json::write_string(out, str);
+  return out.str();
+}
+
+TEST(UNIT__Json__write_string)
+{
+  EXPECT_EQ(to_json(""), "\"\"");
+  EXPECT_EQ(to_json("level.stml"), "\"level.stml\"");
+  EXPECT_EQ(to_json("a \"b\" c\\d"), "\"a \\\"b\\\" c\\\\d\"");
+  EXPECT_EQ(to_json("1\n2\t3\x1f"), "\"1\\n2\\u00093\\u001f\"");
+  EXPECT_EQ(to_json("caf\xc3\xa9"), "\"caf\xc3\xa9\"");
+
+  // Escaping doesn't leave the stream in hex
+  std::ostringstream out;
+  Json::write_string(out, "\x01");
+  out << 10 << ' ' << std::setw(3) << 1;
+  EXPECT_EQ(out.str(), "\"\\u0001\"10   1");
+}
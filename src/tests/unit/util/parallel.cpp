@@ -0,0 +1,52 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "util/parallel.hpp"
+
+#include <atomic>
+#include <initializer_list>
+#include <vector>
+
+TEST(UNIT__Parallel__run)
+{
+  // Every item is processed exactly once, whatever the number of threads
+  for (size_t threads : { 0u, 1u, 4u, 64u })
+  {
+    std::vector<std::atomic<int>> items(1000);
+    std::atomic<size_t> calls(0);
+    std::atomic<size_t> too_big(0);
+
+    Parallel::run(items.size(), 7, threads, [&] (size_t begin, size_t end) {
+      calls++;
+      if (end - begin > 7)
+        too_big++;
+
+      for (size_t i = begin; i < end; i++)
+        items[i]++;
+    });
+
+    EXPECT_EQ(calls.load(), 143u);
+    EXPECT_EQ(too_big.load(), 0u);
+
+    for (const auto& item : items)
+      EXPECT_EQ(item.load(), 1);
+  }
+
+  // Nothing to do
+  Parallel::run(0, 16, 4, [] (size_t, size_t) { EXPECT(false); });
+}
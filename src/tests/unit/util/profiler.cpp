@@ -0,0 +1,120 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "util/profiler.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+static size_t
+count(const std::string& str, const std::string& part)
+{
+  size_t n = 0;
+
+  for (size_t pos = str.find(part); pos != std::string::npos;
+       pos = str.find(part, pos + 1))
+    n++;
+
+  return n;
+}
+
+static std::string
+get_trace()
+{
+  std::stringstream out;
+  Profiler::write_trace(out);
+  return out.str();
+}
+
+TEST(UNIT__Profiler__Scope)
+{
+  Profiler::clear();
+  Profiler::set_enabled(true);
+
+  {
+    Profiler::Scope outer("UNIT__Profiler__Scope__outer");
+    Profiler::Scope inner("UNIT__Profiler__Scope__inner");
+  }
+
+  Profiler::set_enabled(false);
+
+  {
+    Profiler::Scope ignored("UNIT__Profiler__Scope__ignored");
+  }
+
+  std::string trace = get_trace();
+  Profiler::clear();
+
+  EXPECT_EQ(count(trace, "\"ph\":\"X\""), 2);
+  EXPECT_EQ(count(trace, "\"name\":\"UNIT__Profiler__Scope__outer\""), 1);
+  EXPECT_EQ(count(trace, "\"name\":\"UNIT__Profiler__Scope__inner\""), 1);
+  EXPECT_EQ(count(trace, "UNIT__Profiler__Scope__ignored"), 0);
+}
+
+TEST(UNIT__Profiler__write_trace)
+{
+  Profiler::clear();
+  Profiler::set_enabled(true);
+
+  Profiler::record("UNIT__Profiler__write_trace", 1234567, 1240567);
+  Profiler::record("UNIT__Profiler__write_trace \"a\\b\"\n", 0, 1);
+
+  std::thread thread([] {
+    Profiler::set_thread_name("UNIT__Profiler__write_trace__thread");
+    Profiler::record("UNIT__Profiler__write_trace__other", 0, 1000);
+  });
+  thread.join();
+
+  Profiler::set_enabled(false);
+  std::string trace = get_trace();
+  Profiler::clear();
+
+  EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0);
+  EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+  EXPECT_NEQ(trace.find("{\"name\":\"UNIT__Profiler__write_trace\","
+                        "\"ph\":\"X\",\"pid\":1,\"tid\":"),
+             std::string::npos);
+  EXPECT_NEQ(trace.find(",\"ts\":1234.567,\"dur\":6.000}"), std::string::npos);
+  EXPECT_NEQ(trace.find(",\"ts\":0.000,\"dur\":1.000}"), std::string::npos);
+  EXPECT_NEQ(trace.find("{\"name\":\"UNIT__Profiler__write_trace "
+                        "\\\"a\\\\b\\\"\\n\","),
+             std::string::npos);
+  EXPECT_NEQ(trace.find("\"args\":{\"name\":"
+                        "\"UNIT__Profiler__write_trace__thread\"}}"),
+             std::string::npos);
+}
+
+TEST(UNIT__Profiler__record__overflow)
+{
+  Profiler::clear();
+  Profiler::set_enabled(true);
+
+  // Only the most recent events are kept
+  for (int i = 0; i < 100000; i++)
+    Profiler::record(i < 50000 ? "UNIT__Profiler__old" : "UNIT__Profiler__new",
+                     i, i + 1);
+
+  Profiler::set_enabled(false);
+  std::string trace = get_trace();
+  Profiler::clear();
+
+  EXPECT_EQ(count(trace, "UNIT__Profiler__old"), 0);
+  EXPECT(count(trace, "UNIT__Profiler__new") > 0);
+  EXPECT(count(trace, "UNIT__Profiler__new") <= 50000);
+}
@@ -0,0 +1,151 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tests/tests.hpp"
+
+#include "video/drawing_context.hpp"
+
+#include <vector>
+
+/** Draws a background, a grid of 32x32 tiles and a cursor at @p cursor. */
+static void
+draw_frame(DrawingContext& context, const Vector& cursor)
+{
+  context.draw_filled_rect(context.target_size, Color(0.1f, 0.2f, 0.4f),
+                           Blend::NONE);
+
+  for (int y = 0; y < 10; y++)
+    for (int x = 0; x < 10; x++)
+      context.draw_texture("tile.png", true, {},
+                           Rect(Vector(x, y) * 32.0f, Size(32.0f, 32.0f)),
+                           Color(1.0f, 1.0f, 1.0f), Blend::BLEND);
+
+  context.draw_filled_rect(Rect(cursor, Size(32.0f, 32.0f)),
+                           Color(1.0f, 1.0f, 1.0f, 0.5f), Blend::BLEND);
+}
+
+TEST(UNIT__DrawingContext__get_damage)
+{
+  DrawingContext context;
+  std::vector<Rect> damage;
+  context.target_size = Size(640.0f, 480.0f);
+
+  draw_frame(context, Vector(64.0f, 64.0f));
+  context.clear();
+
+  // Same frame: nothing to draw
+  draw_frame(context, Vector(64.0f, 64.0f));
+  EXPECT(context.get_damage(damage));
+  EXPECT_EQ(damage.size(), 0u);
+  context.clear();
+
+  // Moving the cursor damages its old and new places, with a pixel of margin
+  draw_frame(context, Vector(256.0f, 64.0f));
+  EXPECT(context.get_damage(damage));
+  EXPECT_EQ(damage.size(), 2u);
+  EXPECT_EQ(damage[0], Rect(255.0f, 63.0f, 289.0f, 97.0f));
+  EXPECT_EQ(damage[1], Rect(63.0f, 63.0f, 97.0f, 97.0f));
+  context.clear();
+
+  // Overlapping areas are merged
+  draw_frame(context, Vector(272.0f, 64.0f));
+  EXPECT(context.get_damage(damage));
+  EXPECT_EQ(damage.size(), 1u);
+  EXPECT_EQ(damage[0], Rect(255.0f, 63.0f, 305.0f, 97.0f));
+  context.clear();
+
+  // Areas are clipped to the target
+  draw_frame(context, Vector(630.0f, -16.0f));
+  EXPECT(context.get_damage(damage));
+  EXPECT_EQ(damage.size(), 2u);
+  EXPECT_EQ(damage[0], Rect(629.0f, 0.0f, 640.0f, 17.0f));
+  context.clear();
+
+  // Resizing redraws everything
+  context.target_size = Size(800.0f, 600.0f);
+  draw_frame(context, Vector(630.0f, -16.0f));
+  EXPECT(!context.get_damage(damage));
+  context.clear();
+}
+
+TEST(UNIT__DrawingContext__get_damage__order)
+{
+  DrawingContext context;
+  std::vector<Rect> damage;
+  context.target_size = Size(640.0f, 480.0f);
+
+  Rect r1(0.0f, 0.0f, 100.0f, 100.0f);
+  Rect r2(50.0f, 50.0f, 150.0f, 150.0f);
+
+  context.draw_filled_rect(r1, Color(1.0f, 0.0f, 0.0f), Blend::NONE);
+  context.draw_filled_rect(r2, Color(0.0f, 1.0f, 0.0f), Blend::NONE);
+  context.clear();
+
+  // The same requests in another order don't look the same where they meet
+  context.draw_filled_rect(r2, Color(0.0f, 1.0f, 0.0f), Blend::NONE);
+  context.draw_filled_rect(r1, Color(1.0f, 0.0f, 0.0f), Blend::NONE);
+  EXPECT(context.get_damage(damage));
+  EXPECT_NEQ(damage.size(), 0u);
+  context.clear();
+
+  // Too many changes redraw everything
+  for (int i = 0; i < 1000; i++)
+    context.draw_filled_rect(Rect(i % 640, i / 640, i % 640 + 1, i / 640 + 1),
+                             Color(1.0f, 1.0f, 1.0f), Blend::NONE);
+
+  EXPECT(!context.get_damage(damage));
+}
+
+TEST(UNIT__DrawingContext__record_layer)
+{
+  DrawingContext context;
+  std::vector<Rect> damage;
+  context.target_size = Size(640.0f, 480.0f);
+
+  context.draw_filled_rect(Rect(0.0f, 0.0f, 8.0f, 8.0f),
+                           Color(1.0f, 1.0f, 1.0f), Blend::NONE);
+
+  auto layer = context.record_layer([] (DrawingContext& layer_context) {
+    draw_frame(layer_context, Vector(64.0f, 64.0f));
+  });
+
+  EXPECT_EQ(layer->requests.size(), 102u);
+  EXPECT_EQ(layer->size, Size(640.0f, 480.0f));
+
+  // The layer's requests don't end up in the frame
+  context.draw_layer(layer);
+  context.clear();
+  context.draw_filled_rect(Rect(0.0f, 0.0f, 8.0f, 8.0f),
+                           Color(1.0f, 1.0f, 1.0f), Blend::NONE);
+  context.draw_layer(layer);
+  EXPECT(context.get_damage(damage));
+  EXPECT_EQ(damage.size(), 0u);
+  context.clear();
+
+  // A layer recorded again is drawn again, even if it looks the same
+  auto layer2 = context.record_layer([] (DrawingContext& layer_context) {
+    draw_frame(layer_context, Vector(64.0f, 64.0f));
+  });
+
+  EXPECT_NEQ(layer2->id, layer->id);
+
+  context.draw_filled_rect(Rect(0.0f, 0.0f, 8.0f, 8.0f),
+                           Color(1.0f, 1.0f, 1.0f), Blend::NONE);
+  context.draw_layer(layer2);
+  EXPECT(context.get_damage(damage));
+  EXPECT_EQ(damage.size(), 1u);
+  EXPECT_EQ(damage[0], Rect(0.0f, 0.0f, 640.0f, 480.0f));
+}
@@ -104,6 +104,18 @@ Color::operator/=(const Color& color)
   return *this;
 }
 
+bool
+Color::operator==(const Color& color) const
+{
+  return r == color.r && g == color.g && b == color.b && a == color.a;
+}
+
+bool
+Color::operator!=(const Color& color) const
+{
+  return !(*this == color);
+}
+
 std::ostream& operator<<(std::ostream& stream, const Color& color)
 {
   return stream << "Color(" << color.r << ", " << color.g << ", " << color.b
@@ -35,6 +35,8 @@ public:
   Color& operator*=(const Color& color);
   Color operator/(const Color& color) const;
   Color& operator/=(const Color& color);
+  bool operator==(const Color& color) const;
+  bool operator!=(const Color& color) const;
 
 public:
   float r, g, b, a;
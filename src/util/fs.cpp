@@ -16,13 +16,56 @@
 
 #include "util/fs.hpp"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <stdexcept>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
 #include "physfs.h"
 
 #include "util/log.hpp"
 
+static std::string
+to_native_path(const std::string& dir, const std::string& file)
+{
+  std::string separator(PHYSFS_getDirSeparator());
+  std::string path(dir);
+
+  if (file.empty() || file[0] != '/')
+    path += separator;
+
+  for (char c : file)
+  {
+    if (c == '/')
+      path += separator;
+    else
+      path += c;
+  }
+
+  return path;
+}
+
+#ifdef _WIN32
+/** Converts a UTF-8 path, as given by PhysFS, to the wide form Windows uses */
+static std::wstring
+to_wide_path(const std::string& path)
+{
+  int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+
+  if (length <= 0)
+    throw std::runtime_error("Invalid path '" + path + "'");
+
+  std::wstring wide(length, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], length);
+  wide.resize(length - 1);
+  return wide;
+}
+#endif
+
 SDL_RWops*
 FS::get_rwops(const std::string& file, OP operation)
 {
@@ -49,7 +92,7 @@ FS::get_rwops(const std::string& file, OP operation)
         break;
 
       case SEEK_END:
-        success = PHYSFS_seek(file, offset + PHYSFS_fileLength(file) + offset);
+        success = PHYSFS_seek(file, offset + PHYSFS_fileLength(file));
         break;
 
       default:
@@ -193,6 +236,102 @@ FS::get_rwops(const std::string& file, OP operation)
   return ops.release();
 }
 
+/**
+ * Finds where @p file is on the native filesystem, for the code that can't go
+ * through PhysFS (e. g. to memory-map a file). If the file is stored inside an
+ * archive, the returned path won't be openable.
+ */
+std::string
+FS::get_real_path(const std::string& file)
+{
+  const char* dir = PHYSFS_getRealDir(file.c_str());
+
+  if (!dir)
+    throw std::runtime_error("Could not find file '" + file + "'");
+
+  return to_native_path(dir, file);
+}
+
+bool
+FS::exists(const std::string& file)
+{
+  return PHYSFS_exists(file.c_str()) != 0;
+}
+
+/**
+ * Lists the files in @p dir and its subdirectories, in alphabetical order.
+ * Directories themselves aren't listed.
+ */
+std::vector<std::string>
+FS::list_files(const std::string& dir)
+{
+  char** list = PHYSFS_enumerateFiles(dir.c_str());
+
+  if (!list)
+    throw std::runtime_error("Could not list '" + dir + "': "
+                             + get_physfs_err());
+
+  std::string prefix = (dir.empty() || dir.back() == '/') ? dir : dir + "/";
+  std::vector<std::string> entries;
+
+  for (char** entry = list; *entry; entry++)
+    entries.push_back(prefix + *entry);
+
+  PHYSFS_freeList(list);
+
+  std::vector<std::string> files;
+
+  for (const auto& entry : entries)
+  {
+    if (PHYSFS_isDirectory(entry.c_str()))
+    {
+      auto sub_files = list_files(entry);
+      files.insert(files.end(), sub_files.begin(), sub_files.end());
+    }
+    else
+    {
+      files.push_back(entry);
+    }
+  }
+
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+/**
+ * Renames a file in the write directory, replacing @p to if it exists. PhysFS
+ * has no way to rename files, so this goes through the native filesystem.
+ */
+void
+FS::rename(const std::string& from, const std::string& to)
+{
+  const char* dir = PHYSFS_getWriteDir();
+
+  if (!dir)
+    throw std::runtime_error("Could not rename '" + from + "': no write dir");
+
+  std::string native_from = to_native_path(dir, from);
+  std::string native_to = to_native_path(dir, to);
+
+#ifdef _WIN32
+  // std::rename() doesn't replace existing files on Windows, and removing the
+  // file first would lose it if the game stops in between
+  if (!MoveFileExW(to_wide_path(native_from).c_str(),
+                   to_wide_path(native_to).c_str(),
+                   MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+  {
+    throw std::runtime_error("Could not rename '" + from + "' to '" + to
+                             + "': error " + std::to_string(GetLastError()));
+  }
+#else
+  if (std::rename(native_from.c_str(), native_to.c_str()))
+  {
+    throw std::runtime_error("Could not rename '" + from + "' to '" + to
+                             + "': " + std::strerror(errno));
+  }
+#endif
+}
+
 std::string
 FS::get_physfs_err()
 {
@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "SDL2/SDL.h"
 
@@ -35,6 +36,10 @@ public:
 public:
   /** The pointer must be freed by the caller. */
   static SDL_RWops* get_rwops(const std::string& file, OP operation);
+  static std::string get_real_path(const std::string& file);
+  static bool exists(const std::string& file);
+  static std::vector<std::string> list_files(const std::string& dir);
+  static void rename(const std::string& from, const std::string& to);
   static std::string get_physfs_err();
 };
 
@@ -0,0 +1,61 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "util/json.hpp"
+
+#include <iomanip>
+
+/**
+ * Writes @p str as a quoted JSON string. Quotes, backslashes and control
+ * characters are escaped; other bytes are written as-is, so UTF-8 stays valid.
+ */
+void
+Json::write_string(std::ostream& out, const std::string& str)
+{
+  out << '"';
+
+  for (char c : str)
+  {
+    switch (c)
+    {
+      case '"':
+        out << "\\\"";
+        break;
+
+      case '\\':
+        out << "\\\\";
+        break;
+
+      case '\n':
+        out << "\\n";
+        break;
+
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+              << static_cast<int>(c) << std::dec << std::setfill(' ');
+        }
+        else
+        {
+          out << c;
+        }
+        break;
+    }
+  }
+
+  out << '"';
+}
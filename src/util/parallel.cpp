@@ -0,0 +1,62 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "util/parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * Calls @p work on all of @p count items, in batches of @p batch_size, spread
+ * over up to @p threads threads including the calling one. Returns once all
+ * batches are done.
+ *
+ * Each thread takes the next batch once done with its last one, so that slow
+ * items don't hold back a whole share of the others. Batches may be processed
+ * in any order and at the same time, and @p work must not throw.
+ */
+void
+Parallel::run(size_t count, size_t batch_size, size_t threads,
+              const Work& work)
+{
+  batch_size = std::max(batch_size, size_t(1));
+
+  std::atomic<size_t> next(0);
+
+  auto run_batches = [&] {
+    for (size_t i = next.fetch_add(batch_size); i < count;
+         i = next.fetch_add(batch_size))
+      work(i, std::min(i + batch_size, count));
+  };
+
+#ifdef EMSCRIPTEN
+  (void) threads;
+  run_batches();
+#else
+  std::vector<std::thread> pool;
+  size_t batches = (count + batch_size - 1) / batch_size;
+
+  for (size_t i = 1; i < std::min(threads, batches); i++)
+    pool.emplace_back(run_batches);
+
+  run_batches();
+
+  for (auto& thread : pool)
+    thread.join();
+#endif
+}
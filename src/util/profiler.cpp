@@ -0,0 +1,260 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "util/profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "util/json.hpp"
+
+/** Events kept per thread, about a megabyte */
+static const size_t g_buffer_size = 1 << 15;
+
+class ProfilerEvent final
+{
+public:
+  const char* name;
+  int64_t start;
+  int64_t end;
+  uint32_t thread;
+};
+
+/** Written by one thread only; read when writing the trace. */
+class ProfilerBuffer final
+{
+public:
+  ProfilerBuffer() :
+    events(g_buffer_size),
+    count(0),
+    thread(0)
+  {
+  }
+
+public:
+  std::vector<ProfilerEvent> events;
+  /** Number of events ever recorded, including overwritten ones */
+  std::atomic<size_t> count;
+  uint32_t thread;
+
+private:
+  ProfilerBuffer(const ProfilerBuffer&) = delete;
+  ProfilerBuffer& operator=(const ProfilerBuffer&) = delete;
+};
+
+static std::atomic<bool> g_enabled(false);
+static const std::chrono::steady_clock::time_point g_epoch =
+                                              std::chrono::steady_clock::now();
+static std::atomic<uint32_t> g_next_thread(1);
+
+// Only taken when a thread records for the first time or exits
+static std::mutex g_mutex;
+static std::vector<std::unique_ptr<ProfilerBuffer>> g_buffers;
+/** Buffers of the threads which exited, to be reused by new threads */
+static std::vector<ProfilerBuffer*> g_free_buffers;
+static std::vector<std::pair<uint32_t, std::string>> g_thread_names;
+
+static uint32_t
+get_thread_id()
+{
+  thread_local uint32_t id = g_next_thread++;
+  return id;
+}
+
+/** Gives the buffer of a thread back when the thread exits. */
+class ProfilerBufferOwner final
+{
+public:
+  ProfilerBufferOwner() :
+    buffer(nullptr)
+  {
+  }
+
+  ~ProfilerBufferOwner()
+  {
+    if (!buffer)
+      return;
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_free_buffers.push_back(buffer);
+  }
+
+public:
+  ProfilerBuffer* buffer;
+
+private:
+  ProfilerBufferOwner(const ProfilerBufferOwner&) = delete;
+  ProfilerBufferOwner& operator=(const ProfilerBufferOwner&) = delete;
+};
+
+static ProfilerBuffer&
+get_buffer()
+{
+  thread_local ProfilerBufferOwner owner;
+
+  if (!owner.buffer)
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    if (g_free_buffers.empty())
+    {
+      g_buffers.push_back(std::make_unique<ProfilerBuffer>());
+      owner.buffer = g_buffers.back().get();
+    }
+    else
+    {
+      owner.buffer = g_free_buffers.back();
+      g_free_buffers.pop_back();
+    }
+
+    owner.buffer->thread = get_thread_id();
+  }
+
+  return *owner.buffer;
+}
+
+static void
+write_microseconds(std::ostream& out, int64_t ns)
+{
+  auto fill = out.fill('0');
+  out << ns / 1000 << '.';
+  out.width(3);
+  out << ns % 1000;
+  out.fill(fill);
+}
+
+Profiler::Scope::Scope(const char* name) :
+  m_name(name),
+  m_start(Profiler::is_enabled() ? Profiler::now() : -1)
+{
+}
+
+Profiler::Scope::~Scope()
+{
+  if (m_start >= 0)
+    Profiler::record(m_name, m_start, Profiler::now());
+}
+
+void
+Profiler::set_enabled(bool enabled)
+{
+  g_enabled = enabled;
+}
+
+bool
+Profiler::is_enabled()
+{
+  return g_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Names the calling thread in the trace, if the profiler is enabled. @p name
+ * must not need escaping in JSON.
+ */
+void
+Profiler::set_thread_name(const char* name)
+{
+  if (!is_enabled())
+    return;
+
+  uint32_t thread = get_thread_id();
+
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_thread_names.emplace_back(thread, name);
+}
+
+/** Returns the time since the game started, in nanoseconds. */
+int64_t
+Profiler::now()
+{
+  auto time = std::chrono::steady_clock::now() - g_epoch;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+/** Records that @p name ran between @p start_ns and @p end_ns (see now()). */
+void
+Profiler::record(const char* name, int64_t start_ns, int64_t end_ns)
+{
+  ProfilerBuffer& buffer = get_buffer();
+  size_t count = buffer.count.load(std::memory_order_relaxed);
+
+  ProfilerEvent& event = buffer.events[count % g_buffer_size];
+  event.name = name;
+  event.start = start_ns;
+  event.end = end_ns;
+  event.thread = buffer.thread;
+
+  buffer.count.store(count + 1, std::memory_order_release);
+}
+
+/**
+ * Writes the recorded events in the Chrome trace event format. Threads which
+ * keep recording meanwhile may have their oldest events garbled.
+ */
+void
+Profiler::write_trace(std::ostream& out)
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+
+  bool first = true;
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  for (const auto& name : g_thread_names)
+  {
+    out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\","
+        << "\"pid\":1,\"tid\":" << name.first << ",\"args\":{\"name\":";
+    Json::write_string(out, name.second);
+    out << "}}";
+    first = false;
+  }
+
+  for (const auto& buffer : g_buffers)
+  {
+    size_t count = buffer->count.load(std::memory_order_acquire);
+    size_t begin = count > g_buffer_size ? count - g_buffer_size : 0;
+
+    for (size_t i = begin; i < count; i++)
+    {
+      const ProfilerEvent& event = buffer->events[i % g_buffer_size];
+
+      out << (first ? "\n" : ",\n") << "{\"name\":";
+      Json::write_string(out, event.name);
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":";
+      write_microseconds(out, event.start);
+      out << ",\"dur\":";
+      write_microseconds(out, event.end - event.start);
+      out << "}";
+      first = false;
+    }
+  }
+
+  out << "\n]}\n";
+}
+
+/** Forgets the recorded events. No thread may be recording meanwhile. */
+void
+Profiler::clear()
+{
+  std::lock_guard<std::mutex> lock(g_mutex);
+
+  for (const auto& buffer : g_buffers)
+    buffer->count = 0;
+}
@@ -0,0 +1,75 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_UTIL_PROFILER_HPP
+#define HEADER_STM_UTIL_PROFILER_HPP
+
+#include <cstdint>
+#include <ostream>
+
+#ifdef STM_PROFILING
+#define STM_PROFILE_CONCAT_(a, b) a##b
+#define STM_PROFILE_CONCAT(a, b) STM_PROFILE_CONCAT_(a, b)
+/** Records the time spent until the end of the scope, under @p name. */
+#define STM_PROFILE_SCOPE(name)                                                \
+  Profiler::Scope STM_PROFILE_CONCAT(stm_profile_scope_, __LINE__)(name)
+#else
+#define STM_PROFILE_SCOPE(name) do {} while (false)
+#endif
+
+/**
+ * Records how long parts of the code take, on every thread, to be viewed as a
+ * timeline in Chrome's about:tracing or in Perfetto.
+ *
+ * Each thread records into a ring buffer of its own, without locking; when
+ * the buffer is full, the oldest events are overwritten. Scopes nested in
+ * each other show up nested in the timeline.
+ *
+ * Nothing is recorded unless enabled. Names must be string literals; they are
+ * kept as pointers and written to the trace as-is.
+ */
+class Profiler final
+{
+public:
+  class Scope final
+  {
+  public:
+    Scope(const char* name);
+    ~Scope();
+
+  private:
+    const char* m_name;
+    /** Start time, negative if the profiler was disabled */
+    int64_t m_start;
+
+  private:
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+public:
+  static void set_enabled(bool enabled);
+  static bool is_enabled();
+  static void set_thread_name(const char* name);
+
+  static int64_t now();
+  static void record(const char* name, int64_t start_ns, int64_t end_ns);
+
+  static void write_trace(std::ostream& out);
+  static void clear();
+};
+
+#endif
@@ -16,12 +16,77 @@
 
 #include "video/drawing_context.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <stdexcept>
 #include <string>
 
+#include "util/profiler.hpp"
+
+/** Above this many changed requests, the whole frame is drawn again */
+static const size_t MAX_DAMAGED_REQUESTS = 256;
+
+static std::atomic<uint64_t> g_next_layer_id(1);
+
+static uint64_t
+hash_combine(uint64_t hash, uint64_t value)
+{
+  return (hash ^ value) * 0x100000001b3ULL;
+}
+
+static uint64_t
+hash_combine(uint64_t hash, float value)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return hash_combine(hash, static_cast<uint64_t>(bits));
+}
+
+static uint64_t
+hash_combine(uint64_t hash, const Vector& vector)
+{
+  return hash_combine(hash_combine(hash, vector.x), vector.y);
+}
+
+static uint64_t
+hash_combine(uint64_t hash, const Rect& rect)
+{
+  return hash_combine(hash_combine(hash, rect.top_lft()), rect.bot_rgt());
+}
+
+static uint64_t
+hash_combine(uint64_t hash, const Color& color)
+{
+  hash = hash_combine(hash_combine(hash, color.r), color.g);
+  return hash_combine(hash_combine(hash, color.b), color.a);
+}
+
+static uint64_t
+hash_combine(uint64_t hash, Blend blend)
+{
+  return hash_combine(hash, static_cast<uint64_t>(blend));
+}
+
+/** Returns the smallest rectangle which covers both @p a and @p b. */
+static Rect
+get_union(const Rect& a, const Rect& b)
+{
+  return Rect(std::min(a.x1, b.x1), std::min(a.y1, b.y1),
+              std::max(a.x2, b.x2), std::max(a.y2, b.y2));
+}
+
 DrawingContext::RenderCache::RenderCache(Renderer& renderer) :
-  m_renderer(renderer)
+  m_renderer(renderer),
+  m_textures(),
+  m_texture_bytes(0),
+  m_texts(),
+  m_layers(),
+  m_used_texts(),
+  m_used_layers()
 {
 }
 
@@ -35,12 +100,118 @@ DrawingContext::RenderCache::get_texture(const std::string& texture,
   if (it == m_textures.end())
   {
     auto t = std::make_unique<Texture>(m_renderer, texture, physfs);
+    Size size = t->get_size();
+    m_texture_bytes += static_cast<size_t>(size.w * size.h) * 4;
     it = m_textures.emplace(id, std::move(t)).first;
   }
 
   return *(it->second);
 }
 
+/**
+ * Returns @p text rendered with @p font and wrapped at @p width, rendering it
+ * if it wasn't drawn in the last frame. @p key must identify the font and
+ * width as well as the text.
+ */
+Texture&
+DrawingContext::RenderCache::get_text(const std::string& key, const Font& font,
+                                      const std::string& text, float width)
+{
+  m_used_texts.insert(key);
+  auto it = m_texts.find(key);
+
+  if (it == m_texts.end())
+    it = m_texts.emplace(key, font.draw_text(m_renderer, text, width)).first;
+
+  return *(it->second);
+}
+
+/** Returns the texture of @p layer, rendering it if it wasn't yet. */
+Texture&
+DrawingContext::RenderCache::get_layer(const Layer& layer)
+{
+  m_used_layers.insert(layer.id);
+  auto it = m_layers.find(layer.id);
+
+  if (it != m_layers.end())
+    return *(it->second);
+
+  // Layers drawn in this one must be rendered first, they change the target
+  for (const auto& request : layer.requests)
+    request->prepare(m_renderer);
+
+  auto texture = std::make_unique<Texture>(m_renderer, layer.size);
+  m_renderer.set_target(texture.get());
+  m_renderer.clear();
+
+  for (const auto& request : layer.requests)
+    request->draw(m_renderer);
+
+  m_renderer.set_target(nullptr);
+
+  return *(m_layers.emplace(layer.id, std::move(texture)).first->second);
+}
+
+/** Frees the textures of the layers, to render them again when next drawn. */
+void
+DrawingContext::RenderCache::drop_layers()
+{
+  m_layers.clear();
+}
+
+/**
+ * Frees the textures of the text and layers which weren't drawn since last
+ * called.
+ */
+void
+DrawingContext::RenderCache::drop_unused()
+{
+  for (auto it = m_texts.begin(); it != m_texts.end();)
+  {
+    if (m_used_texts.count(it->first))
+      ++it;
+    else
+      it = m_texts.erase(it);
+  }
+
+  for (auto it = m_layers.begin(); it != m_layers.end();)
+  {
+    if (m_used_layers.count(it->first))
+      ++it;
+    else
+      it = m_layers.erase(it);
+  }
+
+  m_used_texts.clear();
+  m_used_layers.clear();
+}
+
+/** Assumes 32 bits per pixel, which the GPU may not be using. */
+size_t
+DrawingContext::RenderCache::get_texture_bytes() const
+{
+  size_t bytes = m_texture_bytes;
+
+  for (const auto& text : m_texts)
+  {
+    Size size = text.second->get_size();
+    bytes += static_cast<size_t>(size.w * size.h) * 4;
+  }
+
+  for (const auto& layer : m_layers)
+  {
+    Size size = layer.second->get_size();
+    bytes += static_cast<size_t>(size.w * size.h) * 4;
+  }
+
+  return bytes;
+}
+
+void
+DrawingContext::Request::prepare(Renderer& renderer) const
+{
+}
+
 DrawingContext::RectRequest::RectRequest(const Rect& rect, const Color& color,
                                          Blend blend) :
   m_rect(rect),
@@ -55,6 +226,30 @@ DrawingContext::RectRequest::draw(Renderer& renderer) const
   renderer.draw_filled_rect(m_rect, m_color, m_blend);
 }
 
+bool
+DrawingContext::RectRequest::get_bounds(Rect& bounds) const
+{
+  bounds = m_rect.fixed();
+  return true;
+}
+
+uint64_t
+DrawingContext::RectRequest::get_hash() const
+{
+  uint64_t hash = hash_combine(0xcbf29ce484222325ULL, uint64_t(1));
+  hash = hash_combine(hash_combine(hash, m_rect), m_color);
+  return hash_combine(hash, m_blend);
+}
+
+bool
+DrawingContext::RectRequest::equals(const Request& request) const
+{
+  auto* other = dynamic_cast<const RectRequest*>(&request);
+
+  return other && other->m_rect == m_rect && other->m_color == m_color
+         && other->m_blend == m_blend;
+}
+
 DrawingContext::LineRequest::LineRequest(const Vector& p1, const Vector& p2,
                                          const Color& color, Blend blend) :
   m_p1(p1),
@@ -70,6 +265,31 @@ DrawingContext::LineRequest::draw(Renderer& renderer) const
   renderer.draw_line(m_p1, m_p2, m_color, m_blend);
 }
 
+bool
+DrawingContext::LineRequest::get_bounds(Rect& bounds) const
+{
+  // Lines are one pixel wide, and cover the pixel of their last point
+  bounds = Rect(m_p1, m_p2).fix().grow(1.0f);
+  return true;
+}
+
+uint64_t
+DrawingContext::LineRequest::get_hash() const
+{
+  uint64_t hash = hash_combine(0xcbf29ce484222325ULL, uint64_t(2));
+  hash = hash_combine(hash_combine(hash, m_p1), m_p2);
+  return hash_combine(hash_combine(hash, m_color), m_blend);
+}
+
+bool
+DrawingContext::LineRequest::equals(const Request& request) const
+{
+  auto* other = dynamic_cast<const LineRequest*>(&request);
+
+  return other && other->m_p1 == m_p1 && other->m_p2 == m_p2
+         && other->m_color == m_color && other->m_blend == m_blend;
+}
+
 DrawingContext::TextureRequest::TextureRequest(const std::string& texture,
                                                bool physfs, const Rect& src,
                                                const Rect& dst,
@@ -95,26 +315,111 @@ DrawingContext::TextureRequest::draw(Renderer& renderer) const
   renderer.draw_texture(texture, src, m_dst, m_color, m_blend);
 }
 
+bool
+DrawingContext::TextureRequest::get_bounds(Rect& bounds) const
+{
+  bounds = m_dst.fixed();
+  return true;
+}
+
+uint64_t
+DrawingContext::TextureRequest::get_hash() const
+{
+  uint64_t hash = hash_combine(0xcbf29ce484222325ULL, uint64_t(3));
+  hash = hash_combine(hash, static_cast<uint64_t>(
+                                    std::hash<std::string>()(m_texture)));
+  hash = hash_combine(hash, static_cast<uint64_t>(m_physfs));
+  hash = hash_combine(hash_combine(hash, m_src), m_dst);
+  return hash_combine(hash_combine(hash, m_color), m_blend);
+}
+
+bool
+DrawingContext::TextureRequest::equals(const Request& request) const
+{
+  auto* other = dynamic_cast<const TextureRequest*>(&request);
+
+  return other && other->m_texture == m_texture
+         && other->m_physfs == m_physfs && other->m_src == m_src
+         && other->m_dst == m_dst && other->m_color == m_color
+         && other->m_blend == m_blend;
+}
+
 DrawingContext::TextRequest::TextRequest(const std::string& text,
-                                         const Font& font, const Rect& dst,
+                                         const std::string& font, bool physfs,
+                                         int size, const Rect& dst,
                                          TextAlign align, const Color& color,
-                                         Blend blend, bool outline) :
+                                         Blend blend, bool outline,
+                                         DrawingContext& context) :
   m_text(text),
   m_font(font),
+  m_physfs(physfs),
+  m_size(size),
   m_dst(dst),
   m_align(align),
   m_color(color),
   m_blend(blend),
-  m_outline(outline)
+  m_outline(outline),
+  m_context(context),
+  m_bounds(),
+  m_prepared(false)
 {
 }
 
 void
 DrawingContext::TextRequest::draw(Renderer& renderer) const
 {
-  auto texture = m_font.draw_text(renderer, m_text, m_dst.width());
-  auto texture_size = texture->get_size();
+  auto& texture = get_texture(renderer);
+  auto texture_size = texture.get_size();
+  Rect dst = get_dst(texture_size);
+
+  if (m_outline)
+  {
+    for (int x = -1; x <= 1; x++)
+    {
+      for (int y = -1; y <= 1; y++)
+      {
+        renderer.draw_texture(texture, texture_size, dst.moved(Vector(x, y)),
+                              Color(), m_blend);
+      }
+    }
+
+    renderer.draw_texture(texture, texture_size,
+                          dst.moved(Vector(-2.0f, -2.0f)), Color(Color(), 0.5f),
+                          m_blend);
+  }
+
+  renderer.draw_texture(texture, texture_size, dst, m_color, m_blend);
+}
+
+/** Renders the text, which tells where it will be drawn. */
+void
+DrawingContext::TextRequest::prepare(Renderer& renderer) const
+{
+  Rect dst = get_dst(get_texture(renderer).get_size());
+
+  // Outlines are drawn up to two pixels up and left, and one down and right
+  if (m_outline)
+    dst = Rect(dst.x1 - 2.0f, dst.y1 - 2.0f, dst.x2 + 1.0f, dst.y2 + 1.0f);
+
+  m_bounds = dst;
+  m_prepared = true;
+}
+
+Texture&
+DrawingContext::TextRequest::get_texture(Renderer& renderer) const
+{
+  std::string key = m_font + (m_physfs ? "\n1\n" : "\n0\n")
+                    + std::to_string(m_size) + "\n"
+                    + std::to_string(m_dst.width()) + "\n" + m_text;
 
+  return m_context.get_render_cache(&renderer).get_text(
+    key, m_context.get_font(m_font, m_physfs, m_size), m_text, m_dst.width());
+}
+
+/** Returns where to draw a texture of @p texture_size holding the text. */
+Rect
+DrawingContext::TextRequest::get_dst(const Size& texture_size) const
+{
   Rect dst(m_dst.top_lft(), texture_size);
   Vector move;
 
@@ -155,24 +460,109 @@ DrawingContext::TextRequest::draw(Renderer& renderer) const
   }
 
   dst.move(move);
+  return dst;
+}
 
-  if (m_outline)
-  {
-    for (int x = -1; x <= 1; x++)
-    {
-      for (int y = -1; y <= 1; y++)
-      {
-        renderer.draw_texture(*texture, texture_size, dst.moved(Vector(x, y)),
-                              Color(), m_blend);
-      }
-    }
+bool
+DrawingContext::TextRequest::get_bounds(Rect& bounds) const
+{
+  // The text may overflow m_dst, its size is only known once rendered
+  if (!m_prepared)
+    return false;
 
-    renderer.draw_texture(*texture, texture_size,
-                          dst.moved(Vector(-2.0f, -2.0f)), Color(Color(), 0.5f),
-                          m_blend);
-  }
+  bounds = m_bounds;
+  return true;
+}
+
+uint64_t
+DrawingContext::TextRequest::get_hash() const
+{
+  uint64_t hash = hash_combine(0xcbf29ce484222325ULL, uint64_t(4));
+  hash = hash_combine(hash, static_cast<uint64_t>(
+                                    std::hash<std::string>()(m_text)));
+  hash = hash_combine(hash, static_cast<uint64_t>(
+                                    std::hash<std::string>()(m_font)));
+  hash = hash_combine(hash, static_cast<uint64_t>(m_physfs));
+  hash = hash_combine(hash, static_cast<uint64_t>(m_size));
+  hash = hash_combine(hash_combine(hash, m_dst),
+                      static_cast<uint64_t>(m_align));
+  hash = hash_combine(hash_combine(hash, m_color), m_blend);
+  return hash_combine(hash, static_cast<uint64_t>(m_outline));
+}
+
+bool
+DrawingContext::TextRequest::equals(const Request& request) const
+{
+  auto* other = dynamic_cast<const TextRequest*>(&request);
+
+  return other && other->m_text == m_text && other->m_font == m_font
+         && other->m_physfs == m_physfs && other->m_size == m_size
+         && other->m_dst == m_dst && other->m_align == m_align
+         && other->m_color == m_color && other->m_blend == m_blend
+         && other->m_outline == m_outline;
+}
 
-  renderer.draw_texture(*texture, texture_size, dst, m_color, m_blend);
+DrawingContext::LayerRequest::LayerRequest(std::shared_ptr<const Layer> layer,
+                                           const Rect& dst,
+                                           DrawingContext& context) :
+  m_layer(std::move(layer)),
+  m_dst(dst),
+  m_context(context)
+{
+}
+
+void
+DrawingContext::LayerRequest::draw(Renderer& renderer) const
+{
+  auto& texture = m_context.get_render_cache(&renderer).get_layer(*m_layer);
+
+  // The texture starts transparent, so blending the requests on it leaves
+  // colors multiplied by their alpha; blending them again would darken edges
+  renderer.draw_texture(texture, texture.get_size(), m_dst,
+                        Color(1.0f, 1.0f, 1.0f), Blend::PREMULTIPLIED);
+}
+
+void
+DrawingContext::LayerRequest::prepare(Renderer& renderer) const
+{
+  m_context.get_render_cache(&renderer).get_layer(*m_layer);
+}
+
+bool
+DrawingContext::LayerRequest::get_bounds(Rect& bounds) const
+{
+  bounds = m_dst.fixed();
+  return true;
+}
+
+uint64_t
+DrawingContext::LayerRequest::get_hash() const
+{
+  uint64_t hash = hash_combine(0xcbf29ce484222325ULL, uint64_t(5));
+  return hash_combine(hash_combine(hash, m_layer->id), m_dst);
+}
+
+bool
+DrawingContext::LayerRequest::equals(const Request& request) const
+{
+  auto* other = dynamic_cast<const LayerRequest*>(&request);
+
+  return other && other->m_layer->id == m_layer->id && other->m_dst == m_dst;
+}
+
+DrawingContext::Frame::Frame(Requests frame_requests,
+                             const Size& frame_size) :
+  requests(std::move(frame_requests)),
+  size(frame_size)
+{
+}
+
+DrawingContext::Layer::Layer(Requests layer_requests,
+                             const Size& layer_size) :
+  requests(std::move(layer_requests)),
+  size(layer_size),
+  id(g_next_layer_id++)
+{
 }
 
 DrawingContext::Transform::Transform() :
@@ -181,6 +571,14 @@ DrawingContext::Transform::Transform() :
 {
 }
 
+DrawingContext::RenderStats::RenderStats() :
+  draw_calls(0),
+  draw_sec(0.0f),
+  present_sec(0.0f),
+  texture_bytes(0)
+{
+}
+
 void
 DrawingContext::Transform::move(const Vector& offset)
 {
@@ -194,14 +592,30 @@ DrawingContext::Transform::scale(const Size& scale)
 }
 
 DrawingContext::DrawingContext() :
+  target_size(),
+  alpha(1.0f),
   m_requests(),
+  m_submitted(nullptr),
+  m_last_requests(),
+  m_last_size(),
+  m_last_renderer(nullptr),
+  m_rendered(false),
+  m_targets_lost(false),
+  m_device_lost(false),
   m_renderer_caches(),
   m_font_cache(),
-  m_transforms()
+  m_transforms(),
+  m_stats_mutex(),
+  m_stats()
 {
   m_transforms.push_back(Transform());
 }
 
+DrawingContext::~DrawingContext()
+{
+  delete m_submitted.exchange(nullptr);
+}
+
 void
 DrawingContext::push_transform()
 {
@@ -225,20 +639,285 @@ DrawingContext::get_transform()
   return m_transforms.back();
 }
 
+/**
+ * Draws the requests on @p renderer and shows them, from the thread which
+ * records them. Call clear() afterwards to start the next frame.
+ */
 void
 DrawingContext::render(Renderer& renderer)
 {
-  for (const auto& request : m_requests)
-  {
-    request->draw(renderer);
-  }
-  renderer.flush();
+  render_requests(m_requests, target_size, renderer);
+  m_rendered = true;
 }
 
+/** Ends the frame. The requests are kept to be compared with the next ones. */
 void
 DrawingContext::clear()
 {
+  // If the requests weren't rendered, the renderer has something else
+  if (!m_rendered)
+    m_last_renderer = nullptr;
+
+  m_last_requests = std::move(m_requests);
+  m_last_size = target_size;
+  m_requests.clear();
+  m_rendered = false;
+}
+
+/**
+ * Finds the parts of the target which would change if the requests were
+ * rendered now. See the static overload.
+ */
+bool
+DrawingContext::get_damage(std::vector<Rect>& damage) const
+{
+  return get_damage(m_requests, target_size, m_last_requests, m_last_size,
+                    damage);
+}
+
+/**
+ * Hands the requests over to render_submitted(), and starts the next frame.
+ * This never waits: if the last frame submitted wasn't rendered yet, it is
+ * replaced.
+ */
+void
+DrawingContext::submit()
+{
+  auto frame = std::make_unique<Frame>(std::move(m_requests), target_size);
   m_requests.clear();
+
+  delete m_submitted.exchange(frame.release());
+}
+
+/**
+ * Draws the last frame submitted on @p renderer and shows it.
+ *
+ * @returns false if no frame was submitted since the last call.
+ */
+bool
+DrawingContext::render_submitted(Renderer& renderer)
+{
+  std::unique_ptr<Frame> frame(m_submitted.exchange(nullptr));
+
+  if (!frame)
+    return false;
+
+  render_requests(frame->requests, frame->size, renderer);
+
+  m_last_requests = std::move(frame->requests);
+  m_last_size = frame->size;
+  return true;
+}
+
+/**
+ * If the renderer still has the last frame drawn from this context, only the
+ * parts which changed since are drawn again.
+ */
+void
+DrawingContext::render_requests(const Requests& requests, const Size& size,
+                                Renderer& renderer)
+{
+  STM_PROFILE_SCOPE("DrawingContext::render");
+
+  auto start = std::chrono::steady_clock::now();
+  size_t draw_calls = 0;
+
+  if (m_device_lost.exchange(false))
+  {
+    m_targets_lost = false;
+
+    // The renderer stays bound, only its textures are gone
+    auto it = m_renderer_caches.find(&renderer);
+    if (it != m_renderer_caches.end())
+      it->second = std::make_unique<RenderCache>(renderer);
+
+    renderer.reset_targets();
+    m_last_renderer = nullptr;
+  }
+  else if (m_targets_lost.exchange(false))
+  {
+    get_render_cache(&renderer).drop_layers();
+    renderer.reset_targets();
+    m_last_renderer = nullptr;
+  }
+
+  for (const auto& request : requests)
+    request->prepare(renderer);
+
+  std::vector<Rect> damage;
+  bool kept = renderer.start_frame();
+
+  if (kept && m_last_renderer == &renderer
+      && get_damage(requests, size, m_last_requests, m_last_size, damage))
+  {
+    for (const auto& area : damage)
+    {
+      renderer.set_clip_rect(area);
+      renderer.clear();
+
+      for (const auto& request : requests)
+      {
+        Rect bounds;
+
+        if (!request->get_bounds(bounds) || bounds.clipped(area).is_valid())
+        {
+          request->draw(renderer);
+          draw_calls++;
+        }
+      }
+    }
+
+    renderer.reset_clip_rect();
+  }
+  else
+  {
+    if (kept)
+      renderer.clear();
+
+    for (const auto& request : requests)
+    {
+      request->draw(renderer);
+    }
+
+    draw_calls += requests.size();
+  }
+
+  auto drawn = std::chrono::steady_clock::now();
+
+  m_last_renderer = &renderer;
+  renderer.flush();
+
+  auto presented = std::chrono::steady_clock::now();
+
+  auto& cache = get_render_cache(&renderer);
+  cache.drop_unused();
+  size_t texture_bytes = cache.get_texture_bytes();
+
+  std::lock_guard<std::mutex> lock(m_stats_mutex);
+  m_stats.draw_calls = draw_calls;
+  m_stats.draw_sec = std::chrono::duration<float>(drawn - start).count();
+  m_stats.present_sec = std::chrono::duration<float>(presented - drawn).count();
+  m_stats.texture_bytes = texture_bytes;
+}
+
+/** May be called from any thread, while another one renders. */
+DrawingContext::RenderStats
+DrawingContext::get_render_stats() const
+{
+  std::lock_guard<std::mutex> lock(m_stats_mutex);
+  return m_stats;
+}
+
+/**
+ * Finds the parts of the target which look different between two frames:
+ * where requests were added, removed, changed or drawn in another order.
+ *
+ * @param damage Set to non-overlapping rectangles of whole pixels, within
+ *               @p size. Empty if nothing changed.
+ * @returns false if the whole target must be drawn again, either because the
+ *          target was resized or because the changes are too many or can't be
+ *          located.
+ */
+bool
+DrawingContext::get_damage(const Requests& requests, const Size& size,
+                           const Requests& last_requests,
+                           const Size& last_size, std::vector<Rect>& damage)
+{
+  damage.clear();
+
+  if (size != last_size)
+    return false;
+
+  // Positions of the last requests by hash, and the next one to try for each
+  std::unordered_map<uint64_t, std::pair<std::vector<size_t>, size_t>> last;
+
+  for (size_t i = 0; i < last_requests.size(); i++)
+    last[last_requests[i]->get_hash()].first.push_back(i);
+
+  Rect screen(size);
+  std::vector<bool> matched(last_requests.size(), false);
+
+  auto add = [&damage, &screen] (const Request& request) {
+    Rect bounds;
+
+    if (!request.get_bounds(bounds) || damage.size() >= MAX_DAMAGED_REQUESTS)
+      return false;
+
+    // Blending may touch the pixels on the edges
+    bounds = Rect(std::floor(bounds.x1) - 1.0f, std::floor(bounds.y1) - 1.0f,
+                  std::ceil(bounds.x2) + 1.0f, std::ceil(bounds.y2) + 1.0f);
+    bounds.clip(screen);
+
+    if (bounds.is_valid())
+      damage.push_back(bounds);
+
+    return true;
+  };
+
+  // Requests are matched in order; those left over were added, removed, or
+  // moved relatively to the others, and changed how their area looks
+  size_t next = 0;
+
+  for (const auto& request : requests)
+  {
+    auto it = last.find(request->get_hash());
+    bool found = false;
+
+    if (it != last.end())
+    {
+      auto& positions = it->second.first;
+      auto& cursor = it->second.second;
+
+      while (cursor < positions.size() && positions[cursor] < next)
+        cursor++;
+
+      if (cursor < positions.size()
+          && last_requests[positions[cursor]]->equals(*request))
+      {
+        matched[positions[cursor]] = true;
+        next = positions[cursor] + 1;
+        cursor++;
+        found = true;
+      }
+    }
+
+    if (!found && !add(*request))
+      return false;
+  }
+
+  for (size_t i = 0; i < last_requests.size(); i++)
+    if (!matched[i] && !add(*last_requests[i]))
+      return false;
+
+  // Overlapping areas are merged so that nothing is drawn twice. A merged area
+  // is larger and may overlap areas already looked at, hence the passes.
+  bool merged = true;
+
+  while (merged)
+  {
+    merged = false;
+
+    for (size_t i = 0; i < damage.size(); i++)
+    {
+      size_t j = i + 1;
+
+      while (j < damage.size())
+      {
+        if (damage[i].clipped(damage[j]).is_valid())
+        {
+          damage[i] = get_union(damage[i], damage[j]);
+          damage.erase(damage.begin() + j);
+          merged = true;
+        }
+        else
+        {
+          j++;
+        }
+      }
+    }
+  }
+
+  return true;
 }
 
 void
@@ -280,30 +959,74 @@ DrawingContext::draw_text(const std::string& text, const std::string& font,
                           const Rect& dst, const Color& color, Blend blend,
                           bool outline)
 {
-  std::string key = (physfs ? "1-" : "0-") + font + " (" + std::to_string(size)
-                  + ")";
+  Rect dst_ = dst * get_transform().m_scale + get_transform().m_offset;
+  auto req = std::make_unique<TextRequest>(text, font, physfs, size, dst_,
+                                           align, color, blend, outline,
+                                           *this);
 
-  auto it = m_font_cache.find(key);
+  m_requests.push_back(std::move(req));
+}
 
-  if (it == m_font_cache.end())
+/**
+ * Records what @p draw_func draws on this context into a layer rather than in
+ * the frame, with the current transform.
+ */
+std::shared_ptr<const DrawingContext::Layer>
+DrawingContext::record_layer(
+                      const std::function<void(DrawingContext&)>& draw_func)
+{
+  Requests requests;
+  std::swap(requests, m_requests);
+
+  try
   {
-    auto fontinfo = std::make_unique<Font>(font, physfs, size);
-    it = m_font_cache.emplace(key, std::move(fontinfo)).first;
+    draw_func(*this);
+  }
+  catch (...)
+  {
+    std::swap(requests, m_requests);
+    throw;
   }
 
-  auto& font_cache = *(it->second);
+  std::swap(requests, m_requests);
+  return std::make_shared<const Layer>(std::move(requests), target_size);
+}
 
-  Rect dst_ = dst * get_transform().m_scale + get_transform().m_offset;
-  auto req = std::make_unique<TextRequest>(text, font_cache, dst_, align, color,
-                                           blend, outline);
+/**
+ * Draws @p layer, recorded with record_layer(). Its texture is kept as long as
+ * each frame draws the layer.
+ */
+void
+DrawingContext::draw_layer(const std::shared_ptr<const Layer>& layer)
+{
+  Rect dst = Rect(layer->size) * get_transform().m_scale
+             + get_transform().m_offset;
 
-  m_requests.push_back(std::move(req));
+  m_requests.push_back(std::make_unique<LayerRequest>(layer, dst, *this));
 }
 
 void
 DrawingContext::unbind(Renderer* renderer)
 {
   m_renderer_caches.erase(renderer);
+
+  if (m_last_renderer == renderer)
+    m_last_renderer = nullptr;
+}
+
+/**
+ * Makes the next frame render everything again, after SDL reported that the
+ * contents of target textures were lost (SDL_RENDER_TARGETS_RESET), or all
+ * textures if @p device_lost (SDL_RENDER_DEVICE_RESET). May be called from any
+ * thread.
+ */
+void
+DrawingContext::reset_targets(bool device_lost)
+{
+  if (device_lost)
+    m_device_lost = true;
+
+  m_targets_lost = true;
 }
 
 DrawingContext::RenderCache&
@@ -315,6 +1038,27 @@ DrawingContext::get_render_cache(Renderer* renderer)
   {
     auto cache = std::make_unique<RenderCache>(*renderer);
     it = m_renderer_caches.emplace(renderer, std::move(cache)).first;
+
+    // The textures must go before the renderer
+    renderer->bind_lifetime(*this);
+  }
+
+  return *(it->second);
+}
+
+/** Fonts are loaded when rendering, on the thread which renders. */
+Font&
+DrawingContext::get_font(const std::string& font, bool physfs, int size)
+{
+  std::string key = (physfs ? "1-" : "0-") + font + " (" + std::to_string(size)
+                  + ")";
+
+  auto it = m_font_cache.find(key);
+
+  if (it == m_font_cache.end())
+  {
+    auto fontinfo = std::make_unique<Font>(font, physfs, size);
+    it = m_font_cache.emplace(key, std::move(fontinfo)).first;
   }
 
   return *(it->second);
@@ -326,5 +1070,12 @@ DrawingContext::reset()
   m_renderer_caches.clear();
   m_font_cache.clear();
   m_requests.clear();
+  delete m_submitted.exchange(nullptr);
+  m_last_requests.clear();
+  m_last_renderer = nullptr;
+  m_rendered = false;
+
+  // Drawing needs a transform to start with
   m_transforms.clear();
+  m_transforms.push_back(Transform());
 }
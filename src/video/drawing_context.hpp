@@ -17,9 +17,15 @@
 #ifndef HEADER_STM_VIDEO_DRAWINGCONTEXT_HPP
 #define HEADER_STM_VIDEO_DRAWINGCONTEXT_HPP
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "util/color.hpp"
 #include "util/rect.hpp"
@@ -40,12 +46,22 @@ enum class TextAlign
   BOT_RIGHT
 };
 
-// This class has three purposes:
+// This class has five purposes:
 // - Allow drawing out of order
 // - Bufferise the draw requests to render to multiple render targets
 // - Manage the cache for textures, fonts, and other cacheable assets
+// - Find which parts of the screen changed since the last frame, so that
+//   renderers which keep their last frame only draw those again
+// - Record layers once, to be drawn from a texture in later frames
+//
+// Frames may be rendered on another thread than the one recording them: once
+// submit()'ed, the requests belong to the thread calling render_submitted(),
+// which is the only one to use the renderer and the caches.
 class DrawingContext final
 {
+public:
+  class Layer;
+
 private:
   class RenderCache final
   {
@@ -54,10 +70,24 @@ private:
     ~RenderCache() = default;
 
     Texture& get_texture(const std::string& texture, bool physfs);
+    Texture& get_text(const std::string& key, const Font& font,
+                      const std::string& text, float width);
+    Texture& get_layer(const Layer& layer);
+    void drop_layers();
+    void drop_unused();
+    size_t get_texture_bytes() const;
 
   private:
     Renderer& m_renderer;
     std::unordered_map<std::string, std::unique_ptr<Texture>> m_textures;
+    size_t m_texture_bytes;
+    /** Rendered text, by font, size, width and text */
+    std::unordered_map<std::string, std::unique_ptr<Texture>> m_texts;
+    /** Textures of the layers, by id */
+    std::unordered_map<uint64_t, std::unique_ptr<Texture>> m_layers;
+    /** Text and layers drawn since drop_unused() was last called */
+    std::unordered_set<std::string> m_used_texts;
+    std::unordered_set<uint64_t> m_used_layers;
 
   private:
     RenderCache(const RenderCache&) = delete;
@@ -71,6 +101,17 @@ private:
     virtual ~Request() = default;
 
     virtual void draw(Renderer& renderer) const = 0;
+    /** Renders what draw() needs, before the frame is started. */
+    virtual void prepare(Renderer& renderer) const;
+
+    /**
+     * Sets @p bounds to the area of the target this request draws on.
+     *
+     * @returns false if the area can't be known before drawing.
+     */
+    virtual bool get_bounds(Rect& bounds) const = 0;
+    virtual uint64_t get_hash() const = 0;
+    virtual bool equals(const Request& request) const = 0;
 
   private:
     Request(const Request&) = delete;
@@ -85,6 +126,9 @@ private:
     virtual ~RectRequest() = default;
 
     virtual void draw(Renderer& renderer) const override;
+    virtual bool get_bounds(Rect& bounds) const override;
+    virtual uint64_t get_hash() const override;
+    virtual bool equals(const Request& request) const override;
 
   private:
     const Rect m_rect;
@@ -105,6 +149,9 @@ private:
     virtual ~LineRequest() = default;
 
     virtual void draw(Renderer& renderer) const override;
+    virtual bool get_bounds(Rect& bounds) const override;
+    virtual uint64_t get_hash() const override;
+    virtual bool equals(const Request& request) const override;
 
   private:
     const Vector m_p1;
@@ -127,6 +174,9 @@ private:
     virtual ~TextureRequest() = default;
 
     virtual void draw(Renderer& renderer) const override;
+    virtual bool get_bounds(Rect& bounds) const override;
+    virtual uint64_t get_hash() const override;
+    virtual bool equals(const Request& request) const override;
 
   private:
     const std::string m_texture;
@@ -146,26 +196,81 @@ private:
     public Request
   {
   public:
-    TextRequest(const std::string& text, const Font& font, const Rect& dst,
-                TextAlign align, const Color& color, Blend blend, bool outline);
+    TextRequest(const std::string& text, const std::string& font, bool physfs,
+                int size, const Rect& dst, TextAlign align, const Color& color,
+                Blend blend, bool outline, DrawingContext& context);
     virtual ~TextRequest() = default;
 
     virtual void draw(Renderer& renderer) const override;
+    virtual void prepare(Renderer& renderer) const override;
+    virtual bool get_bounds(Rect& bounds) const override;
+    virtual uint64_t get_hash() const override;
+    virtual bool equals(const Request& request) const override;
+
+  private:
+    Texture& get_texture(Renderer& renderer) const;
+    Rect get_dst(const Size& texture_size) const;
 
   private:
     const std::string m_text;
-    const Font& m_font;
+    const std::string m_font;
+    const bool m_physfs;
+    const int m_size;
     const Rect m_dst;
     const TextAlign m_align;
     const Color m_color;
     const Blend m_blend;
     const bool m_outline;
+    DrawingContext& m_context;
+    /** Where the text was drawn, known once prepared */
+    mutable Rect m_bounds;
+    mutable bool m_prepared;
 
   private:
     TextRequest(const TextRequest&) = delete;
     TextRequest& operator=(const TextRequest&) = delete;
   };
 
+  class LayerRequest final :
+    public Request
+  {
+  public:
+    LayerRequest(std::shared_ptr<const Layer> layer, const Rect& dst,
+                 DrawingContext& context);
+    virtual ~LayerRequest() = default;
+
+    virtual void draw(Renderer& renderer) const override;
+    virtual void prepare(Renderer& renderer) const override;
+    virtual bool get_bounds(Rect& bounds) const override;
+    virtual uint64_t get_hash() const override;
+    virtual bool equals(const Request& request) const override;
+
+  private:
+    const std::shared_ptr<const Layer> m_layer;
+    const Rect m_dst;
+    DrawingContext& m_context;
+
+  private:
+    LayerRequest(const LayerRequest&) = delete;
+    LayerRequest& operator=(const LayerRequest&) = delete;
+  };
+
+  typedef std::vector<std::unique_ptr<Request>> Requests;
+
+  class Frame final
+  {
+  public:
+    Frame(Requests frame_requests, const Size& frame_size);
+
+  public:
+    Requests requests;
+    Size size;
+
+  private:
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+  };
+
   class Transform final
   {
     friend class DrawingContext;
@@ -185,9 +290,48 @@ private:
     Size m_scale;
   };
 
+public:
+  /**
+   * Requests recorded once, which can then be drawn in any number of frames.
+   * They are rendered to a texture the first time, which later frames copy.
+   */
+  class Layer final
+  {
+  public:
+    Layer(Requests layer_requests, const Size& layer_size);
+
+  public:
+    const Requests requests;
+    /** The target size when the layer was recorded */
+    const Size size;
+    /** Unique to this layer, never reused */
+    const uint64_t id;
+
+  private:
+    Layer(const Layer&) = delete;
+    Layer& operator=(const Layer&) = delete;
+  };
+
+  /** What rendering the last frame took */
+  class RenderStats final
+  {
+  public:
+    RenderStats();
+
+  public:
+    /** Requests drawn, once per damaged area they overlap */
+    size_t draw_calls;
+    /** Time spent drawing the requests, in seconds */
+    float draw_sec;
+    /** Time spent copying the frame to the window and presenting it */
+    float present_sec;
+    /** Estimated memory used by the cached textures */
+    size_t texture_bytes;
+  };
+
 public:
   DrawingContext();
-  ~DrawingContext() = default;
+  ~DrawingContext();
 
   void push_transform();
   void pop_transform();
@@ -195,6 +339,11 @@ public:
 
   void render(Renderer& renderer);
   void clear();
+  bool get_damage(std::vector<Rect>& damage) const;
+
+  void submit();
+  bool render_submitted(Renderer& renderer);
+  RenderStats get_render_stats() const;
 
   void draw_filled_rect(const Rect& rect, const Color& color, Blend blend);
   void draw_line(const Vector& p1, const Vector& p2, const Color& color,
@@ -205,22 +354,55 @@ public:
                  int size, TextAlign align, const Rect& dst, const Color& color,
                  Blend blend, bool outline = true);
 
+  std::shared_ptr<const Layer> record_layer(
+                      const std::function<void(DrawingContext&)>& draw_func);
+  void draw_layer(const std::shared_ptr<const Layer>& layer);
+
   // This function is usually called from the dtor of the Renderer, but can
   // safely be called at any time.
   void unbind(Renderer* renderer);
+  void reset_targets(bool device_lost);
 
   void reset();
 
   RenderCache& get_render_cache(Renderer* renderer);
 
+private:
+  static bool get_damage(const Requests& requests, const Size& size,
+                         const Requests& last_requests, const Size& last_size,
+                         std::vector<Rect>& damage);
+
+  void render_requests(const Requests& requests, const Size& size,
+                       Renderer& renderer);
+  Font& get_font(const std::string& font, bool physfs, int size);
+
 public:
   Size target_size;
+  /**
+   * Time since the last update, as a fraction of an update. Drawing objects
+   * between their two last positions by this much makes motion smooth when
+   * drawing more often than updating.
+   */
+  float alpha;
 
 private:
-  std::vector<std::unique_ptr<Request>> m_requests;
+  Requests m_requests;
+  /** Frame waiting to be rendered, if any */
+  std::atomic<Frame*> m_submitted;
+  /** Requests of the last frame, to find what changed since */
+  Requests m_last_requests;
+  Size m_last_size;
+  /** The renderer which drew the last frame, if any */
+  Renderer* m_last_renderer;
+  bool m_rendered;
+  /** Set by reset_targets(), handled by the thread which renders */
+  std::atomic<bool> m_targets_lost;
+  std::atomic<bool> m_device_lost;
   std::unordered_map<Renderer*, std::unique_ptr<RenderCache>> m_renderer_caches;
   std::unordered_map<std::string, std::unique_ptr<Font>> m_font_cache;
   std::vector<Transform> m_transforms;
+  mutable std::mutex m_stats_mutex;
+  RenderStats m_stats;
 
 private:
   DrawingContext(const DrawingContext&) = delete;
@@ -0,0 +1,167 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "video/render_thread.hpp"
+
+#include "SDL2/SDL.h"
+
+#include "util/profiler.hpp"
+
+/** @p window and @p context must outlive this object. */
+RenderThread::RenderThread(Window& window, DrawingContext& context) :
+  m_window(window),
+  m_context(context)
+#ifdef STM_RENDER_THREAD
+  ,
+  m_mutex(),
+  m_cond(),
+  m_busy(false),
+  m_quit(false),
+  m_error(),
+  m_thread()
+#endif
+{
+#ifdef STM_RENDER_THREAD
+  m_thread = std::thread([this] { this->run(); });
+#endif
+}
+
+/** Waits for the frame being rendered, if any, and stops the thread. */
+RenderThread::~RenderThread()
+{
+#ifdef STM_RENDER_THREAD
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+
+  m_cond.notify_all();
+  m_thread.join();
+#else
+  m_window.destroy_renderer();
+#endif
+}
+
+/**
+ * Hands the frame recorded in the context over to be rendered. Waits for the
+ * previous frame to be presented first, so that at most one frame is ahead.
+ * The events are pumped in between, while nothing is being rendered.
+ *
+ * @throws Whatever rendering the previous frame threw.
+ */
+void
+RenderThread::submit()
+{
+#ifdef STM_RENDER_THREAD
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cond.wait(lock, [this] { return !this->m_busy; });
+
+  if (m_error)
+  {
+    // The thread is idle, the recorded frame can be dropped from here
+    m_context.clear();
+
+    auto error = m_error;
+    m_error = nullptr;
+    std::rethrow_exception(error);
+  }
+
+  SDL_PumpEvents();
+
+  m_context.submit();
+  m_busy = true;
+
+  lock.unlock();
+  m_cond.notify_all();
+#else
+  m_context.submit();
+  m_context.render_submitted(m_window.get_renderer());
+#endif
+}
+
+/**
+ * Gathers the pending events into SDL's queue, unless a frame is being
+ * rendered; they are then pumped when the next frame is submitted.
+ */
+void
+RenderThread::pump_events()
+{
+#ifdef STM_RENDER_THREAD
+  // Only submit() starts rendering, so the thread stays idle while pumping
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!m_busy)
+    SDL_PumpEvents();
+#else
+  SDL_PumpEvents();
+#endif
+}
+
+/**
+ * Waits until an event is in SDL's queue, or for @p timeout_ms at most. Waits
+ * for the frame being rendered, if any, first.
+ */
+void
+RenderThread::wait_events(int timeout_ms)
+{
+#ifdef STM_RENDER_THREAD
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cond.wait(lock, [this] { return !this->m_busy; });
+#endif
+
+  SDL_WaitEventTimeout(nullptr, timeout_ms);
+}
+
+void
+RenderThread::run()
+{
+#ifdef STM_RENDER_THREAD
+  Profiler::set_thread_name("Render");
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (true)
+  {
+    m_cond.wait(lock, [this] { return this->m_busy || this->m_quit; });
+
+    if (!m_busy)
+      break;
+
+    lock.unlock();
+
+    std::exception_ptr error;
+
+    try
+    {
+      m_context.render_submitted(m_window.get_renderer());
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+    m_error = error;
+    m_busy = false;
+    m_cond.notify_all();
+  }
+
+  lock.unlock();
+
+  // SDL renderers must be destroyed by the thread which used them
+  m_window.destroy_renderer();
+#endif
+}
@@ -0,0 +1,81 @@
+//  SuperTux Meltdown - Semphris' take on the popular Linux platformer
+//  Copyright (C) 2022 Semphris <semphris@semphris.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HEADER_STM_VIDEO_RENDERTHREAD_HPP
+#define HEADER_STM_VIDEO_RENDERTHREAD_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "video/drawing_context.hpp"
+#include "video/window.hpp"
+
+// Browsers have no threads to spare, and macOS only lets the main thread draw
+#if !defined(EMSCRIPTEN) && !defined(__APPLE__)
+#define STM_RENDER_THREAD
+#endif
+
+/**
+ * Renders the frames recorded in a DrawingContext on a thread of its own, so
+ * that the game handles events and records the next frame while the last one
+ * is drawn and presented. Only that thread uses the renderer of the window.
+ *
+ * SDL renderers watch the events of their window, and update themselves when
+ * the events are pumped, which happens on the thread handling events. Events
+ * must thus only be pumped through pump_events() and wait_events(), which make
+ * sure no frame is being rendered meanwhile, and then read with
+ * SDL_PeepEvents(), which doesn't pump them. For the same reason, the window
+ * must not be changed while frames are rendered. This is known to work with
+ * the Direct3D, OpenGL and software renderers on Windows, X11 and Wayland;
+ * macOS, where only the main thread may draw, renders on the main thread.
+ *
+ * Where there can't be such a thread, frames are rendered when submitted.
+ */
+class RenderThread final
+{
+public:
+  RenderThread(Window& window, DrawingContext& context);
+  ~RenderThread();
+
+  void submit();
+  void pump_events();
+  void wait_events(int timeout_ms);
+
+private:
+  void run();
+
+private:
+  Window& m_window;
+  DrawingContext& m_context;
+#ifdef STM_RENDER_THREAD
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  /** Whether a frame was submitted and isn't presented yet */
+  bool m_busy;
+  bool m_quit;
+  /** What the last frame threw, to be rethrown by the next submit() */
+  std::exception_ptr m_error;
+  std::thread m_thread;
+#endif
+
+private:
+  RenderThread(const RenderThread&) = delete;
+  RenderThread& operator=(const RenderThread&) = delete;
+};
+
+#endif
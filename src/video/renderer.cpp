@@ -16,9 +16,11 @@
 
 #include "video/renderer.hpp"
 
+#include <cmath>
 #include <stdexcept>
 
 #include "util/color.hpp"
+#include "util/log.hpp"
 #include "util/rect.hpp"
 #include "util/vector.hpp"
 #include "video/drawing_context.hpp"
@@ -32,35 +34,189 @@
 #define SDL_RenderCopyExF SDL_RenderCopyEx
 #endif
 
+/**
+ * Returns the SDL blend mode for @p blend. SDL has no constant for blending
+ * premultiplied colors, it is made from blend factors.
+ */
+static SDL_BlendMode
+get_sdl_blend_mode(Blend blend)
+{
+  if (blend != Blend::PREMULTIPLIED)
+    return static_cast<SDL_BlendMode>(blend);
+
+  return SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE,
+                                    SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                                    SDL_BLENDOPERATION_ADD,
+                                    SDL_BLENDFACTOR_ONE,
+                                    SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                                    SDL_BLENDOPERATION_ADD);
+}
+
 Renderer::Renderer(const Window& window) :
-  m_sdl_renderer(SDL_CreateRenderer(window.get_sdl_window(), -1, 0))
+  m_sdl_renderer(SDL_CreateRenderer(window.get_sdl_window(), -1, 0)),
+  m_bound_contexts(),
+  m_buffered(false),
+  m_back_buffer(nullptr),
+  m_buffer_width(0),
+  m_buffer_height(0)
 {
   if (!m_sdl_renderer)
   {
     throw std::runtime_error("Can't create renderer: "
                              + std::string(SDL_GetError()));
   }
+
+  // Drawing is cheap enough on the GPU to draw whole frames, but not on the
+  // CPU, where keeping the last frame allows drawing only what changed
+  SDL_RendererInfo info;
+
+  if (SDL_GetRendererInfo(m_sdl_renderer, &info) == 0)
+  {
+    m_buffered = (info.flags & SDL_RENDERER_SOFTWARE)
+                 && (info.flags & SDL_RENDERER_TARGETTEXTURE);
+  }
 }
 
 Renderer::~Renderer()
 {
+  // The contexts' textures belong to this renderer and must be freed first
+  for (auto* context : m_bound_contexts)
+  {
+    context->unbind(this);
+  }
+
+  if (m_back_buffer)
+    SDL_DestroyTexture(m_back_buffer);
+
   if (m_sdl_renderer)
     SDL_DestroyRenderer(m_sdl_renderer);
+}
 
-  for (auto* context : m_bound_contexts)
+/**
+ * Prepares drawing a frame.
+ *
+ * @returns true if the target still holds the last frame, so that only the
+ *          parts which changed need to be drawn again. If false, the target is
+ *          blank.
+ */
+bool
+Renderer::start_frame()
+{
+  if (!m_buffered)
+    return false;
+
+  int width, height;
+
+  if (SDL_GetRendererOutputSize(m_sdl_renderer, &width, &height))
+    return false;
+
+  if (m_back_buffer && width == m_buffer_width && height == m_buffer_height)
+    return SDL_SetRenderTarget(m_sdl_renderer, m_back_buffer) == 0;
+
+  // The window was resized, or this is the first frame
+  if (m_back_buffer)
+    SDL_DestroyTexture(m_back_buffer);
+
+  m_back_buffer = SDL_CreateTexture(m_sdl_renderer, SDL_PIXELFORMAT_ARGB8888,
+                                    SDL_TEXTUREACCESS_TARGET, width, height);
+
+  if (!m_back_buffer || SDL_SetRenderTarget(m_sdl_renderer, m_back_buffer))
   {
-    context->unbind(this);
+    log_warning << "Can't keep frames, drawing them whole instead: "
+                << SDL_GetError() << std::endl;
+
+    if (m_back_buffer)
+      SDL_DestroyTexture(m_back_buffer);
+
+    m_back_buffer = nullptr;
+    m_buffered = false;
+    SDL_SetRenderTarget(m_sdl_renderer, nullptr);
+    return false;
   }
+
+  SDL_SetTextureBlendMode(m_back_buffer, SDL_BLENDMODE_NONE);
+  m_buffer_width = width;
+  m_buffer_height = height;
+  clear();
+
+  return false;
 }
 
+/** Shows the frame on the window. */
 void
 Renderer::flush()
 {
+  if (m_back_buffer)
+  {
+    // The back buffer is left as is for the next frame to draw over it
+    SDL_SetRenderTarget(m_sdl_renderer, nullptr);
+    SDL_RenderCopy(m_sdl_renderer, m_back_buffer, nullptr, nullptr);
+    SDL_RenderPresent(m_sdl_renderer);
+    return;
+  }
+
   SDL_RenderPresent(m_sdl_renderer);
   SDL_SetRenderDrawColor(m_sdl_renderer, 0, 0, 0, 0);
   SDL_RenderClear(m_sdl_renderer);
 }
 
+/** Fills the clip rectangle, or the whole target if there is none, in black. */
+void
+Renderer::clear()
+{
+  // Unlike filling, SDL_RenderClear() ignores the clip rectangle
+  SDL_SetRenderDrawColor(m_sdl_renderer, 0, 0, 0, 0);
+  SDL_SetRenderDrawBlendMode(m_sdl_renderer, SDL_BLENDMODE_NONE);
+  SDL_RenderFillRect(m_sdl_renderer, nullptr);
+}
+
+/** Restricts drawing to the whole pixels covered by @p rect. */
+void
+Renderer::set_clip_rect(const Rect& rect)
+{
+  SDL_Rect sdl_rect;
+  sdl_rect.x = static_cast<int>(std::floor(rect.x1));
+  sdl_rect.y = static_cast<int>(std::floor(rect.y1));
+  sdl_rect.w = static_cast<int>(std::ceil(rect.x2)) - sdl_rect.x;
+  sdl_rect.h = static_cast<int>(std::ceil(rect.y2)) - sdl_rect.y;
+
+  SDL_RenderSetClipRect(m_sdl_renderer, &sdl_rect);
+}
+
+void
+Renderer::reset_clip_rect()
+{
+  SDL_RenderSetClipRect(m_sdl_renderer, nullptr);
+}
+
+/**
+ * Draws on @p texture, which must have been made as a target, or on the frame
+ * again if null. Changing the target resets the clip rectangle.
+ */
+void
+Renderer::set_target(Texture* texture)
+{
+  if (SDL_SetRenderTarget(m_sdl_renderer, texture ? texture->get_sdl_texture()
+                                                  : m_back_buffer))
+  {
+    throw std::runtime_error("Can't change render target: "
+                             + std::string(SDL_GetError()));
+  }
+}
+
+/**
+ * Forgets the last frame, for when the contents of target textures were lost.
+ * The next call to start_frame() makes a new back buffer and returns false.
+ */
+void
+Renderer::reset_targets()
+{
+  if (m_back_buffer)
+    SDL_DestroyTexture(m_back_buffer);
+
+  m_back_buffer = nullptr;
+}
+
 void
 Renderer::draw_filled_rect(const Rect& rect, const Color& color, Blend blend)
 {
@@ -70,7 +226,7 @@ Renderer::draw_filled_rect(const Rect& rect, const Color& color, Blend blend)
                          static_cast<Uint8>(color.b * 255.f),
                          static_cast<Uint8>(color.a * 255.f));
 
-  SDL_SetRenderDrawBlendMode(m_sdl_renderer, static_cast<SDL_BlendMode>(blend));
+  SDL_SetRenderDrawBlendMode(m_sdl_renderer, get_sdl_blend_mode(blend));
 
   SDL_FRect sdl_rect;
   sdl_rect.x = rect.x1;
@@ -91,7 +247,7 @@ Renderer::draw_line(const Vector& p1, const Vector& p2, const Color& color,
                          static_cast<Uint8>(color.b * 255.f),
                          static_cast<Uint8>(color.a * 255.f));
 
-  SDL_SetRenderDrawBlendMode(m_sdl_renderer, static_cast<SDL_BlendMode>(blend));
+  SDL_SetRenderDrawBlendMode(m_sdl_renderer, get_sdl_blend_mode(blend));
 
   SDL_RenderDrawLineF(m_sdl_renderer, p1.x, p1.y, p2.x, p2.y);
 }
@@ -108,8 +264,14 @@ Renderer::draw_texture(const Texture& texture, const Rect& src, const Rect& dst,
   SDL_SetTextureAlphaMod(texture.get_sdl_texture(),
                          static_cast<Uint8>(color.a * 255.f));
 
-  SDL_SetTextureBlendMode(texture.get_sdl_texture(),
-                          static_cast<SDL_BlendMode>(blend));
+  // Renderers without custom blend modes only get close to premultiplied
+  // blending; colors drawn translucent come out darker
+  if (SDL_SetTextureBlendMode(texture.get_sdl_texture(),
+                              get_sdl_blend_mode(blend))
+      && blend == Blend::PREMULTIPLIED)
+  {
+    SDL_SetTextureBlendMode(texture.get_sdl_texture(), SDL_BLENDMODE_BLEND);
+  }
 
   SDL_Rect s;
   SDL_FRect d;
@@ -33,7 +33,9 @@ enum class Blend
   NONE = SDL_BLENDMODE_NONE,
   BLEND = SDL_BLENDMODE_BLEND,
   ADD = SDL_BLENDMODE_ADD,
-  MODULATE = SDL_BLENDMODE_MOD
+  MODULATE = SDL_BLENDMODE_MOD,
+  /** Like BLEND, for textures whose colors are premultiplied by their alpha */
+  PREMULTIPLIED = 0x100
 };
 
 class Renderer final
@@ -42,7 +44,14 @@ public:
   Renderer(const Window& window);
   ~Renderer();
 
+  bool start_frame();
   void flush();
+  void clear();
+
+  void set_clip_rect(const Rect& rect);
+  void reset_clip_rect();
+  void set_target(Texture* texture);
+  void reset_targets();
 
   void draw_filled_rect(const Rect& rect, const Color& color, Blend blend);
   void draw_line(const Vector& p1, const Vector& p2, const Color& color,
@@ -57,6 +66,11 @@ public:
 private:
   SDL_Renderer* m_sdl_renderer;
   std::vector<DrawingContext*> m_bound_contexts;
+  /** Whether frames are drawn on m_back_buffer, which keeps them */
+  bool m_buffered;
+  SDL_Texture* m_back_buffer;
+  int m_buffer_width;
+  int m_buffer_height;
 
 private:
   Renderer(const Renderer&) = delete;
@@ -19,6 +19,7 @@
 #include "SDL2/SDL_image.h"
 
 #include "util/fs.hpp"
+#include "util/profiler.hpp"
 #include "video/renderer.hpp"
 
 Texture::Texture(Renderer& renderer, const std::string& file, bool physfs) :
@@ -27,6 +28,8 @@ Texture::Texture(Renderer& renderer, const std::string& file, bool physfs) :
   m_drawable(false),
   m_cached_size()
 {
+  STM_PROFILE_SCOPE("Texture::load");
+
   SDL_Surface* surface = nullptr;
 
   if (physfs)
@@ -62,7 +65,8 @@ Texture::Texture(Renderer& renderer, const std::string& file, bool physfs) :
 
 Texture::Texture(Renderer& renderer, const Size& size) :
   m_renderer(renderer),
-  m_sdl_texture(SDL_CreateTexture(renderer.get_sdl_renderer(), 0,
+  m_sdl_texture(SDL_CreateTexture(renderer.get_sdl_renderer(),
+                                  SDL_PIXELFORMAT_ARGB8888,
                                   SDL_TEXTUREACCESS_TARGET,
                                   static_cast<int>(size.w),
                                   static_cast<int>(size.h))),
@@ -74,6 +78,9 @@ Texture::Texture(Renderer& renderer, const Size& size) :
     throw std::runtime_error("Can't create texture: "
                              + std::string(SDL_GetError()));
   }
+
+  // Transparent parts show what the texture is drawn over
+  SDL_SetTextureBlendMode(m_sdl_texture, SDL_BLENDMODE_BLEND);
 }
 
 Texture::Texture(Renderer& renderer, SDL_Surface* surface, bool free_surface) :
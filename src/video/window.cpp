@@ -21,7 +21,7 @@
 Window::Window() :
   m_sdl_window(SDL_CreateWindow("", SDL_WINDOWPOS_UNDEFINED,
                                 SDL_WINDOWPOS_UNDEFINED, 640, 400, 0)),
-  m_renderer(*this)
+  m_renderer()
 {
   if (!m_sdl_window)
   {
@@ -32,6 +32,8 @@ Window::Window() :
 
 Window::~Window()
 {
+  destroy_renderer();
+
   if (m_sdl_window)
     SDL_DestroyWindow(m_sdl_window);
 }
@@ -236,10 +238,24 @@ Window::set_visible(bool visible)
   }
 }
 
+/**
+ * Returns the renderer of the window, creating it if needed. SDL renderers
+ * should only be used by one thread: the one which called this first, until
+ * it calls destroy_renderer().
+ */
 Renderer&
 Window::get_renderer()
 {
-  return m_renderer;
+  if (!m_renderer)
+    m_renderer = std::make_unique<Renderer>(*this);
+
+  return *m_renderer;
+}
+
+void
+Window::destroy_renderer()
+{
+  m_renderer.reset();
 }
 
 SDL_Window*
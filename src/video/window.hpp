@@ -17,6 +17,8 @@
 #ifndef HEADER_STM_VIDEO_WINDOW_HPP
 #define HEADER_STM_VIDEO_WINDOW_HPP
 
+#include <memory>
+
 #include "SDL2/SDL.h"
 
 #include "util/size.hpp"
@@ -57,12 +59,13 @@ public:
   void set_visible(bool visible);
 
   Renderer& get_renderer();
+  void destroy_renderer();
 
   SDL_Window* get_sdl_window() const;
 
 private:
   SDL_Window* m_sdl_window;
-  Renderer m_renderer;
+  std::unique_ptr<Renderer> m_renderer;
 
 private:
   Window(const Window&) = delete;